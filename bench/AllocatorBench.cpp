@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/SharedSmall.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/Small.h>
+
+using namespace Afina::Allocator;
+
+// Operation of the workload: which live slot to touch and how big the new block is
+struct op {
+    size_t index;
+    size_t size;
+};
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Every op frees block in the slot, if there is one, and allocates a new one there
+static void RunSimple(const std::vector<op> &ops, size_t live, size_t arena_size) {
+    std::vector<char> arena(arena_size);
+    Simple a(arena.data(), arena.size());
+    std::vector<Pointer> slots(live);
+
+    size_t failures = 0, defrags = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &o : ops) {
+        a.free(slots[o.index]);
+        try {
+            slots[o.index] = a.alloc(o.size);
+        } catch (AllocError &) {
+            // Fragmented: compact and retry once
+            a.defrag();
+            defrags++;
+            try {
+                slots[o.index] = a.alloc(o.size);
+            } catch (AllocError &) {
+                failures++;
+            }
+        }
+    }
+    double time = Seconds(start);
+
+    std::printf("Simple: %8.0f ns/op, %zu defrags, %zu failures\n", time * 1e9 / ops.size(), defrags, failures);
+}
+
+static void RunSmall(const std::vector<op> &ops, size_t live) {
+    Small a;
+    std::vector<std::pair<void *, size_t>> slots(live, std::make_pair(nullptr, 0));
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &o : ops) {
+        Small::Free(slots[o.index].first, slots[o.index].second);
+        slots[o.index] = std::make_pair(a.Alloc(o.size), o.size);
+    }
+    double time = Seconds(start);
+
+    for (auto &p : slots) {
+        Small::Free(p.first, p.second);
+    }
+    std::printf("Small:  %8.0f ns/op, %zu bytes mapped\n", time * 1e9 / ops.size(), a.Mapped());
+}
+
+static void RunMalloc(const std::vector<op> &ops, size_t live) {
+    std::vector<void *> slots(live, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &o : ops) {
+        std::free(slots[o.index]);
+        slots[o.index] = std::malloc(o.size);
+    }
+    double time = Seconds(start);
+
+    for (auto p : slots) {
+        std::free(p);
+    }
+    std::printf("malloc: %8.0f ns/op\n", time * 1e9 / ops.size());
+}
+
+// Runs the same workload in several threads, each on its own slots, with given alloc and free
+template <typename Alloc, typename Free>
+static void RunThreads(const char *name, const std::vector<op> &ops, size_t live, size_t threads_count, Alloc alloc,
+                       Free free) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; t++) {
+        threads.emplace_back([&] {
+            std::vector<std::pair<void *, size_t>> slots(live, std::make_pair(nullptr, 0));
+            for (auto &o : ops) {
+                free(slots[o.index].first, slots[o.index].second);
+                slots[o.index] = std::make_pair(alloc(o.size), o.size);
+            }
+            for (auto &p : slots) {
+                free(p.first, p.second);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double time = Seconds(start);
+
+    std::printf("%s: %8.0f ns/op\n", name, time * 1e9 / (ops.size() * threads_count));
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rnd(42);
+
+    // Small and medium blocks, roughly what the cache keeps for keys and values
+    const size_t count = 2000000;
+    std::vector<op> ops(count);
+    for (size_t live : {1000, 10000}) {
+        for (auto &o : ops) {
+            o.index = rnd() % live;
+            o.size = 16 + rnd() % (rnd() % 8 == 0 ? 4096 : 256);
+        }
+
+        // Arena is about twice the expected live size, so fragmentation matters
+        std::printf("live blocks %zu:\n", live);
+        RunSimple(ops, live, live * 1200);
+        RunSmall(ops, live);
+        RunMalloc(ops, live);
+    }
+
+    // Storage stripes share one allocator, compare it with the single lock around Small
+    const size_t threads_count = 4;
+    ops.resize(count / threads_count);
+    std::printf("%zu threads, live blocks 10000 each:\n", threads_count);
+    {
+        SharedSmall a;
+        RunThreads("SharedSmall ", ops, 10000, threads_count, [&a](size_t size) { return a.Alloc(size); },
+                   [&a](void *ptr, size_t size) { a.Free(ptr, size); });
+    }
+    {
+        Small a;
+        std::mutex mutex;
+        RunThreads("Small+mutex ", ops, 10000, threads_count,
+                   [&](size_t size) {
+                       std::lock_guard<std::mutex> lock(mutex);
+                       return a.Alloc(size);
+                   },
+                   [&](void *ptr, size_t size) {
+                       std::lock_guard<std::mutex> lock(mutex);
+                       Small::Free(ptr, size);
+                   });
+    }
+    RunThreads("malloc      ", ops, 10000, threads_count, [](size_t size) { return std::malloc(size); },
+               [](void *ptr, size_t) { std::free(ptr); });
+    return 0;
+}
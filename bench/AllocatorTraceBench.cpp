@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/Small.h>
+
+using namespace Afina::Allocator;
+
+// Single step of the trace: what to do with the slot
+struct event {
+    enum kind_t : uint8_t { Alloc, Realloc, Free } kind;
+    uint32_t slot;
+    uint32_t size;
+};
+
+struct trace {
+    std::string name;
+    size_t slots;
+    size_t peak_live;
+    std::vector<event> events;
+
+    // Events before the final cleanup, that is where fragmentation is sampled
+    size_t body;
+};
+
+// Zipf distributed rank in [0, n), precomputed CDF
+class zipf {
+public:
+    zipf(size_t n, double s) : _cdf(n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(double(i + 1), s);
+            _cdf[i] = sum;
+        }
+        for (auto &c : _cdf) {
+            c /= sum;
+        }
+    }
+
+    template <typename R> size_t operator()(R &rnd) {
+        double x = std::uniform_real_distribution<double>(0, 1)(rnd);
+        return std::lower_bound(_cdf.begin(), _cdf.end(), x) - _cdf.begin();
+    }
+
+private:
+    std::vector<double> _cdf;
+};
+
+// Keeps track of slot sizes while trace is built, so that the peak of live bytes is known
+class builder {
+public:
+    builder(const std::string &name, size_t slots) : _sizes(slots, 0), _live(0) {
+        _trace.name = name;
+        _trace.slots = slots;
+        _trace.peak_live = 0;
+    }
+
+    size_t Size(size_t slot) const { return _sizes[slot]; }
+
+    void Set(size_t slot, size_t size) {
+        if (_sizes[slot] != 0) {
+            Put(event::Free, slot, 0);
+        }
+        Put(event::Alloc, slot, size);
+    }
+
+    void Grow(size_t slot, size_t size) { Put(event::Realloc, slot, size); }
+
+    void Free(size_t slot) {
+        if (_sizes[slot] != 0) {
+            Put(event::Free, slot, 0);
+        }
+    }
+
+    trace Build() {
+        _trace.body = _trace.events.size();
+        for (size_t slot = 0; slot < _sizes.size(); slot++) {
+            Free(slot);
+        }
+        return std::move(_trace);
+    }
+
+private:
+    void Put(event::kind_t kind, size_t slot, size_t size) {
+        _live = _live - _sizes[slot] + size;
+        _sizes[slot] = size;
+        _trace.peak_live = std::max(_trace.peak_live, _live);
+        _trace.events.push_back(event{kind, uint32_t(slot), uint32_t(size)});
+    }
+
+    trace _trace;
+    std::vector<size_t> _sizes;
+    size_t _live;
+};
+
+// Cache steady state: keys are replaced by the new values, sizes follow Zipf over 32 byte steps, so there
+// are lots of small values and a long tail up to 32K
+static trace ZipfTrace(size_t slots, size_t count) {
+    std::mt19937 rnd(1);
+    zipf sizes(1024, 1.1);
+    builder b("zipf", slots);
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = rnd() % slots;
+        if (rnd() % 8 == 0) {
+            b.Free(slot);
+        } else {
+            b.Set(slot, 16 + 32 * sizes(rnd) + rnd() % 32);
+        }
+    }
+    return b.Build();
+}
+
+// Workload changes: first half of the trace keeps small values, the second one replaces them with the
+// values ten times bigger, memory given to the small ones should serve the big ones
+static trace ChurnTrace(size_t slots, size_t count) {
+    std::mt19937 rnd(2);
+    builder b("churn", slots);
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = rnd() % slots;
+        size_t size = i < count / 2 ? 64 + rnd() % 128 : 640 + rnd() % 1280;
+
+        // Live bytes stay about the same: bigger values, fewer of them
+        if (i >= count / 2 && slot % 10 != 0) {
+            b.Free(slot);
+        } else {
+            b.Set(slot, size);
+        }
+    }
+    return b.Build();
+}
+
+// Values growing by appends, the way lists and counters in the cache do, until they are dropped
+static trace AppendTrace(size_t slots, size_t count) {
+    std::mt19937 rnd(3);
+    builder b("append", slots);
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = rnd() % slots;
+        size_t size = b.Size(slot);
+        if (size == 0 || size > 16 * 1024) {
+            b.Set(slot, 64);
+        } else {
+            b.Grow(slot, size + 64 + rnd() % 448);
+        }
+    }
+    return b.Build();
+}
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Field of /proc/self/status in KB
+static long StatusKb(const char *field) {
+    long value = 0;
+    FILE *f = std::fopen("/proc/self/status", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    char line[256];
+    size_t len = std::strlen(field);
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        if (std::strncmp(line, field, len) == 0 && line[len] == ':') {
+            value = std::atol(line + len + 1);
+            break;
+        }
+    }
+    std::fclose(f);
+    return value;
+}
+
+// Forked process inherits the peak of its parent, it is brought down to the current RSS. Free heap of the
+// parent is resident too, it is given back first, so that malloc doesn't get it for free
+static void ResetPeakRss() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    FILE *f = std::fopen("/proc/self/clear_refs", "w");
+    if (f != nullptr) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+}
+
+// Replays trace against the allocator, samples fragmentation: share of resident memory grown since rss
+// that doesn't hold live data. RSS is what all three allocators could be compared by: memory of the freed
+// blocks counts as long as it is not given back to the system
+template <typename Backend> static void Replay(const trace &t, Backend &backend, long rss) {
+    const size_t samples = 8;
+    std::vector<double> fragmentation;
+    size_t live = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < t.events.size(); i++) {
+        const event &e = t.events[i];
+        switch (e.kind) {
+        case event::Alloc:
+            backend.Alloc(e.slot, e.size);
+            live += e.size;
+            break;
+        case event::Realloc:
+            live = live - backend.Size(e.slot) + e.size;
+            backend.Realloc(e.slot, e.size);
+            break;
+        case event::Free:
+            live -= backend.Size(e.slot);
+            backend.Free(e.slot);
+            break;
+        }
+
+        if ((i + 1) % (t.body / samples) == 0 && fragmentation.size() < samples) {
+            size_t footprint = size_t(StatusKb("VmRSS") - rss) * 1024;
+            fragmentation.push_back(footprint == 0 || live > footprint ? 0 : 1.0 - double(live) / footprint);
+        }
+    }
+    double time = Seconds(start);
+
+    std::printf("  %-7s %6.2f Mops/s, peak rss %7ld KB, fragmentation", backend.Name(),
+                t.events.size() / time / 1e6, StatusKb("VmHWM") - rss);
+    for (double f : fragmentation) {
+        std::printf(" %.2f", f);
+    }
+    std::printf("%s\n", backend.Notes().c_str());
+}
+
+// Blocks are filled on allocation and on growth, so that resident memory is what it would be in the cache
+static void Fill(void *ptr, size_t from, size_t to) { std::memset(static_cast<char *>(ptr) + from, 'x', to - from); }
+
+class SimpleBackend {
+public:
+    SimpleBackend(size_t slots, size_t area)
+        : _area(new char[area]), _a(_area.get(), area), _slots(slots), _sizes(slots, 0), _defrags(0),
+          _failures(0) {}
+
+    const char *Name() const { return "Simple"; }
+
+    size_t Size(size_t slot) const { return _sizes[slot]; }
+
+    void Alloc(size_t slot, size_t size) {
+        if (Retry([&] { _slots[slot] = _a.alloc(size); })) {
+            Fill(_slots[slot].get(), 0, size);
+            _sizes[slot] = size;
+        }
+    }
+
+    void Realloc(size_t slot, size_t size) {
+        if (Retry([&] { _a.realloc(_slots[slot], size); })) {
+            Fill(_slots[slot].get(), _sizes[slot], size);
+            _sizes[slot] = size;
+        }
+    }
+
+    void Free(size_t slot) {
+        _a.free(_slots[slot]);
+        _sizes[slot] = 0;
+    }
+
+    std::string Notes() const {
+        return ", " + std::to_string(_defrags) + " defrags, " + std::to_string(_failures) + " failures";
+    }
+
+private:
+    // Runs allocation, compacts the area and retries once if it is too fragmented
+    template <typename F> bool Retry(F f) {
+        try {
+            f();
+            return true;
+        } catch (AllocError &) {
+            _defrags++;
+            _a.defrag();
+        }
+        try {
+            f();
+            return true;
+        } catch (AllocError &) {
+            _failures++;
+            return false;
+        }
+    }
+
+    std::unique_ptr<char[]> _area;
+    Simple _a;
+    std::vector<Pointer> _slots;
+    std::vector<size_t> _sizes;
+    size_t _defrags, _failures;
+};
+
+class SmallBackend {
+public:
+    explicit SmallBackend(size_t slots) : _slots(slots, nullptr), _sizes(slots, 0) {}
+
+    const char *Name() const { return "Small"; }
+
+    size_t Size(size_t slot) const { return _sizes[slot]; }
+
+    void Alloc(size_t slot, size_t size) {
+        _slots[slot] = _a.Alloc(size);
+        Fill(_slots[slot], 0, size);
+        _sizes[slot] = size;
+    }
+
+    // Size classes are fixed, growing block moves unless it still fits into its class
+    void Realloc(size_t slot, size_t size) {
+        size_t old = _sizes[slot];
+        if (size > Small::kMaxObject || Small::ClassOf(size) != Small::ClassOf(old)) {
+            void *moved = _a.Alloc(size);
+            std::memcpy(moved, _slots[slot], old);
+            Small::Free(_slots[slot], old);
+            _slots[slot] = moved;
+        }
+        Fill(_slots[slot], old, size);
+        _sizes[slot] = size;
+    }
+
+    void Free(size_t slot) {
+        Small::Free(_slots[slot], _sizes[slot]);
+        _slots[slot] = nullptr;
+        _sizes[slot] = 0;
+    }
+
+    std::string Notes() const { return ""; }
+
+private:
+    Small _a;
+    std::vector<void *> _slots;
+    std::vector<size_t> _sizes;
+};
+
+class MallocBackend {
+public:
+    explicit MallocBackend(size_t slots) : _slots(slots, nullptr), _sizes(slots, 0) {}
+
+    const char *Name() const { return "malloc"; }
+
+    size_t Size(size_t slot) const { return _sizes[slot]; }
+
+    void Alloc(size_t slot, size_t size) {
+        _slots[slot] = std::malloc(size);
+        Fill(_slots[slot], 0, size);
+        _sizes[slot] = size;
+    }
+
+    void Realloc(size_t slot, size_t size) {
+        _slots[slot] = std::realloc(_slots[slot], size);
+        Fill(_slots[slot], _sizes[slot], size);
+        _sizes[slot] = size;
+    }
+
+    void Free(size_t slot) {
+        std::free(_slots[slot]);
+        _slots[slot] = nullptr;
+        _sizes[slot] = 0;
+    }
+
+    std::string Notes() const { return ""; }
+
+private:
+    std::vector<void *> _slots;
+    std::vector<size_t> _sizes;
+};
+
+// Every run gets its own process, so that peak RSS of one allocator doesn't hide the others. Run gets RSS
+// at its start, before the allocator is created
+template <typename F> static void Isolated(F run) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        ResetPeakRss();
+        run(StatusKb("VmRSS"));
+        std::fflush(stdout);
+        _exit(0);
+    } else if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+    } else {
+        run(StatusKb("VmRSS"));
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t slots = 20000;
+    const size_t count = 1000000;
+
+    std::vector<trace> traces;
+    traces.push_back(ZipfTrace(slots, count));
+    traces.push_back(ChurnTrace(slots, count));
+    traces.push_back(AppendTrace(slots, count));
+
+    std::printf("fragmentation is sampled %d times along the trace\n", 8);
+    for (const trace &t : traces) {
+        std::printf("%s: %zu events, %zu slots, peak live %zu KB\n", t.name.c_str(), t.events.size(), t.slots,
+                    t.peak_live / 1024);
+
+        // Area is a half more than the peak of live data, so that fragmentation matters
+        Isolated([&](long rss) {
+            SimpleBackend backend(t.slots, t.peak_live + t.peak_live / 2);
+            Replay(t, backend, rss);
+        });
+        Isolated([&](long rss) {
+            SmallBackend backend(t.slots);
+            Replay(t, backend, rss);
+        });
+        Isolated([&](long rss) {
+            MallocBackend backend(t.slots);
+            Replay(t, backend, rss);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/LzCodec.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Backend;
+
+// JSON documents similar to the ones API servers put into cache: repeated field names, short random values
+static std::string MakeDocument(std::mt19937 &rnd, size_t size) {
+    static const char *names[] = {"alice", "bob", "carol", "dave", "eve", "mallory"};
+    std::string doc = "{\"items\":[";
+    for (int i = 0; doc.size() < size; i++) {
+        if (i > 0) {
+            doc += ',';
+        }
+        doc += "{\"id\":" + std::to_string(rnd() % 1000000) + ",\"name\":\"" + names[rnd() % 6] +
+               "\",\"active\":" + (rnd() % 2 ? "true" : "false") + ",\"score\":" + std::to_string(rnd() % 1000) +
+               ",\"tags\":[\"cache\",\"json\"]}";
+    }
+    doc += "]}";
+    return doc;
+}
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+static void Run(const std::vector<std::string> &docs, size_t budget, size_t threshold) {
+    SimpleLRU storage(budget, threshold);
+
+    size_t raw_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < docs.size(); i++) {
+        storage.Put("doc:" + std::to_string(i), docs[i]);
+        raw_bytes += docs[i].size();
+    }
+    double put_time = Seconds(start);
+
+    // Count survivors and time reads at the same pass, most recent first so that reads don't evict anything
+    size_t hits = 0;
+    std::string value;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = docs.size(); i-- > 0;) {
+        if (storage.Get("doc:" + std::to_string(i), value)) {
+            hits++;
+        }
+    }
+    double get_time = Seconds(start);
+
+    std::printf("threshold %6zu: %7zu of %zu items fit in %zu MB, put %7.1f MB/s, get %7.1f MB/s\n", threshold,
+                hits, docs.size(), budget >> 20, raw_bytes / put_time / (1 << 20),
+                raw_bytes * (double(hits) / docs.size()) / get_time / (1 << 20));
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rnd(42);
+    std::vector<std::string> docs;
+    size_t total = 0;
+    while (total < 128 * 1024 * 1024UL) {
+        docs.push_back(MakeDocument(rnd, 512 + rnd() % 8192));
+        total += docs.back().size();
+    }
+
+    // Codec alone
+    std::string packed, unpacked;
+    size_t packed_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &doc : docs) {
+        LzCodec::Compress(doc, packed);
+        packed_bytes += packed.size();
+    }
+    double compress_time = Seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    for (auto &doc : docs) {
+        LzCodec::Compress(doc, packed);
+        LzCodec::Decompress(packed, unpacked);
+    }
+    double decompress_time = Seconds(start) - compress_time;
+
+    std::printf("codec: ratio %.2f, compress %.1f MB/s, decompress %.1f MB/s\n", double(total) / packed_bytes,
+                total / compress_time / (1 << 20), total / decompress_time / (1 << 20));
+
+    // Same workload against 64MB cache with and without compression
+    Run(docs, 64 * 1024 * 1024UL, 0);
+    Run(docs, 64 * 1024 * 1024UL, 256);
+    return 0;
+}
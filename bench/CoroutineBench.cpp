@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <afina/coroutine/Engine.h>
+
+using Afina::Coroutine::Engine;
+
+static const size_t kSwitches = 200000;
+
+// Routines of the engine copy their stacks around, so whatever they share lives outside of them
+static void *g_routines[2];
+static size_t g_left;
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Goes down by 1K frames and passes control to the other routine from there until switches are over
+static int PingPong(Engine &engine, int me, size_t depth) {
+    char frame[1024];
+    std::memset(frame, int(depth), sizeof(frame));
+    if (depth > 0) {
+        return PingPong(engine, me, depth - 1) + frame[depth % sizeof(frame)];
+    }
+
+    while (g_left > 0) {
+        g_left--;
+        engine.sched(g_routines[1 - me]);
+    }
+    return frame[0];
+}
+
+static volatile int g_sink;
+
+static void Player(Engine &engine, int me, size_t depth) { g_sink = PingPong(engine, me, depth); }
+
+static void Game(Engine &engine, size_t depth) {
+    g_routines[0] = engine.run(Player, engine, 0, size_t(depth));
+    g_routines[1] = engine.run(Player, engine, 1, size_t(depth));
+    engine.sched(g_routines[0]);
+}
+
+static void Measure(Engine &engine, const char *mode) {
+    for (size_t depth : {0, 1, 4, 16, 64, 256}) {
+        g_left = kSwitches;
+        auto start = std::chrono::steady_clock::now();
+        engine.start(Game, engine, size_t(depth));
+        std::printf("%-10s %-10zu %10.0f\n", mode, depth, Seconds(start) * 1e9 / kSwitches);
+    }
+}
+
+int main() {
+    std::printf("%-10s %-10s %10s\n", "mode", "depth, KB", "ns/switch");
+
+    Engine copying;
+    Measure(copying, "copy");
+
+    // Stack has to fit the deepest game
+    Engine separate(Engine::Mode::kSeparateStack, 1024 * 1024);
+    Measure(separate, "separate");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/StealingExecutor.h>
+
+using namespace Afina::Concurrency;
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Stands for a short command: a bit of work on the data of its own
+static void Work(std::atomic<size_t> &done, size_t seed) {
+    volatile size_t x = seed;
+    for (int i = 0; i < 64; i++) {
+        x = x * 6364136223846793005u + 1442695040888963407u;
+    }
+    done.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void Await(std::atomic<size_t> &done, size_t count) {
+    while (done.load(std::memory_order_relaxed) != count) {
+        std::this_thread::yield();
+    }
+}
+
+// Tasks come from producers outside of the pool, each one submits count / producers of them
+template <typename Pool> static double External(Pool &pool, size_t producers, size_t count) {
+    std::atomic<size_t> done(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&pool, &done, p, producers, count] {
+            for (size_t i = p; i < count; i += producers) {
+                while (!pool.Execute(Work, std::ref(done), i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    Await(done, count);
+    return Seconds(start);
+}
+
+// Binary tree of tasks, each one spawns the next level from inside of the pool
+template <typename Pool> static void Fork(Pool &pool, std::atomic<size_t> &done, int depth) {
+    Work(done, size_t(depth));
+    if (depth == 0) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        while (!pool.Execute(Fork<Pool>, std::ref(pool), std::ref(done), depth - 1)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <typename Pool> static double Nested(Pool &pool, int depth) {
+    std::atomic<size_t> done(0);
+    auto start = std::chrono::steady_clock::now();
+    pool.Execute(Fork<Pool>, std::ref(pool), std::ref(done), depth);
+    Await(done, (size_t(1) << (depth + 1)) - 1);
+    return Seconds(start);
+}
+
+static void Report(const char *workload, const char *pool, double time, size_t count) {
+    std::printf("%-22s %-9s %8.0f ns/task %8.2f Mtasks/s\n", workload, pool, time * 1e9 / count, count / time / 1e6);
+}
+
+int main(int argc, char **argv) {
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    const size_t count = 1000000;
+    const int depth = 19;
+    std::printf("%zu threads, %zu tasks, fork tree of depth %d\n", threads, count, depth);
+
+    for (size_t producers : {size_t(1), threads}) {
+        std::string name = "external x" + std::to_string(producers);
+        {
+            Executor pool("bench", threads, threads, count, std::chrono::seconds(1));
+            Report(name.c_str(), "shared", External(pool, producers, count), count);
+        }
+        {
+            StealingExecutor pool("bench", threads);
+            Report(name.c_str(), "stealing", External(pool, producers, count), count);
+        }
+    }
+
+    size_t tree = (size_t(1) << (depth + 1)) - 1;
+    {
+        Executor pool("bench", threads, threads, tree, std::chrono::seconds(1));
+        Report("nested", "shared", Nested(pool, depth), tree);
+    }
+    {
+        StealingExecutor pool("bench", threads);
+        Report("nested", "stealing", Nested(pool, depth), tree);
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Concurrency;
+using Afina::Backend::SimpleLRU;
+
+static const size_t kOps = 200000;
+static const size_t kKeys = 10000;
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Runs body(thread, i) kOps times on every thread, returns ns per operation
+static double Run(size_t threads, const std::function<void(size_t, size_t)> &body) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&body, t] {
+            for (size_t i = 0; i < kOps; i++) {
+                body(t, i);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    return Seconds(start) * 1e9 / (threads * kOps);
+}
+
+static void Report(const char *structure, const char *sync, size_t threads, double ns) {
+    std::printf("%-8s %-6s %3zu threads %8.0f ns/op\n", structure, sync, threads, ns);
+}
+
+static void Counter(size_t threads) {
+    {
+        std::mutex mutex;
+        long counter = 0;
+        Report("counter", "mutex", threads, Run(threads, [&](size_t, size_t) {
+                   std::lock_guard<std::mutex> lock(mutex);
+                   counter++;
+               }));
+    }
+    {
+        long counter = 0;
+        FlatCombine<long> fc([&counter](long *const *ops, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                counter += *ops[i];
+            }
+        });
+        Report("counter", "fc", threads, Run(threads, [&fc](size_t, size_t) {
+                   long delta = 1;
+                   fc.Execute(delta);
+               }));
+    }
+}
+
+// Every thread pushes and pops in turn
+struct queue_op {
+    bool push;
+    long value;
+    bool ok;
+};
+
+static void Queue(size_t threads) {
+    {
+        std::mutex mutex;
+        std::deque<long> queue;
+        Report("queue", "mutex", threads, Run(threads, [&](size_t, size_t i) {
+                   std::lock_guard<std::mutex> lock(mutex);
+                   if (i % 2 == 0) {
+                       queue.push_back(long(i));
+                   } else if (!queue.empty()) {
+                       queue.pop_front();
+                   }
+               }));
+    }
+    {
+        std::deque<long> queue;
+        FlatCombine<queue_op> fc([&queue](queue_op *const *ops, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                queue_op &op = *ops[i];
+                if (op.push) {
+                    queue.push_back(op.value);
+                    op.ok = true;
+                } else if ((op.ok = !queue.empty())) {
+                    op.value = queue.front();
+                    queue.pop_front();
+                }
+            }
+        });
+        Report("queue", "fc", threads, Run(threads, [&fc](size_t, size_t i) {
+                   queue_op op{i % 2 == 0, long(i), false};
+                   fc.Execute(op);
+               }));
+    }
+}
+
+// Nine reads to one write over a fixed set of keys
+struct lru_op {
+    bool put;
+    const std::string *key;
+    std::string value;
+    bool ok;
+};
+
+static void Lru(size_t threads, const std::vector<std::string> &keys) {
+    const std::string value(100, 'v');
+    {
+        std::mutex mutex;
+        SimpleLRU lru(1 << 20);
+        Report("lru", "mutex", threads, Run(threads, [&](size_t t, size_t i) {
+                   const std::string &key = keys[(i * 7919 + t * 104729) % kKeys];
+                   std::lock_guard<std::mutex> lock(mutex);
+                   if (i % 10 == 0) {
+                       lru.Put(key, value);
+                   } else {
+                       std::string out;
+                       lru.Get(key, out);
+                   }
+               }));
+    }
+    {
+        SimpleLRU lru(1 << 20);
+        FlatCombine<lru_op> fc([&lru](lru_op *const *ops, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                lru_op &op = *ops[i];
+                op.ok = op.put ? lru.Put(*op.key, op.value) : lru.Get(*op.key, op.value);
+            }
+        });
+        Report("lru", "fc", threads, Run(threads, [&](size_t t, size_t i) {
+                   lru_op op{i % 10 == 0, &keys[(i * 7919 + t * 104729) % kKeys], std::string(), false};
+                   if (op.put) {
+                       op.value = value;
+                   }
+                   fc.Execute(op);
+               }));
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    std::printf("%zu ops per thread, up to %zu threads\n", kOps, max_threads);
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kKeys; i++) {
+        keys.push_back("key:" + std::to_string(i));
+    }
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Counter(threads);
+        Queue(threads);
+        Lru(threads, keys);
+    }
+    return 0;
+}
@@ -1,10 +1,44 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
+/**
+ * # Item metadata
+ * Stored right inside of the storage item along with key and value, so it costs no additional allocation
+ */
+struct ItemHeader {
+    // Unique version of the item, changes on every modification of it
+    uint64_t cas = 0;
+
+    // Opaque client flags, stored and returned back as is
+    uint32_t flags = 0;
+
+    // Absolute expiration time in seconds since epoch, 0 means item never expires
+    uint32_t expire = 0;
+};
+
+static_assert(sizeof(ItemHeader) <= 16, "Item header must be packed into 16 bytes");
+
+/**
+ * Result of the CompareAndSwap operation
+ */
+enum class CasResult {
+    // Value has been updated
+    kStored,
+
+    // Item has been modified since client read it
+    kExists,
+
+    // There is no item for the key
+    kNotFound
+};
+
 /**
  *
  */
@@ -84,6 +118,78 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Same as Put, but also stores item metadata.
+     *
+     * @param flags opaque client flags
+     * @param expire expiration time in memcached format: 0 means never, negative value means already
+     * expired, values up to 30 days are relative to the current time, anything bigger is unix timestamp
+     */
+    virtual bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+        return Put(key, value);
+    }
+
+    /**
+     * Same as PutIfAbsent, but also stores item metadata. See Put for the meaning of flags and expire
+     */
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+        return PutIfAbsent(key, value);
+    }
+
+    /**
+     * Same as Set, but also stores item metadata. See Put for the meaning of flags and expire
+     */
+    virtual bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+        return Set(key, value);
+    }
+
+    /**
+     * Same as Get, but also copies item metadata into header output parameter
+     */
+    virtual bool Get(const std::string &key, std::string &value, ItemHeader &header) {
+        header = ItemHeader();
+        return Get(key, value);
+    }
+
+    /**
+     * Updates existing association only if item wasn't modified since client has read it, i.e its cas
+     * unique is still the same. See Put for the meaning of flags and expire
+     *
+     * @param cas unique value returned by Get along with the value
+     */
+    virtual CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                     int32_t expire, uint64_t cas) {
+        return CasResult::kNotFound;
+    }
+
+    /**
+     * Adds data to the end of the existing value, item keeps its flags and expiration time. Returns false
+     * if there is no item for the key or the result doesn't fit
+     */
+    virtual bool Append(const std::string &key, const std::string &value) {
+        std::string current;
+        ItemHeader header;
+        if (!Get(key, current, header)) {
+            return false;
+        }
+        return Set(key, current + value, header.flags, static_cast<int32_t>(header.expire));
+    }
+
+    /**
+     * Get issued by the client that is expected to fill the key itself on miss, like memcached client which
+     * goes to the database and sets the key. Storage coalescing misses makes such client the only one to
+     * fill the key for a while: concurrent callers wait a bit for its write or get a stale copy of the value.
+     * Same as Get by default
+     */
+    virtual bool LeaseGet(const std::string &key, std::string &value, ItemHeader &header) {
+        return Get(key, value, header);
+    }
+
+    /**
+     * Appends storage statistics as name/value pairs, reported by the stats command as is
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
 };
 
 } // namespace Afina
@@ -0,0 +1,50 @@
+#ifndef AFINA_ALLOCATOR_ARENA_H
+#define AFINA_ALLOCATOR_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Source of slabs
+ * Bottom layer of the slab allocator: maps memory from the system in slabs of kSlabSize bytes, each
+ * one aligned to its size, so that owner of any object could be found by masking its address. Memory
+ * is never given back to the system until arena is destroyed, higher layers reuse slabs.
+ *
+ * Arena is NOT thread safe
+ */
+class Arena {
+public:
+    // Size and alignment of each slab
+    static const size_t kSlabSize = 256 * 1024;
+
+    /**
+     * @param quota maximum number of bytes to map, 0 means no limit
+     */
+    explicit Arena(size_t quota = 0);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Maps new slab, returns nullptr if quota is exhausted or system is out of memory
+     */
+    void *Map();
+
+    // Number of bytes mapped so far
+    size_t Used() const { return _slabs.size() * kSlabSize; }
+
+private:
+    const size_t _quota;
+
+    // All slabs ever mapped, unmapped on destruction
+    std::vector<void *> _slabs;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_ARENA_H
@@ -0,0 +1,156 @@
+#ifndef AFINA_ALLOCATOR_MEMPOOL_H
+#define AFINA_ALLOCATOR_MEMPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+class SlabCache;
+
+/**
+ * # Pool of fixed size objects
+ * Top layer of the slab allocator: carves slabs into objects of the same size. Both Alloc and Free
+ * are O(1): slab header sits at the start of the slab and is found by masking object address, free
+ * objects of a slab are linked through their first word. Slab that gets empty is given back to the
+ * slab cache, except for the single spare one that protects from the alloc/free thrashing on the
+ * slab boundary.
+ *
+ * Slab could be drained to move it to some other pool: pool stops allocating from it and gives it back
+ * to the cache as soon as owner of the objects frees or relocates all of them.
+ *
+ * Mempool is NOT thread safe
+ */
+class Mempool {
+public:
+    /**
+     * @param cache where to take slabs from, must outlive the pool
+     * @param object_size size of each object, at least pointer size
+     */
+    Mempool(SlabCache &cache, size_t object_size);
+    ~Mempool();
+
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    /**
+     * Returns object or nullptr if slab cache has no more slabs
+     */
+    void *Alloc();
+
+    /**
+     * Returns object back to the pool, object must be allocated by this pool
+     */
+    void Free(void *ptr);
+
+    /**
+     * Gives the spare slab back to the cache, returns false if there is none
+     */
+    bool ReleaseSpare();
+
+    /**
+     * Stops allocation from the slab having the fewest objects, so that it goes back to the cache once
+     * they are freed. Returns false if there is nothing to drain or some slab is being drained already
+     */
+    bool Drain();
+
+    /**
+     * Returns slab being drained back to allocation
+     */
+    void Undrain();
+
+    /**
+     * True if the object lives in the slab being drained, ptr may come from any allocator
+     */
+    bool Draining(const void *ptr) const { return _draining != nullptr && SlabOf(ptr) == _draining; }
+
+    /**
+     * True if some slab is being drained and still has objects
+     */
+    bool Draining() const { return _draining != nullptr; }
+
+    /**
+     * Finds pool that allocated the given object
+     */
+    static Mempool *Of(void *ptr) { return SlabOf(ptr)->pool; }
+
+    inline size_t ObjectSize() const { return _object_size; }
+
+    // Number of objects in use
+    inline size_t Used() const { return _used; }
+
+    // Number of objects ever allocated and freed
+    inline uint64_t Allocs() const { return _allocs; }
+    inline uint64_t Frees() const { return _allocs - _used; }
+
+    // Number of slabs owned by the pool, including the spare and the draining ones
+    inline size_t Slabs() const { return _slabs; }
+
+    // Number of objects fitting into a slab
+    inline size_t Capacity() const { return _capacity; }
+
+private:
+    // Header at the start of each slab
+    struct slab {
+        Mempool *pool;
+
+        // Neighbours in the pool list this slab belongs to
+        slab *prev;
+        slab *next;
+
+        // Freed objects
+        void *free_list;
+
+        // Start of the never allocated space
+        char *unused;
+
+        // Number of allocated objects
+        uint32_t used;
+
+        // True if slab is in the partial list
+        bool partial;
+    };
+
+    static slab *SlabOf(const void *ptr) {
+        return reinterpret_cast<slab *>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(Arena::kSlabSize) - 1));
+    }
+
+    // Takes slab from the cache and prepares it for allocation
+    slab *NewSlab();
+
+    static void Unlink(slab *&list, slab *s);
+    static void Link(slab *&list, slab *s);
+
+    SlabCache &_cache;
+    const size_t _object_size;
+
+    // Offset of the first object in the slab
+    const size_t _first;
+
+    // Number of objects fitting into slab
+    const uint32_t _capacity;
+
+    // Slabs having free objects
+    slab *_partial;
+
+    // Slabs with all objects allocated
+    slab *_full;
+
+    // Empty slab kept for reuse
+    slab *_spare;
+
+    // Slab taken out of both lists to be given away
+    slab *_draining;
+
+    size_t _used;
+    size_t _slabs;
+    uint64_t _allocs;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_MEMPOOL_H
@@ -7,6 +7,14 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * # Handle of the memory block allocated by Simple
+ * Pointer doesn't address memory directly, it refers to the allocator's indirection table slot that
+ * holds the current block address. Allocator is free to move blocks around (defrag, realloc), so
+ * address returned by get() is only valid until the next call to the allocator.
+ *
+ * Copies refer to the same block, once block is freed through one of them the rest are dangling
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +25,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    // Indirection table entry holding block address, nullptr for the empty pointer
+    void **_slot;
 };
 
 } // namespace Allocator
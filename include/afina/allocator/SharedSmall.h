@@ -0,0 +1,121 @@
+#ifndef AFINA_ALLOCATOR_SHARED_SMALL_H
+#define AFINA_ALLOCATOR_SHARED_SMALL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <afina/allocator/Small.h>
+#include <afina/concurrency/LockFreeStack.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Thread caching front end of the size class allocator
+ * Small shared between threads. Every thread keeps a pair of magazines, arrays of free objects, per size
+ * class and serves Alloc and Free out of them without any synchronization. Once both magazines of the
+ * class are full or empty thread exchanges the whole magazine with the depot: lock-free stack of full
+ * magazines per class. So a thread freeing objects allocated by some other thread hands them back in
+ * batches and the other one picks them up, neither of them touches a lock.
+ *
+ * Central Small is locked only when depot runs dry and the next batch has to be carved out of slabs, and
+ * by Trim. Magazines of an exiting thread go to the depot.
+ *
+ * Objects cached by threads are not available to the others, so NoMemory could be thrown while some
+ * objects of the class are still cached in the magazines of other threads.
+ */
+class SharedSmall {
+public:
+    /**
+     * @param quota maximum number of bytes to take from the system for slabs, 0 means no limit
+     */
+    explicit SharedSmall(size_t quota = 0);
+    ~SharedSmall();
+
+    SharedSmall(const SharedSmall &) = delete;
+    SharedSmall &operator=(const SharedSmall &) = delete;
+
+    /**
+     * Allocates block of at least size bytes, throws AllocError(NoMemory) if quota is exhausted
+     */
+    void *Alloc(size_t size);
+
+    /**
+     * Releases block allocated by this instance with the same size, could be called by any thread
+     */
+    void Free(void *ptr, size_t size);
+
+    /**
+     * Gives objects kept in the depot back to slabs, so that empty slabs could be reused by other classes
+     */
+    void Trim();
+
+    // Number of objects taken from slabs, including ones cached in magazines
+    size_t Used();
+
+    // Number of bytes taken from the system for slabs
+    size_t Mapped();
+
+private:
+    // Largest number of objects in the magazine
+    static const size_t kMagazineSize = 64;
+
+    // Magazines of large classes hold fewer objects, so that each one caches about that many bytes
+    static const size_t kMagazineBytes = 64 * 1024;
+
+    struct magazine {
+        size_t count;
+        void *objects[kMagazineSize];
+    };
+
+    // Magazines of a thread
+    struct thread_cache {
+        explicit thread_cache(SharedSmall &owner) : owner(owner), slots(owner._limits.size()) {}
+        ~thread_cache();
+
+        struct slot {
+            // Magazine objects are taken from and freed into
+            magazine *loaded = nullptr;
+
+            // Spare one, swapped with loaded before going to the depot
+            magazine *previous = nullptr;
+        };
+
+        SharedSmall &owner;
+        std::vector<slot> slots;
+    };
+
+    // Returns magazine slot of the calling thread for the class, magazines are allocated on the first use
+    thread_cache::slot &Slot(size_t cls);
+
+    // Takes empty magazine from the pool or allocates new one
+    magazine *NewMagazine();
+
+    // Fills magazine from slabs, throws AllocError(NoMemory) if no object could be allocated
+    void Refill(size_t cls, magazine &m);
+
+    Small _small;
+
+    // Guards _small
+    std::mutex _mutex;
+
+    // Capacity of magazines by class
+    std::vector<size_t> _limits;
+
+    // Full magazines by class
+    std::vector<std::unique_ptr<Concurrency::LockFreeStack<magazine *>>> _depot;
+
+    // Empty magazines of all classes
+    Concurrency::LockFreeStack<magazine *> _empty;
+
+    // Destroyed first, so that thread caches flush into the depot
+    std::unique_ptr<Concurrency::ThreadLocal<thread_cache>> _caches;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SHARED_SMALL_H
@@ -1,8 +1,9 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace Afina {
 namespace Allocator {
@@ -18,44 +19,197 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Memory layout: blocks grow up from the start of the area, each one is prefixed by a small header,
+ * indirection table grows down from the end of it. Pointer refers to the table slot, so blocks could
+ * be moved by updating a single slot. Freed blocks go to the free lists segregated by power of two size
+ * classes and get reused from the smallest class that fits, the last block is given back to the free
+ * space right away. Nothing is coalesced on free, defrag() slides all live blocks to the start of the area
+ * instead, leaving single free space between blocks and table.
+ *
+ * Sliding could be done in steps of bounded size as well, so that large area is compacted without a long
+ * pause. While compaction is in progress blocks below the cursor are compact, except for the ones freed
+ * meanwhile, and the gap between the cursor and the next unvisited block is the free room.
+ *
+ * Blocks are moved by defrag(), so it can not back standard containers, StlAllocator works over Small instead
  */
-// TODO: Implements interface to allow usage as C++ allocators
 class Simple {
 public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes, throws AllocError(NoMemory) if there is no room for it
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block keeping its content (up to the smaller of sizes). Block is shrunk or
+     * grown in place when possible: into the free space, free block next to it or the gap left by
+     * compaction. Otherwise it is moved and p keeps pointing to it, moved block gets half of its size of
+     * room to grow, so that value built by small appends costs amortized O(appended bytes). Shrunk block
+     * keeps its room unless it halves. Empty p gets newly allocated block. On AllocError block is left
+     * unchanged
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block and resets p, no-op for empty pointer. Throws AllocError(InvalidFree) if p doesn't
+     * belong to this allocator
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all live blocks to the start of the area, so that all free memory is contiguous. Invalidates
+     * raw addresses obtained by Pointer::get()
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Does a bounded part of defrag(): moves blocks until max_bytes are copied, headers of the blocks
+     * walked over count too, at least one block per call. Returns true once all free memory is contiguous,
+     * the next call starts over. Allocator is fully usable between steps: new blocks fill the gap behind
+     * the compaction cursor first, blocks freed ahead of it are picked up by the walk. Invalidates raw
+     * addresses obtained by Pointer::get()
+     * @param max_bytes size_t
+     */
+    bool defrag_step(size_t max_bytes);
+
+    // Number of size classes, class i holds blocks of [2^i, 2^(i+1)) bytes
+    static const size_t kClasses = sizeof(size_t) * 8;
+
+    /**
+     * Usage of the area, all counters are maintained by the allocator as it goes, so taking it is cheap
+     */
+    struct usage {
+        // Blocks in use and their payload bytes
+        size_t used_blocks;
+        size_t used_bytes;
+
+        // Blocks in free lists and their payload bytes. During incremental defrag blocks freed ahead of
+        // the cursor are not counted until compaction gets to them
+        size_t free_blocks;
+        size_t free_bytes;
+
+        // Payload that fits into the room between the last block and the table, plus into the gap behind
+        // the compaction cursor if any
+        size_t tail_bytes;
+
+        // Largest block that could be allocated without defrag
+        size_t largest_free;
+
+        // Free blocks in each class
+        size_t free_lists[kClasses];
+
+        // Allocations and frees by the class of the block size
+        uint64_t allocs[kClasses];
+        uint64_t frees[kClasses];
+
+        /**
+         * Share of free memory that could not be given out as a single block: 0 means all of it is
+         * contiguous, close to 1 means that it is scattered in small holes and defrag() would help
+         */
+        double fragmentation() const;
+    };
+
+    usage stats() const;
+
+    /**
+     * Human readable form of stats(): summary line followed by a line per size class having free blocks
+     * or allocations, e.g:
+     *   used 10 blocks 1280 bytes, free 2 blocks 256 bytes, tail 64000 bytes, largest 64000, fragmentation 0.004
+     *   class 7: free 2, allocs 12, frees 2
      */
     std::string dump() const;
 
 private:
+    // Header preceding every block
+    struct block {
+        // Payload size, always multiple of the alignment
+        size_t size;
+
+        // Table slot for blocks in use, nullptr for free ones. Free block keeps free_links in its payload
+        void **slot;
+    };
+
+    // Neighbours of the free block in its free list
+    struct free_links {
+        block *next;
+        block *prev;
+    };
+
+    static free_links &Links(block *b) { return *reinterpret_cast<free_links *>(b + 1); }
+
+    // Finds block header for the given table slot, throws if slot doesn't belong to this allocator
+    block *BlockOf(void **slot) const;
+
+    // Throws AllocError(NoMemory) for sizes that can't fit into the area, before they overflow alignment
+    void CheckSize(size_t N) const;
+
+    // Takes free table slot, growing table if needed. Returns nullptr if table can't grow
+    void **TakeSlot();
+
+    // Puts table slot back to the free list
+    void ReleaseSlot(void **slot);
+
+    // Finds room for the block with payload of the given size, returns nullptr if there is none
+    block *TakeBlock(size_t size);
+
+    // Takes first block of at least given size among the first max_scan blocks of the size class
+    block *TakeFromClass(size_t cls, size_t size, size_t max_scan);
+
+    // Gives block back: either to the free space if it is the last one or to the free list
+    void ReleaseBlock(block *b);
+
+    // Takes block out of its free list
+    void Unlink(block *b);
+
+    // Extends block in use up to the given size with the room right after it, returns false if there is
+    // not enough of it
+    bool GrowInPlace(block *b, size_t size);
+
+    // Cuts block down to the given size, tail goes to the free list if it is big enough to be a block
+    void SplitBlock(block *b, size_t size);
+
+    // Completes compaction in progress: gap behind the cursor becomes the free space
+    void EndDefrag();
+
     void *_base;
     const size_t _base_len;
+
+    // End of the last block, start of the free space
+    char *_top;
+
+    // Lowest table slot, end of the free space
+    void **_table;
+
+    // End of the area aligned down, table grows down from here
+    void **_table_end;
+
+    // Doubly linked lists of freed blocks below _top, list i holds blocks of [2^i, 2^(i+1)) bytes
+    block *_free_blocks[kClasses];
+
+    // Bit i is set if list i is not empty
+    size_t _free_mask;
+
+    // Counters of usage(), see there
+    size_t _used_blocks;
+    size_t _used_bytes;
+    size_t _free_bytes;
+    size_t _free_counts[kClasses];
+    uint64_t _allocs[kClasses];
+    uint64_t _frees[kClasses];
+
+    // Singly linked list of unused table slots, each one holds address of the next one
+    void **_free_slots;
+
+    // Compaction in progress: end of the compacted blocks and the next block to visit, [dst, src) is free.
+    // Both are nullptr if there is no compaction going on
+    char *_defrag_dst;
+    char *_defrag_src;
 };
 
 } // namespace Allocator
@@ -0,0 +1,58 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Cache of free slabs
+ * Middle layer of the slab allocator: hands out slabs to memory pools and takes them back once pool
+ * doesn't need them anymore. Released slabs are reused by any pool, so memory moves freely between
+ * size classes. New slabs are taken from the arena only when cache is empty.
+ *
+ * SlabCache is NOT thread safe
+ */
+class SlabCache {
+public:
+    /**
+     * @param quota maximum number of bytes to take from the system, 0 means no limit
+     */
+    explicit SlabCache(size_t quota = 0) : _arena(quota), _used(0) {}
+
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /**
+     * Returns free slab of Arena::kSlabSize bytes or nullptr if there are no more
+     */
+    void *Get();
+
+    /**
+     * Gives slab back to the cache
+     */
+    void Put(void *slab);
+
+    // Number of slabs currently given out
+    size_t Used() const { return _used; }
+
+    // Number of bytes taken from the system
+    size_t Mapped() const { return _arena.Used(); }
+
+private:
+    Arena _arena;
+
+    // Slabs available for reuse
+    std::vector<void *> _free;
+
+    size_t _used;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
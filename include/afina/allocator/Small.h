@@ -0,0 +1,100 @@
+#ifndef AFINA_ALLOCATOR_SMALL_H
+#define AFINA_ALLOCATOR_SMALL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Size class allocator
+ * Routes each allocation to the memory pool of the smallest size class that fits. Classes go with
+ * 8 byte step up to 128 bytes, that is where most of keys and small values are, and grow by 1.25
+ * after that, so internal fragmentation stays under 25%. Both class lookup and pool operations are
+ * O(1). Blocks bigger than kMaxObject are too large for slabs and go to malloc.
+ *
+ * Free is sized: caller passes the same size it has allocated, the way storage knows its item sizes
+ * anyway, so blocks carry no headers.
+ *
+ * Small is NOT thread safe
+ */
+class Small {
+public:
+    // Largest block served from slabs
+    static const size_t kMaxObject = 32 * 1024;
+
+    /**
+     * @param quota maximum number of bytes to take from the system for slabs, 0 means no limit
+     */
+    explicit Small(size_t quota = 0);
+    ~Small();
+
+    Small(const Small &) = delete;
+    Small &operator=(const Small &) = delete;
+
+    /**
+     * Allocates block of at least size bytes, throws AllocError(NoMemory) if quota is exhausted
+     */
+    void *Alloc(size_t size);
+
+    /**
+     * Same as Alloc, but returns nullptr instead of throwing
+     */
+    void *TryAlloc(size_t size);
+
+    /**
+     * Allocates up to count objects of the given size class, returns number of allocated ones
+     */
+    size_t AllocBatch(size_t cls, void **objects, size_t count);
+
+    /**
+     * Releases block allocated by any Small instance with the same size
+     */
+    static void Free(void *ptr, size_t size);
+
+    /**
+     * Size class serving blocks of the given size, size must not exceed kMaxObject
+     */
+    static size_t ClassOf(size_t size) { return SizeClasses().lookup[size == 0 ? 0 : (size - 1) / 8]; }
+
+    /**
+     * Number of bytes usable in the block allocated for the given size: object size of its class, or the
+     * size itself for blocks going to malloc. Freeing block with any size up to that is the same
+     */
+    static size_t BlockSize(size_t size) { return size > kMaxObject ? size : SizeClasses().sizes[ClassOf(size)]; }
+
+    // Number of size classes
+    size_t Classes() const { return _pools.size(); }
+
+    // Pool serving given size class
+    const Mempool &Pool(size_t cls) const { return *_pools[cls]; }
+    Mempool &Pool(size_t cls) { return *_pools[cls]; }
+
+    // Number of bytes taken from the system for slabs
+    size_t Mapped() const { return _cache.Mapped(); }
+
+private:
+    // Table of class sizes and lookup table from (size - 1) / 8 to the class index
+    struct size_classes {
+        size_classes();
+
+        std::vector<size_t> sizes;
+        std::vector<uint8_t> lookup;
+    };
+
+    static const size_classes &SizeClasses();
+
+    SlabCache _cache;
+    std::vector<std::unique_ptr<Mempool>> _pools;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SMALL_H
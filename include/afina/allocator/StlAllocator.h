@@ -0,0 +1,64 @@
+#ifndef AFINA_ALLOCATOR_STL_ALLOCATOR_H
+#define AFINA_ALLOCATOR_STL_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Standard allocator over the slab allocators
+ * Lets standard containers draw their memory from Small or SharedSmall, so that nodes of a map or
+ * elements of a vector go to the slabs of the given arena instead of malloc. Subsystem that gets its own
+ * arena gets its memory accounted separately for free: Mapped() of the arena is what it takes.
+ *
+ * Allocator only refers to the arena, copies and rebound ones share it and compare equal, arena must
+ * outlive every container using it. Both arenas never move blocks, that is why Simple, compacting one,
+ * can not be used here.
+ *
+ * Blocks are aligned to the pointer size, so is the T
+ */
+template <typename T, typename Arena> class StlAllocator {
+public:
+    static_assert(alignof(T) <= alignof(void *), "Slabs give no stronger alignment than the pointer one");
+
+    using value_type = T;
+
+    explicit StlAllocator(Arena &arena) noexcept : _arena(&arena) {}
+
+    template <typename U> StlAllocator(const StlAllocator<U, Arena> &other) noexcept : _arena(other._arena) {}
+
+    /**
+     * Allocates room for n objects, throws AllocError(NoMemory) if arena is out of quota
+     */
+    T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(_arena->Alloc(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept { _arena->Free(ptr, n * sizeof(T)); }
+
+    Arena &arena() const noexcept { return *_arena; }
+
+    template <typename U> bool operator==(const StlAllocator<U, Arena> &other) const noexcept {
+        return _arena == other._arena;
+    }
+
+    template <typename U> bool operator!=(const StlAllocator<U, Arena> &other) const noexcept {
+        return _arena != other._arena;
+    }
+
+private:
+    template <typename U, typename A> friend class StlAllocator;
+
+    Arena *_arena;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_STL_ALLOCATOR_H
@@ -1,21 +1,52 @@
 #ifndef AFINA_CONCURRENCY_EXECUTOR_H
 #define AFINA_CONCURRENCY_EXECUTOR_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <cstdint>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <afina/concurrency/MPMCQueue.h>
+#include <afina/concurrency/Placement.h>
+#include <afina/concurrency/Task.h>
 
 namespace Afina {
 namespace Concurrency {
 
 /**
  * # Thread pool
+ * Runs tasks on the pool of threads sized between the low and high watermarks. Pool starts with
+ * low_watermark threads, new thread is started when the task is added while every thread is busy, up to
+ * high_watermark. Thread that has been idle for idle_time exits unless there are only low_watermark
+ * threads left.
+ *
+ * Tasks that could not get a thread right away wait in the queue of at most max_queue_size tasks, once
+ * it is full new tasks are rejected.
+ *
+ * Tasks are handed to threads through the lock-free MPMCQueue, and are kept there as Task, so neither
+ * the queue nor the task with a few small arguments allocates. Execute takes no lock unless it has to
+ * start a thread or wake a sleeping one.
+ *
+ * Tasks could be split into priority lanes, each with a queue of its own. Free thread takes the task from
+ * the lane that is the most behind its weighted share: every lane has a virtual pass advanced by
+ * 1 / weight on each dequeue, and the lane with the smallest one wins, so under load lanes get threads in
+ * proportion to their weights and an idle lane does not bank credit. Lane could be capped in the number
+ * of its tasks running at once and in the number of its queued tasks, so background work could neither
+ * take over every thread nor fill the whole queue. Weights are followed approximately: lanes are picked
+ * without a lock.
+ *
+ * Exceptions thrown by tasks are swallowed, so a task that needs to report failure has to do it by
+ * itself
  */
 class Executor {
+public:
     enum class State {
         // Threadpool is fully operational, tasks could be added and get executed
         kRun,
@@ -28,7 +59,56 @@ class Executor {
         kStopped
     };
 
-    Executor(std::string name, int size);
+    // Priority lane of tasks
+    struct Lane {
+        /**
+         * @param weight share of threads the lane gets when every lane has tasks
+         * @param max_running maximum number of tasks of the lane run at once, 0 for no limit
+         * @param max_queue maximum number of tasks of the lane waiting for a thread, 0 for the pool limit only
+         */
+        Lane(unsigned weight = 1, std::size_t max_running = 0, std::size_t max_queue = 0)
+            : weight(weight), max_running(max_running), max_queue(max_queue) {}
+
+        unsigned weight;
+        std::size_t max_running;
+        std::size_t max_queue;
+    };
+
+    // Counters of the lane
+    struct LaneStats {
+        // Tasks waiting for a thread now
+        std::size_t queued;
+
+        // Tasks being executed now
+        std::size_t running;
+
+        // Tasks taken by threads so far
+        std::uint64_t executed;
+
+        // Tasks rejected so far
+        std::uint64_t rejected;
+
+        // Time executed tasks have spent in the queue, in total and at most
+        std::chrono::microseconds total_wait;
+        std::chrono::microseconds max_wait;
+    };
+
+    /**
+     * @param name prefix of the thread names
+     * @param low_watermark number of threads kept alive even if idle
+     * @param high_watermark maximum number of threads
+     * @param max_queue_size maximum number of tasks waiting for a thread
+     * @param idle_time how long thread above low_watermark waits for a task before exiting
+     */
+    Executor(std::string name, std::size_t low_watermark, std::size_t high_watermark, std::size_t max_queue_size,
+             std::chrono::milliseconds idle_time);
+
+    /**
+     * Same as above, but with the priority lanes, numbered in the order given. Thread started while there
+     * are n others is placed as the n-th one of the placement
+     */
+    Executor(std::string name, std::size_t low_watermark, std::size_t high_watermark, std::size_t max_queue_size,
+             std::chrono::milliseconds idle_time, std::vector<Lane> lanes, Placement placement = Placement());
     ~Executor();
 
     /**
@@ -41,26 +121,58 @@ class Executor {
 
     /**
      * Add function to be executed on the threadpool. Method returns true in case if task has been placed
-     * onto execution queue, i.e scheduled for execution and false otherwise.
+     * onto execution queue, i.e scheduled for execution and false otherwise: pool is stopping or there
+     * is neither a free thread nor room in the queue.
      *
      * That function doesn't wait for function result. Function could always be written in a way to notify caller about
      * execution finished by itself
      */
     template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
+        return ExecuteIn(0, std::forward<F>(func), std::forward<Types>(args)...);
+    }
+
+    /**
+     * Same as Execute, but task goes to the given lane. Task is rejected also if the lane queue is full
+     */
+    template <typename F, typename... Types> bool ExecuteIn(std::size_t lane, F &&func, Types... args) {
+        lane_state &l = *lanes.at(lane);
+
         // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
+        queued_task exec;
+        exec.task = Task(std::bind(std::forward<F>(func), std::forward<Types>(args)...));
+        exec.enqueued = std::chrono::steady_clock::now();
 
-        std::unique_lock<std::mutex> lock(this->mutex);
-        if (state != State::kRun) {
+        // Place is reserved before the state check, so that stopping threads wait for the task
+        std::size_t reserved = queued.fetch_add(1);
+        std::size_t lane_reserved = l.queued.fetch_add(1);
+        if (state.load() != State::kRun ||
+            reserved >= free_threads.load() + (high_watermark - threads.load()) + max_queue_size ||
+            (l.max_queue != 0 && lane_reserved >= l.max_queue) || !l.tasks.TryPush(std::move(exec))) {
+            l.queued.fetch_sub(1);
+            queued.fetch_sub(1);
+            l.rejected.fetch_add(1, std::memory_order_relaxed);
             return false;
         }
 
-        // Enqueue new task
-        tasks.push_back(exec);
-        empty_condition.notify_one();
+        Dispatch();
         return true;
     }
 
+    // Current state of the pool
+    State GetState();
+
+    // Number of running threads, busy or idle
+    std::size_t Threads();
+
+    // Number of tasks waiting for a thread
+    std::size_t Queued();
+
+    // Number of lanes
+    std::size_t Lanes() const { return lanes.size(); }
+
+    // Counters of the lane
+    LaneStats Stats(std::size_t lane);
+
 private:
     // No copy/move/assign allowed
     Executor(const Executor &);            // = delete;
@@ -69,12 +181,69 @@ private:
     Executor &operator=(Executor &&);      // = delete;
 
     /**
-     * Main function that all pool threads are running. It polls internal task queue and execute tasks
+     * Main function that all pool threads are running. It polls internal task queue and execute tasks. Slot is
+     * the index of the thread in the placement, it is given back on exit
      */
-    friend void perform(Executor *executor);
+    friend void perform(Executor *executor, std::size_t slot);
+
+    // Task with the time it has been queued at
+    struct queued_task {
+        Task task;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct lane_state {
+        lane_state(const Lane &lane, std::size_t capacity)
+            : max_running(lane.max_running), max_queue(lane.max_queue), stride(kStride / lane.weight), tasks(capacity),
+              queued(0), running(0), pass(0), executed(0), rejected(0), total_wait(0), max_wait(0) {}
+
+        const std::size_t max_running;
+        const std::size_t max_queue;
+
+        // Pass advance per dequeue, inversely proportional to the weight
+        const std::uint64_t stride;
+
+        MPMCQueue<queued_task> tasks;
+
+        // Tasks in the queue, including the ones being pushed right now
+        std::atomic<std::size_t> queued;
+        std::atomic<std::size_t> running;
+
+        // Virtual time of the lane, the smallest one among the lanes with tasks is served first
+        std::atomic<std::uint64_t> pass;
+
+        std::atomic<std::uint64_t> executed;
+        std::atomic<std::uint64_t> rejected;
+
+        // Wait time, in nanoseconds
+        std::atomic<std::uint64_t> total_wait;
+        std::atomic<std::uint64_t> max_wait;
+    };
+
+    // Pass advance of the lane with weight 1
+    static const std::uint64_t kStride = std::uint64_t(1) << 20;
+
+    // Starts one more thread if there are more tasks than free threads and wakes sleeping one if any
+    void Dispatch();
+
+    // Whether some lane has a task that could be run right now
+    bool Runnable();
+
+    // Takes the task from the lane that is the most behind its share, returns false if there is none
+    bool Pop(queued_task &exec, std::size_t &lane);
+
+    // Starts one more thread, expects mutex to be locked
+    void StartThread();
+
+    const std::string name;
+    const std::size_t low_watermark;
+    const std::size_t high_watermark;
+    const std::size_t max_queue_size;
+    const std::chrono::milliseconds idle_time;
+    const Placement placement;
 
     /**
-     * Mutex to protect state below from concurrent modification
+     * Mutex to serialize starting and exiting threads, and to sleep on
      */
     std::mutex mutex;
 
@@ -84,19 +253,50 @@ private:
     std::condition_variable empty_condition;
 
     /**
-     * Vector of actual threads that perorm execution
+     * Conditional variable to await the last thread on Stop
+     */
+    std::condition_variable stop_condition;
+
+    /**
+     * Number of threads that perform execution, threads are detached and count themselves out on exit
+     */
+    std::atomic<std::size_t> threads;
+
+    /**
+     * Placement slots taken by running threads, changed under the mutex. Threads above the low watermark come
+     * and go, so the slot of the exited one is reused rather than the next index after the count
+     */
+    std::vector<bool> slots;
+
+    /**
+     * Number of threads not running a task, including just started ones
+     */
+    std::atomic<std::size_t> free_threads;
+
+    /**
+     * Number of threads sleeping on empty_condition
+     */
+    std::atomic<std::size_t> sleeping;
+
+    /**
+     * Number of tasks in the queue, including the ones being pushed right now
+     */
+    std::atomic<std::size_t> queued;
+
+    /**
+     * Task queues of the lanes, each has room for every thread and max_queue_size more
      */
-    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<lane_state>> lanes;
 
     /**
-     * Task queue
+     * Pass of the lane served last, idle lane catches up to it instead of taking every thread for a while
      */
-    std::deque<std::function<void()>> tasks;
+    std::atomic<std::uint64_t> virtual_time;
 
     /**
-     * Flag to stop bg threads
+     * Flag to stop bg threads, changed under the mutex
      */
-    State state;
+    std::atomic<State> state;
 };
 
 } // namespace Concurrency
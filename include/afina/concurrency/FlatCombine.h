@@ -1,10 +1,202 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining
+ * Serializes operations on a sequential structure without making every thread take the lock in turn
+ * (Hendler, Incze, Shavit, Tzafrir). Each thread has its own publication record, linked into the shared
+ * list once and reused afterwards. Execute publishes the operation in the record of the calling thread and
+ * tries to become the combiner by taking the single atomic flag. The combiner collects every published
+ * operation and hands the whole batch to the apply hook in one call, while the other threads spin on
+ * their own records, each on its own cache line, until their operations are applied or the flag is free
+ * again. Lock hand-off and the cache lines of the structure stay with one thread for the whole batch, and
+ * the hook could process the batch smarter than one by one: merge, reorder, or cancel operations out.
+ *
+ * Op is whatever the hook understands, it is kept by the caller and is where the hook puts the result.
+ * Exception thrown by the hook is rethrown by Execute of every operation of that batch.
+ *
+ * Records of exited threads are taken over by new threads, so there are never more records than threads
+ * that have been running at once. FlatCombine must not be destroyed while some thread is in Execute
+ */
+template <typename Op> class FlatCombine {
+public:
+    // Applies ops[0], ..., ops[count - 1], in any order
+    using apply_fn = std::function<void(Op *const *ops, std::size_t count)>;
+
+    /**
+     * @param apply batch hook, called by one thread at a time
+     * @param passes how many times combiner looks for new operations before it gives the flag up
+     */
+    explicit FlatCombine(apply_fn apply, std::size_t passes = 3)
+        : _apply(std::move(apply)), _passes(passes == 0 ? 1 : passes), _combining(false), _head(nullptr),
+          _local(new ThreadLocal<handle>([this] { return new handle(Acquire()); })) {}
+
+    ~FlatCombine() {
+        // Handles go first, they release records
+        _local.reset();
+
+        record *r = _head.load();
+        while (r != nullptr) {
+            record *next = r->next;
+            delete r;
+            r = next;
+        }
+    }
+
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    /**
+     * Applies op and returns once it is done, either by this thread or by the current combiner
+     */
+    void Execute(Op &op) {
+        record *r = _local->Get().r;
+        r->error = nullptr;
+        r->op.store(&op, std::memory_order_release);
+
+        for (;;) {
+            if (!_combining.load(std::memory_order_relaxed) && !_combining.exchange(true, std::memory_order_acquire)) {
+                Combine();
+                _combining.store(false, std::memory_order_release);
+                break;
+            }
+
+            // Either combiner applies the op, or it leaves and the next round has a chance to take its place
+            for (std::size_t spins = 0; r->op.load(std::memory_order_acquire) != nullptr; spins++) {
+                if (!_combining.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                if (spins >= kSpins) {
+                    std::this_thread::yield();
+                }
+            }
+            if (r->op.load(std::memory_order_acquire) == nullptr) {
+                break;
+            }
+        }
+
+        if (r->error) {
+            std::rethrow_exception(r->error);
+        }
+    }
+
+    // Number of publication records
+    std::size_t Size() const {
+        std::size_t size = 0;
+        for (record *r = _head.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            size++;
+        }
+        return size;
+    }
+
+private:
+    static const std::size_t kCacheLine = 64;
+
+    // Spins before yielding the processor to the combiner
+    static const std::size_t kSpins = 128;
+
+    // Publication record, owned by one thread at a time
+    struct record {
+        record() : op(nullptr), owned(true), next(nullptr) {}
+
+        // Published operation, reset by the combiner once applied
+        std::atomic<Op *> op;
+
+        // Set by the combiner before resetting op
+        std::exception_ptr error;
+
+        std::atomic<bool> owned;
+
+        // Immutable once record is in the list
+        record *next;
+
+        // Records are spun on by their owners and written by the combiner, not shared with the neighbours
+        char padding[kCacheLine];
+    };
+
+    // Per thread instance, gives the record back on exit
+    struct handle {
+        explicit handle(record *r) : r(r) {}
+        ~handle() { r->owned.store(false, std::memory_order_release); }
+
+        record *r;
+    };
+
+    // Takes record over from the exited thread or links the new one
+    record *Acquire() {
+        for (record *r = _head.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->owned.load(std::memory_order_relaxed) &&
+                r->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+
+        record *r = new record();
+        r->next = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return r;
+    }
+
+    // Applies published operations in batches, called with the flag taken
+    void Combine() {
+        for (std::size_t pass = 0; pass < _passes; pass++) {
+            _batch.clear();
+            _owners.clear();
+            for (record *r = _head.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+                Op *op = r->op.load(std::memory_order_acquire);
+                if (op != nullptr) {
+                    _batch.push_back(op);
+                    _owners.push_back(r);
+                }
+            }
+            if (_batch.empty()) {
+                return;
+            }
+
+            std::exception_ptr error;
+            try {
+                _apply(_batch.data(), _batch.size());
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            for (record *r : _owners) {
+                r->error = error;
+                r->op.store(nullptr, std::memory_order_release);
+            }
+        }
+    }
+
+    const apply_fn _apply;
+    const std::size_t _passes;
+
+    // Taken by the combiner
+    std::atomic<bool> _combining;
+
+    // List of publication records, only grows
+    std::atomic<record *> _head;
+
+    // Batch being applied, used by the combiner only
+    std::vector<Op *> _batch;
+    std::vector<record *> _owners;
+
+    std::unique_ptr<ThreadLocal<handle>> _local;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,360 @@
+#ifndef AFINA_CONCURRENCY_FUTURE_H
+#define AFINA_CONCURRENCY_FUTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <afina/concurrency/Task.h>
+
+namespace Afina {
+namespace Concurrency {
+
+template <typename T> class Future;
+template <typename T> class Promise;
+
+namespace Detail {
+
+/**
+ * # Result shared by the promise and its future
+ * Single producer sets the result, single consumer subscribes the continuation, in any order. Both sides
+ * publish their part with one atomic OR on the flags and whoever comes second runs the continuation, so
+ * there is no lock on the way: continuation runs right in the producer thread, or in the consumer one if
+ * the result has been there already.
+ */
+template <typename T> class shared_state {
+public:
+    shared_state() : _flags(0) {}
+
+    ~shared_state() {
+        if ((_flags.load(std::memory_order_relaxed) & kHasResult) && !_error) {
+            Value().~T();
+        }
+    }
+
+    shared_state(const shared_state &) = delete;
+    shared_state &operator=(const shared_state &) = delete;
+
+    void SetValue(T &&value) {
+        new (&_storage) T(std::move(value));
+        Publish();
+    }
+
+    void SetError(std::exception_ptr error) {
+        _error = std::move(error);
+        Publish();
+    }
+
+    // Continuation is called once result is set, state must not have one yet
+    void Subscribe(Task continuation) {
+        _continuation = std::move(continuation);
+        if (_flags.fetch_or(kHasContinuation, std::memory_order_acq_rel) & kHasResult) {
+            Run();
+        }
+    }
+
+    bool Ready() const { return _flags.load(std::memory_order_acquire) & kHasResult; }
+
+    // Valid once Ready() returns true
+    const std::exception_ptr &Error() const { return _error; }
+    T &Value() { return *reinterpret_cast<T *>(&_storage); }
+
+private:
+    static const unsigned kHasResult = 1;
+    static const unsigned kHasContinuation = 2;
+
+    void Publish() {
+        if (_flags.fetch_or(kHasResult, std::memory_order_acq_rel) & kHasContinuation) {
+            Run();
+        }
+    }
+
+    void Run() {
+        Task continuation = std::move(_continuation);
+        continuation();
+    }
+
+    std::atomic<unsigned> _flags;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+    std::exception_ptr _error;
+    Task _continuation;
+};
+
+// Sets the result of the state to what func returns, or to the exception it throws
+template <typename T, typename F> void Fulfil(shared_state<T> &state, F &func) {
+    T value;
+    try {
+        value = func();
+    } catch (...) {
+        state.SetError(std::current_exception());
+        return;
+    }
+    state.SetValue(std::move(value));
+}
+
+// Continuation of Then: passes the value of one state through func into the other
+template <typename T, typename R, typename F> struct then_callback {
+    void operator()() {
+        if (from->Error()) {
+            to->SetError(from->Error());
+            return;
+        }
+        auto call = [this] { return func(std::move(from->Value())); };
+        Fulfil(*to, call);
+    }
+
+    std::shared_ptr<shared_state<T>> from;
+    std::shared_ptr<shared_state<R>> to;
+    F func;
+};
+
+// Continuation of Then with the pool: hands then_callback over to the pool
+template <typename Pool, typename Callback> struct schedule_callback {
+    void operator()() {
+        auto to = callback.to;
+        if (!pool->Execute(std::move(callback))) {
+            to->SetError(std::make_exception_ptr(std::runtime_error("Executor rejected the continuation")));
+        }
+    }
+
+    Pool *pool;
+    Callback callback;
+};
+
+// Task of Async: sets the result of the call
+template <typename R, typename Bound> struct async_task {
+    void operator()() { Fulfil(*to, bound); }
+
+    std::shared_ptr<shared_state<R>> to;
+    Bound bound;
+};
+
+template <typename T> Future<T> MakeFuture(std::shared_ptr<shared_state<T>> state);
+
+} // namespace Detail
+
+/**
+ * # Write side of the Future
+ * Result is set once, by SetValue or SetException. Promise destroyed without setting the result breaks
+ * it: future gets std::runtime_error
+ */
+template <typename T> class Promise {
+public:
+    Promise() : _state(std::make_shared<Detail::shared_state<T>>()), _future_taken(false) {}
+
+    Promise(Promise &&other) = default;
+    Promise &operator=(Promise &&other) = default;
+
+    ~Promise() {
+        if (_state && _future_taken) {
+            _state->SetError(std::make_exception_ptr(std::runtime_error("Broken promise")));
+        }
+    }
+
+    /**
+     * Returns future of the result, could be called once
+     */
+    Future<T> GetFuture() {
+        if (_future_taken) {
+            throw std::logic_error("Future has been taken already");
+        }
+        _future_taken = true;
+        return Future<T>(_state);
+    }
+
+    void SetValue(T value) { Take()->SetValue(std::move(value)); }
+
+    void SetException(std::exception_ptr error) { Take()->SetError(std::move(error)); }
+
+private:
+    std::shared_ptr<Detail::shared_state<T>> Take() {
+        if (!_state) {
+            throw std::logic_error("Promise result has been set already");
+        }
+        return std::move(_state);
+    }
+
+    std::shared_ptr<Detail::shared_state<T>> _state;
+    bool _future_taken;
+};
+
+/**
+ * # Result of the asynchronous operation
+ * Future is the single consumer of the result: it is either waited for by Get or passed into the
+ * continuation by Then, both leave the future invalid. Continuation runs right where the result appears:
+ * in the thread setting the result, or inline in Then if it is ready already, so it should be short;
+ * anything longer goes to the pool with Then(pool, func).
+ *
+ * Both T and the results of continuations must be default constructible and movable, there is no
+ * Future<void>
+ */
+template <typename T> class Future {
+public:
+    Future() = default;
+    Future(Future &&other) = default;
+    Future &operator=(Future &&other) = default;
+
+    bool Valid() const { return bool(_state); }
+
+    // Whether the result is set, future must be valid
+    bool Ready() const { return _state->Ready(); }
+
+    /**
+     * Blocks until result is set and returns it, or throws the exception it has been set to
+     */
+    T Get() {
+        std::shared_ptr<Detail::shared_state<T>> state = Take();
+        if (!state->Ready()) {
+            struct waiter {
+                std::mutex mutex;
+                std::condition_variable cv;
+                bool done = false;
+            };
+            auto w = std::make_shared<waiter>();
+            state->Subscribe(Task([w] {
+                std::lock_guard<std::mutex> lock(w->mutex);
+                w->done = true;
+                w->cv.notify_all();
+            }));
+            std::unique_lock<std::mutex> lock(w->mutex);
+            w->cv.wait(lock, [&w] { return w->done; });
+        }
+
+        if (state->Error()) {
+            std::rethrow_exception(state->Error());
+        }
+        return std::move(state->Value());
+    }
+
+    /**
+     * Returns future of func(value), func is called once this future is ready. Exception of this future,
+     * or the one thrown by func, goes to the returned future
+     */
+    template <typename F> Future<typename std::result_of<F(T)>::type> Then(F &&func) {
+        using R = typename std::result_of<F(T)>::type;
+        auto next = std::make_shared<Detail::shared_state<R>>();
+        auto state = Take();
+        Detail::shared_state<T> &from = *state;
+        from.Subscribe(Detail::then_callback<T, R, typename std::decay<F>::type>{std::move(state), next,
+                                                                                 std::forward<F>(func)});
+        return Future<R>(std::move(next));
+    }
+
+    /**
+     * Same as Then, but func is executed on the pool, Executor or StealingExecutor. If the pool rejects
+     * it, returned future gets std::runtime_error
+     */
+    template <typename Pool, typename F> Future<typename std::result_of<F(T)>::type> Then(Pool &pool, F &&func) {
+        using R = typename std::result_of<F(T)>::type;
+        using callback = Detail::then_callback<T, R, typename std::decay<F>::type>;
+        auto next = std::make_shared<Detail::shared_state<R>>();
+        auto state = Take();
+        Detail::shared_state<T> &from = *state;
+        from.Subscribe(Detail::schedule_callback<Pool, callback>{
+            &pool, callback{std::move(state), next, std::forward<F>(func)}});
+        return Future<R>(std::move(next));
+    }
+
+private:
+    template <typename U> friend class Future;
+    template <typename U> friend class Promise;
+    template <typename U> friend Future<std::vector<U>> WhenAll(std::vector<Future<U>> futures);
+    template <typename U> friend Future<U> Detail::MakeFuture(std::shared_ptr<Detail::shared_state<U>> state);
+
+    explicit Future(std::shared_ptr<Detail::shared_state<T>> state) : _state(std::move(state)) {}
+
+    std::shared_ptr<Detail::shared_state<T>> Take() {
+        if (!_state) {
+            throw std::logic_error("Future is not valid");
+        }
+        return std::move(_state);
+    }
+
+    std::shared_ptr<Detail::shared_state<T>> _state;
+};
+
+namespace Detail {
+template <typename T> Future<T> MakeFuture(std::shared_ptr<shared_state<T>> state) {
+    return Future<T>(std::move(state));
+}
+} // namespace Detail
+
+/**
+ * Returns future that is ready with the given value
+ */
+template <typename T> Future<typename std::decay<T>::type> MakeReadyFuture(T &&value) {
+    Promise<typename std::decay<T>::type> promise;
+    Future<typename std::decay<T>::type> future = promise.GetFuture();
+    promise.SetValue(std::forward<T>(value));
+    return future;
+}
+
+/**
+ * Runs func(args...) on the pool, Executor or StealingExecutor, and returns the future of its result. If
+ * the pool rejects the task future gets std::runtime_error
+ */
+template <typename Pool, typename F, typename... Types>
+Future<typename std::result_of<F(Types...)>::type> Async(Pool &pool, F &&func, Types... args) {
+    using R = typename std::result_of<F(Types...)>::type;
+    auto bound = std::bind(std::forward<F>(func), std::move(args)...);
+    auto state = std::make_shared<Detail::shared_state<R>>();
+    Future<R> future = Detail::MakeFuture(state);
+    if (!pool.Execute(Detail::async_task<R, decltype(bound)>{state, std::move(bound)})) {
+        state->SetError(std::make_exception_ptr(std::runtime_error("Executor rejected the task")));
+    }
+    return future;
+}
+
+/**
+ * Returns future of all the values, in the same order, ready once every future is. The first exception of
+ * any of them goes to the returned future, the other results are dropped
+ */
+template <typename T> Future<std::vector<T>> WhenAll(std::vector<Future<T>> futures) {
+    struct gather {
+        explicit gather(std::size_t n) : values(n), left(n), failed(false) {}
+
+        std::vector<T> values;
+        std::atomic<std::size_t> left;
+        std::atomic<bool> failed;
+        Promise<std::vector<T>> promise;
+    };
+
+    auto g = std::make_shared<gather>(futures.size());
+    Future<std::vector<T>> result = g->promise.GetFuture();
+    if (futures.empty()) {
+        g->promise.SetValue(std::vector<T>());
+        return result;
+    }
+
+    for (std::size_t i = 0; i < futures.size(); i++) {
+        auto state = futures[i].Take();
+        Detail::shared_state<T> &from = *state;
+        from.Subscribe(Task([g, state, i] {
+            if (state->Error()) {
+                if (!g->failed.exchange(true)) {
+                    g->promise.SetException(state->Error());
+                }
+            } else {
+                g->values[i] = std::move(state->Value());
+            }
+            if (g->left.fetch_sub(1, std::memory_order_acq_rel) == 1 && !g->failed.load()) {
+                g->promise.SetValue(std::move(g->values));
+            }
+        }));
+    }
+    return result;
+}
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_FUTURE_H
@@ -0,0 +1,148 @@
+#ifndef AFINA_CONCURRENCY_LOCK_FREE_STACK_H
+#define AFINA_CONCURRENCY_LOCK_FREE_STACK_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Lock-free stack
+ * Treiber stack of values. Nodes are owned by the stack and live as long as the stack does: popped node
+ * goes to the internal free list, also a Treiber stack, and is reused by the next push. So reading a node
+ * that is being popped concurrently is always safe, and ABA is ruled out by the tag in the upper half of
+ * the head word: nodes are addressed by 32 bit index, so index and tag fit into a single 64 bit CAS.
+ *
+ * Node table is a sequence of chunks of doubling size, growing it never moves existing nodes. Growth is
+ * the only place taking a lock, once stack has seen its peak size both Push and Pop are lock-free.
+ *
+ * T must be default constructible and movable
+ */
+template <typename T> class LockFreeStack {
+public:
+    LockFreeStack() : _items(0), _free(0), _chunks_count(0) {
+        for (auto &c : _chunks) {
+            c.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~LockFreeStack() {
+        for (auto &c : _chunks) {
+            delete[] c.load(std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeStack(const LockFreeStack &) = delete;
+    LockFreeStack &operator=(const LockFreeStack &) = delete;
+
+    /**
+     * Puts value on top of the stack, throws std::bad_alloc if there is no memory for the new node
+     */
+    void Push(T value) {
+        uint32_t index = Take(_free);
+        if (index == 0) {
+            index = Grow();
+        }
+
+        Node(index).value = std::move(value);
+        Put(_items, index);
+    }
+
+    /**
+     * Takes value from the top of the stack, returns false if stack is empty
+     */
+    bool Pop(T &value) {
+        uint32_t index = Take(_items);
+        if (index == 0) {
+            return false;
+        }
+
+        value = std::move(Node(index).value);
+        Put(_free, index);
+        return true;
+    }
+
+private:
+    struct node {
+        T value;
+        std::atomic<uint32_t> next;
+    };
+
+    // Chunk k holds nodes with indices [2^k, 2^(k+1)), index 0 means no node
+    static const size_t kChunks = 32;
+
+    node &Node(uint32_t index) {
+        unsigned chunk = 31 - __builtin_clz(index);
+        return _chunks[chunk].load(std::memory_order_acquire)[index - (uint32_t(1) << chunk)];
+    }
+
+    static uint64_t Head(uint64_t old, uint32_t index) { return (((old >> 32) + 1) << 32) | index; }
+
+    // Pushes node onto the given list
+    void Put(std::atomic<uint64_t> &head, uint32_t index) {
+        node &n = Node(index);
+        uint64_t old = head.load(std::memory_order_relaxed);
+        do {
+            n.next.store(uint32_t(old), std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(old, Head(old, index), std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+    // Pops node from the given list, returns 0 if list is empty
+    uint32_t Take(std::atomic<uint64_t> &head) {
+        uint64_t old = head.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t index = uint32_t(old);
+            if (index == 0) {
+                return 0;
+            }
+
+            // Node could be popped and reused meanwhile, tag makes CAS fail in that case
+            uint32_t next = Node(index).next.load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(old, Head(old, next), std::memory_order_acquire,
+                                           std::memory_order_acquire)) {
+                return index;
+            }
+        }
+    }
+
+    // Adds the next chunk, returns one of its nodes and puts all the others onto the free list
+    uint32_t Grow() {
+        std::lock_guard<std::mutex> lock(_grow_mutex);
+
+        // Someone else could have grown the table already
+        uint32_t index = Take(_free);
+        if (index != 0) {
+            return index;
+        }
+
+        if (_chunks_count == kChunks) {
+            throw std::bad_alloc();
+        }
+
+        size_t chunk = _chunks_count++;
+        uint32_t first = uint32_t(1) << chunk;
+        _chunks[chunk].store(new node[first], std::memory_order_release);
+        for (uint32_t i = 1; i < first; i++) {
+            Put(_free, first + i);
+        }
+        return first;
+    }
+
+    // Top of the stack and top of the free list: tag in the upper half, node index in the lower one
+    std::atomic<uint64_t> _items;
+    std::atomic<uint64_t> _free;
+
+    // Node table, chunks are only added under the mutex
+    std::atomic<node *> _chunks[kChunks];
+    size_t _chunks_count;
+    std::mutex _grow_mutex;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_LOCK_FREE_STACK_H
@@ -0,0 +1,147 @@
+#ifndef AFINA_CONCURRENCY_MPMC_QUEUE_H
+#define AFINA_CONCURRENCY_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Bounded lock-free queue
+ * Multi-producer multi-consumer ring buffer by Dmitry Vyukov. Every cell carries a sequence number telling
+ * which lap of the ring it is ready for: producer claims position by CAS on the enqueue counter once the
+ * cell of that position is free, writes the value and publishes it by bumping the sequence, consumer does
+ * the same on the other side. Producers and consumers only meet on a cell when the queue is full or
+ * empty, and a stalled thread blocks just the one cell it holds.
+ *
+ * Values are constructed right in the cells, nothing is allocated after construction. Counters sit on
+ * separate cache lines, so producers don't invalidate the line consumers spin on.
+ *
+ * Capacity is rounded up to the power of two. T must be default constructible and nothrow movable
+ */
+template <typename T> class MPMCQueue {
+public:
+    static_assert(std::is_nothrow_move_constructible<T>::value, "Values are moved in and out of the cells");
+
+    explicit MPMCQueue(std::size_t capacity) : _enqueue(0), _dequeue(0) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive");
+        }
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _cells.reset(new cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MPMCQueue() {
+        T value;
+        while (TryPop(value)) {
+        }
+    }
+
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+    /**
+     * Moves value into the queue, returns false and leaves value as is if queue is full
+     */
+    bool TryPush(T &&value) {
+        std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+        cell *c;
+        for (;;) {
+            c = &_cells[pos & _mask];
+            std::size_t seq = c->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Cell still holds the value of the previous lap
+                return false;
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (&c->storage) T(std::move(value));
+        c->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Moves the oldest value out of the queue, returns false if queue is empty
+     */
+    bool TryPop(T &value) {
+        std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+        cell *c;
+        for (;;) {
+            c = &_cells[pos & _mask];
+            std::size_t seq = c->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Value of this lap is not published yet
+                return false;
+            } else {
+                pos = _dequeue.load(std::memory_order_relaxed);
+            }
+        }
+
+        T *stored = reinterpret_cast<T *>(&c->storage);
+        value = std::move(*stored);
+        stored->~T();
+        c->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of values, approximate if queue is being modified
+    std::size_t Size() const {
+        std::size_t enqueue = _enqueue.load(std::memory_order_relaxed);
+        std::size_t dequeue = _dequeue.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+
+    std::size_t Capacity() const { return _mask + 1; }
+
+private:
+    static const std::size_t kCacheLine = 64;
+
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    char _padding0[kCacheLine];
+    std::unique_ptr<cell[]> _cells;
+    std::size_t _mask;
+    char _padding1[kCacheLine - sizeof(std::unique_ptr<cell[]>) - sizeof(std::size_t)];
+
+    // Next position to push to
+    std::atomic<std::size_t> _enqueue;
+    char _padding2[kCacheLine - sizeof(std::atomic<std::size_t>)];
+
+    // Next position to pop from
+    std::atomic<std::size_t> _dequeue;
+    char _padding3[kCacheLine - sizeof(std::atomic<std::size_t>)];
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MPMC_QUEUE_H
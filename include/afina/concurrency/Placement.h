@@ -0,0 +1,105 @@
+#ifndef AFINA_CONCURRENCY_PLACEMENT_H
+#define AFINA_CONCURRENCY_PLACEMENT_H
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+namespace Afina {
+namespace Concurrency {
+
+// Logical CPU and where it is
+struct CpuInfo {
+    int id;
+    int node;
+    int package;
+    int core;
+};
+
+/**
+ * # CPU topology
+ * Logical CPUs along with their NUMA node, package and core, read from the sysfs. Whatever is missing
+ * there is filled with the simplest guess: no online list means every CPU the process may run on, no
+ * topology of the CPU means a core of its own on package 0, no node link means node 0
+ */
+class Topology {
+public:
+    explicit Topology(std::vector<CpuInfo> cpus = std::vector<CpuInfo>());
+
+    /**
+     * @param root sysfs directory of the CPUs
+     * @param allowed_only drop CPUs the process is not allowed to run on
+     */
+    static Topology Detect(const std::string &root = "/sys/devices/system/cpu", bool allowed_only = true);
+
+    // Sorted by id
+    const std::vector<CpuInfo> &Cpus() const { return _cpus; }
+
+    // Number of distinct NUMA nodes
+    std::size_t Nodes() const;
+
+private:
+    std::vector<CpuInfo> _cpus;
+};
+
+/**
+ * # Thread placement policy
+ * Maps the index of the thread within its group, like the worker number, to the CPU it is pinned to:
+ *  - kNone: threads keep the default affinity, scheduler moves them as it likes
+ *  - kPin: thread i goes to the i-th CPU by id, whatever the topology is
+ *  - kCompact: threads fill the node before going to the next one, SMT siblings next to each other, so
+ *    threads sharing data share caches too
+ *  - kSpread: threads go round robin over the nodes, then over the cores of the node, and only then to the
+ *    SMT siblings, so every thread gets as much cache and memory bandwidth as there is
+ * Threads beyond the number of CPUs wrap around. Placement of kNone, as well as the one without CPUs, is
+ * a no-op
+ */
+class Placement {
+public:
+    enum class Mode { kNone, kPin, kCompact, kSpread };
+
+    // No placement at all, topology is not read
+    Placement();
+
+    // Placement over the topology of this machine
+    explicit Placement(Mode mode);
+
+    Placement(Mode mode, const Topology &topology);
+
+    /**
+     * Parses mode name: none, pin, compact or spread
+     */
+    static Mode ParseMode(const std::string &name);
+
+    Mode GetMode() const { return _mode; }
+
+    /**
+     * CPU of the thread with the given index, -1 if it is not placed
+     */
+    int CpuFor(std::size_t index) const;
+
+    /**
+     * NUMA node of the thread with the given index, -1 if it is not placed
+     */
+    int NodeFor(std::size_t index) const;
+
+    /**
+     * Pins thread to the CPU of the index, returns false if the system refused
+     */
+    bool Apply(pthread_t thread, std::size_t index) const;
+    bool Apply(std::thread &thread, std::size_t index) const { return Apply(thread.native_handle(), index); }
+
+private:
+    Mode _mode;
+
+    // CPUs in the order threads are placed on
+    std::vector<CpuInfo> _order;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_PLACEMENT_H
@@ -0,0 +1,177 @@
+#ifndef AFINA_CONCURRENCY_SCHEDULER_H
+#define AFINA_CONCURRENCY_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Task.h>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Delayed and periodic tasks
+ * Single timer thread over the hierarchical timing wheel: four levels of 64 slots each, level l slot
+ * covers 64^l ticks. Timer goes to the lowest level whose current rotation contains its expiration tick,
+ * when the rotation of the upper level reaches its slot timers of that slot are spread over the levels
+ * below, and the level 0 slot of the current tick is fired. Timers further than 64^4 ticks wait in the
+ * overflow list, looked at once per top level rotation.
+ *
+ * Timers are intrusive list nodes taken from the pool and addressed by index and generation, so both
+ * scheduling and cancellation are O(1) and allocate nothing once the pool has grown. Timer thread sleeps
+ * until the next non-empty slot of level 0 or the next cascade, not every tick.
+ *
+ * Tasks are executed right on the timer thread, one by one, so they must be short: anything longer should
+ * be handed to the Executor from the task. Exceptions thrown by tasks are swallowed
+ */
+class Scheduler {
+public:
+    // Identifier of the scheduled timer, kNoTimer is never returned for a scheduled one
+    using TimerId = std::uint64_t;
+    static const TimerId kNoTimer = 0;
+
+    /**
+     * @param name name of the timer thread
+     * @param tick resolution of the timers, delays are rounded up to it
+     */
+    explicit Scheduler(std::string name, std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    /**
+     * Stops the timer thread, timers that are not fired yet are dropped. Waits for the task being executed
+     * if any, so must not be called from a task
+     */
+    void Stop();
+
+    /**
+     * Executes func(args...) once, after delay. Returns kNoTimer if scheduler is stopped
+     */
+    template <typename F, typename... Types>
+    TimerId ScheduleAfter(std::chrono::milliseconds delay, F &&func, Types... args) {
+        return Schedule(delay, std::chrono::milliseconds(0),
+                        Task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+    }
+
+    /**
+     * Executes func(args...) every period, the first time after one period. Fixed rate: slow execution
+     * delays the next run, but does not shift the ones after it. Returns kNoTimer if scheduler is stopped
+     */
+    template <typename F, typename... Types>
+    TimerId ScheduleEvery(std::chrono::milliseconds period, F &&func, Types... args) {
+        if (period.count() <= 0) {
+            throw std::invalid_argument("Timer period must be positive");
+        }
+        return Schedule(period, period, Task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+    }
+
+    /**
+     * Cancels the timer, returns true if it is not going to run anymore: false for the timer that has
+     * fired already, or the one-shot timer being executed right now. Periodic timer could be cancelled
+     * from its own task
+     */
+    bool Cancel(TimerId id);
+
+    // Number of scheduled timers
+    std::size_t Size();
+
+private:
+    static const unsigned kLevelBits = 6;
+    static const std::size_t kSlots = std::size_t(1) << kLevelBits;
+    static const std::size_t kLevels = 4;
+
+    struct link {
+        link *prev;
+        link *next;
+    };
+
+    struct timer : link {
+        // Expiration tick
+        std::uint64_t expires;
+
+        // Period in ticks, zero for one-shot timer
+        std::uint64_t period;
+
+        // Position in the pool
+        std::uint32_t index;
+
+        // Bumped every time node is released, so that stale ids miss
+        std::uint32_t generation;
+
+        // Node is in the wheel, otherwise it is free or being executed
+        bool scheduled;
+
+        // Cancelled while being executed
+        bool cancelled;
+
+        Task task;
+    };
+
+    TimerId Schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task task);
+
+    // Timer thread body
+    void Perform();
+
+    // Tick the steady clock is at now
+    std::uint64_t Now() const;
+
+    // Puts timer into the slot of its expiration tick, relative to the current tick
+    void Insert(timer *t);
+
+    // Moves every timer of the list back to the wheel
+    void Cascade(link &list);
+
+    // Advances current tick by one and moves timers that expire on it into the expired list
+    void Advance(std::vector<timer *> &expired);
+
+    // Tick the timer thread has to wake up at
+    std::uint64_t NextWakeup() const;
+
+    // Returns node to the pool
+    void Release(timer *t);
+
+    static void Unlink(link *l);
+    static void PushBack(link &list, link *l);
+
+    const std::string _name;
+    const std::chrono::steady_clock::duration _tick;
+    const std::chrono::steady_clock::time_point _start;
+
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    bool _running;
+
+    // Last tick processed by the timer thread
+    std::uint64_t _current;
+
+    // Tick timer thread sleeps until
+    std::uint64_t _next_wakeup;
+
+    // Number of timers in the wheel
+    std::size_t _size;
+
+    link _wheel[kLevels][kSlots];
+    link _overflow;
+
+    // Pool of timer nodes, index is a part of the TimerId
+    std::vector<std::unique_ptr<timer>> _timers;
+    std::vector<std::uint32_t> _free;
+
+    std::thread _thread;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SCHEDULER_H
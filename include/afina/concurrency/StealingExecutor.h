@@ -0,0 +1,146 @@
+#ifndef AFINA_CONCURRENCY_STEALING_EXECUTOR_H
+#define AFINA_CONCURRENCY_STEALING_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Placement.h>
+#include <afina/concurrency/Task.h>
+#include <afina/concurrency/WorkStealingDeque.h>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Work stealing thread pool
+ * Same contract as Executor, but with no global queue: every worker owns a WorkStealingDeque. Task added
+ * by a worker goes to its own deque and is popped LIFO by the same worker, while it is still hot in the
+ * cache. Task added from outside goes to the inbox of the next worker, round robin, so that submitters
+ * contend on many small locks rather than one. Worker out of work drains its inbox and then steals from
+ * the top of deques of randomly chosen workers. Only workers that found nothing at all go to sleep, on
+ * the shared condition variable.
+ *
+ * Number of threads is fixed and there is no bound on the queued tasks. Exceptions thrown by tasks are
+ * swallowed. Stop(true) must not be called from a task of the same pool
+ */
+class StealingExecutor {
+public:
+    enum class State {
+        // Tasks could be added and get executed
+        kRun,
+
+        // No new task could be added, queued ones are still executed
+        kStopping,
+
+        // All threads are stopped
+        kStopped
+    };
+
+    /**
+     * @param name prefix of the thread names
+     * @param size number of worker threads
+     * @param placement CPUs of the workers, worker i is placed as the i-th thread
+     */
+    StealingExecutor(std::string name, std::size_t size, Placement placement = Placement());
+    ~StealingExecutor();
+
+    StealingExecutor(const StealingExecutor &) = delete;
+    StealingExecutor &operator=(const StealingExecutor &) = delete;
+
+    /**
+     * Signal pool to stop, it stops accepting new tasks, threads exit once every queued task is done.
+     * If await flag is true, call won't return until all threads are stopped
+     */
+    void Stop(bool await = false);
+
+    /**
+     * Add function to be executed on the pool, returns false if pool is stopping. See Executor::Execute
+     */
+    template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
+        std::unique_ptr<task> exec(new task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+        if (!Submit(exec.get())) {
+            return false;
+        }
+        exec.release();
+        return true;
+    }
+
+    // Current state of the pool
+    State GetState() const { return _state.load(); }
+
+    // Number of worker threads
+    std::size_t Size() const { return _workers.size(); }
+
+private:
+    using task = Task;
+
+    struct worker {
+        WorkStealingDeque<task> deque;
+
+        // Tasks added from outside of the pool
+        std::mutex inbox_mutex;
+        std::deque<task *> inbox;
+
+        // Seed of the victim choice
+        uint32_t random;
+
+        std::thread thread;
+    };
+
+    // Schedules task owned by the caller, returns false if pool is stopping
+    bool Submit(task *t);
+
+    // Main loop of the worker thread
+    void Perform(std::size_t index);
+
+    // Finds next task for the worker: own deque, own inbox, then deques of the others
+    task *Next(worker &w);
+
+    // Takes tasks of the inbox into the deque, returns one of them
+    task *DrainInbox(worker &w);
+
+    // Steals task from the randomly chosen workers
+    task *Steal(worker &w);
+
+    // Returns true if any worker has queued tasks
+    bool HasWork();
+
+    // Wakes sleeping workers if there are any, one or all of them
+    void Wake(bool all);
+
+    const std::string _name;
+    std::vector<std::unique_ptr<worker>> _workers;
+
+    std::atomic<State> _state;
+
+    // Tasks added but not finished yet, workers exit once it is 0 and pool is stopping
+    std::atomic<std::size_t> _pending;
+
+    // Worker to get the next task from outside
+    std::atomic<std::size_t> _next_inbox;
+
+    // Threads not exited yet, the last one marks pool stopped
+    std::atomic<std::size_t> _alive;
+
+    // Workers that found no tasks and sleep on _wakeup
+    std::atomic<std::size_t> _sleeping;
+    std::mutex _sleep_mutex;
+    std::condition_variable _wakeup;
+
+    // Joins threads once
+    std::mutex _join_mutex;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_STEALING_EXECUTOR_H
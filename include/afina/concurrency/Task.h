@@ -0,0 +1,135 @@
+#ifndef AFINA_CONCURRENCY_TASK_H
+#define AFINA_CONCURRENCY_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Move-only callable
+ * Replacement of std::function<void()> for tasks handed between threads. Callable of up to kInlineSize
+ * bytes that is nothrow movable is kept right inside of the Task, so a lambda with a few captures or
+ * std::bind of a method with a couple of arguments costs no allocation at all. Bigger ones go to the
+ * heap.
+ *
+ * Unlike std::function Task is move-only, so it could hold move-only captures, and the whole object takes
+ * a single cache line
+ */
+class Task {
+public:
+    // Largest callable stored without allocation
+    static const std::size_t kInlineSize = 48;
+
+    // Whether callable of type F is stored inline
+    template <typename F>
+    struct fits_inline
+        : std::integral_constant<bool, sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+                                           std::is_nothrow_move_constructible<F>::value> {};
+
+    Task() noexcept : _ops(nullptr) {}
+
+    template <typename F, typename = typename std::enable_if<
+                              !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F &&func) : _ops(nullptr) {
+        using type = typename std::decay<F>::type;
+        Construct<type>(std::forward<F>(func), fits_inline<type>());
+    }
+
+    Task(Task &&other) noexcept : _ops(other._ops) {
+        if (_ops != nullptr) {
+            _ops->move(&other._storage, &_storage);
+            other._ops = nullptr;
+        }
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            Reset();
+            if (other._ops != nullptr) {
+                other._ops->move(&other._storage, &_storage);
+                _ops = other._ops;
+                other._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task &operator=(std::nullptr_t) noexcept {
+        Reset();
+        return *this;
+    }
+
+    ~Task() { Reset(); }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    explicit operator bool() const noexcept { return _ops != nullptr; }
+
+    /**
+     * Calls the callable, task must not be empty
+     */
+    void operator()() { _ops->invoke(&_storage); }
+
+private:
+    // Operations of the stored callable: move leaves source destroyed
+    struct ops {
+        void (*invoke)(void *storage);
+        void (*move)(void *from, void *to);
+        void (*destroy)(void *storage);
+    };
+
+    template <typename F> struct inline_ops {
+        static F &Get(void *storage) { return *static_cast<F *>(storage); }
+        static void Invoke(void *storage) { Get(storage)(); }
+        static void Move(void *from, void *to) noexcept {
+            new (to) F(std::move(Get(from)));
+            Get(from).~F();
+        }
+        static void Destroy(void *storage) noexcept { Get(storage).~F(); }
+        static const ops table;
+    };
+
+    template <typename F> struct heap_ops {
+        static F *&Get(void *storage) { return *static_cast<F **>(storage); }
+        static void Invoke(void *storage) { (*Get(storage))(); }
+        static void Move(void *from, void *to) noexcept { new (to) F *(Get(from)); }
+        static void Destroy(void *storage) noexcept { delete Get(storage); }
+        static const ops table;
+    };
+
+    template <typename F, typename A> void Construct(A &&func, std::true_type) {
+        new (&_storage) F(std::forward<A>(func));
+        _ops = &inline_ops<F>::table;
+    }
+
+    template <typename F, typename A> void Construct(A &&func, std::false_type) {
+        new (&_storage) F *(new F(std::forward<A>(func)));
+        _ops = &heap_ops<F>::table;
+    }
+
+    void Reset() noexcept {
+        if (_ops != nullptr) {
+            _ops->destroy(&_storage);
+            _ops = nullptr;
+        }
+    }
+
+    typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type _storage;
+    const ops *_ops;
+};
+
+template <typename F>
+const Task::ops Task::inline_ops<F>::table = {&inline_ops<F>::Invoke, &inline_ops<F>::Move, &inline_ops<F>::Destroy};
+
+template <typename F>
+const Task::ops Task::heap_ops<F>::table = {&heap_ops<F>::Invoke, &heap_ops<F>::Move, &heap_ops<F>::Destroy};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_TASK_H
@@ -1,10 +1,112 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per thread instance of T
+ * Each thread gets its own instance of T, created by the factory on the first Get() from that thread and
+ * destroyed when the thread exits. Unlike thread_local variables ThreadLocal is an ordinary object, so
+ * there could be any number of them, each with its own set of instances.
+ *
+ * Instances of threads that are still alive are destroyed along with the ThreadLocal itself, so no thread
+ * may use it, or exit after using it, while ThreadLocal is being destroyed.
+ */
+template <typename T> class ThreadLocal {
+public:
+    explicit ThreadLocal(std::function<T *()> factory = [] { return new T(); }) : _factory(std::move(factory)) {
+        int err = pthread_key_create(&_key, &ThreadLocal::Release);
+        if (err != 0) {
+            throw std::runtime_error("Failed to create thread local key: " + std::string(strerror(err)));
+        }
+    }
+
+    ~ThreadLocal() {
+        // No more destructor calls on thread exit
+        pthread_key_delete(_key);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (holder *h : _holders) {
+            delete h;
+        }
+    }
+
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    /**
+     * Returns instance of the calling thread
+     */
+    T &Get() {
+        holder *h = static_cast<holder *>(pthread_getspecific(_key));
+        if (h == nullptr) {
+            h = Create();
+        }
+        return *h->value;
+    }
+
+    /**
+     * Number of threads having an instance
+     */
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _holders.size();
+    }
+
+private:
+    // Instance along with its owner, so that thread exit could find the way back
+    struct holder {
+        ThreadLocal *owner;
+        std::unique_ptr<T> value;
+    };
+
+    holder *Create() {
+        std::unique_ptr<holder> h(new holder{this, std::unique_ptr<T>(_factory())});
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _holders.insert(h.get());
+        }
+
+        int err = pthread_setspecific(_key, h.get());
+        if (err != 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _holders.erase(h.get());
+            throw std::runtime_error("Failed to set thread local value: " + std::string(strerror(err)));
+        }
+        return h.release();
+    }
+
+    // Called on thread exit for each non null value
+    static void Release(void *ptr) {
+        holder *h = static_cast<holder *>(ptr);
+        {
+            std::lock_guard<std::mutex> lock(h->owner->_mutex);
+            h->owner->_holders.erase(h);
+        }
+        delete h;
+    }
+
+    const std::function<T *()> _factory;
+
+    pthread_key_t _key;
+
+    // Guards instances set
+    std::mutex _mutex;
+
+    // Instances of all live threads
+    std::set<holder *> _holders;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,145 @@
+#ifndef AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+#define AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Work stealing deque
+ * Chase-Lev deque of pointers, in the form given by Le, Pop, Cohen and Nardelli for the C11 memory model.
+ * Owner thread pushes and pops at the bottom, LIFO, so it keeps working on the hottest data, any other
+ * thread steals from the top, FIFO, taking the oldest and usually the largest piece of work. Owner
+ * operations are a couple of plain loads and stores, CAS is only needed when the owner and a thief race
+ * for the last item.
+ *
+ * Ring buffer doubles when full. Old buffers are kept until the deque is destroyed, a thief could still be
+ * reading from one, that costs at most as much as the current buffer.
+ *
+ * Push and Pop must only be called by the owner thread, Steal and Size by any thread
+ */
+template <typename T> class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::size_t capacity = 256) : _top(0), _bottom(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _buffers.emplace_back(new ring(size));
+        _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    /**
+     * Puts item at the bottom, throws std::bad_alloc if buffer could not grow
+     */
+    void Push(T *item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        ring *r = _buffer.load(std::memory_order_relaxed);
+        if (b - t > int64_t(r->mask)) {
+            r = Grow(r, t, b);
+        }
+        r->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Takes item from the bottom, returns nullptr if deque is empty
+     */
+    T *Pop() {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        ring *r = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = r->Get(b);
+        if (t == b) {
+            // The last one, thieves could take it as well
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * Takes item from the top, returns nullptr if deque is empty or some other thread has won the race
+     * for the item
+     */
+    T *Steal() {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        T *item = _buffer.load(std::memory_order_acquire)->Get(t);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Number of items, approximate if deque is being modified
+    std::size_t Size() const {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? std::size_t(b - t) : 0;
+    }
+
+private:
+    // Ring buffer of power of two size, indexed by the ever growing positions
+    struct ring {
+        explicit ring(std::size_t size) : mask(size - 1), items(new std::atomic<T *>[size]) {}
+
+        T *Get(int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t i, T *item) { items[i & mask].store(item, std::memory_order_relaxed); }
+
+        const std::size_t mask;
+        std::unique_ptr<std::atomic<T *>[]> items;
+    };
+
+    // Copies live items into the buffer twice as big, called by the owner only
+    ring *Grow(ring *r, int64_t t, int64_t b) {
+        _buffers.emplace_back(new ring(2 * (r->mask + 1)));
+        ring *bigger = _buffers.back().get();
+        for (int64_t i = t; i < b; i++) {
+            bigger->Put(i, r->Get(i));
+        }
+        _buffer.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // Next position to steal from and next position to push to. Top is written by thieves and bottom by
+    // the owner, so they are kept a cache line apart
+    std::atomic<int64_t> _top;
+    char _padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> _bottom;
+
+    std::atomic<ring *> _buffer;
+
+    // Every buffer ever used, owned by the deque
+    std::vector<std::unique_ptr<ring>> _buffers;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_WORK_STEALING_DEQUE_H
@@ -1,10 +1,12 @@
 #ifndef AFINA_COROUTINE_ENGINE_H
 #define AFINA_COROUTINE_ENGINE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <string>
 #include <tuple>
 
 #include <setjmp.h>
@@ -15,11 +17,34 @@ namespace Coroutine {
 /**
  * # Entry point of coroutine library
  * Allows to run coroutine and schedule its execution. Not threadsafe
+ *
+ * Coroutines share the stack of the thread: on switch the part of the stack used by the suspended routine is
+ * copied into its own buffer and the one of the resumed routine is copied back. Buffers only grow and are
+ * kept along with the contexts of finished routines in the free list, so once routines got to their usual
+ * depth switching does not allocate. The flip side is that a routine must not hand out pointers to its own
+ * stack: while it is suspended that memory belongs to someone else
+ *
+ * Copying costs as much as the stack is deep, so there is the second mode where each coroutine owns the stack of
+ * its own mapped with the guard page below it, and switch just swaps callee saved registers and stack pointer.
+ * Switch is then O(1) and pointers to the stack of the routine stay valid, but every routine takes stack_size of
+ * address space (memory is committed as it gets touched only) and overflowing it is SIGSEGV on the guard page.
+ * Stacks are pooled along with the contexts. The mode is available on x86-64 and aarch64 only
  */
 class Engine final {
 public:
     using unblocker_func = std::function<void(Engine &)>;
 
+    enum class Mode {
+        // Routines run on the stack of the thread which is copied on switch
+        kCopyStack,
+
+        // Each routine has the stack of its own
+        kSeparateStack
+    };
+
+    // Stack of the routine in the kSeparateStack mode, guard page is not included
+    static const std::size_t kDefaultStackSize = 256 * 1024;
+
 private:
     /**
      * A single coroutine instance which could be scheduled for execution
@@ -33,9 +58,18 @@ private:
         // coroutine stack end address
         char *Hight = nullptr;
 
-        // coroutine stack copy buffer
+        // coroutine stack copy buffer and its capacity
         std::tuple<char *, uint32_t> Stack = std::make_tuple(nullptr, 0);
 
+        // Routine is in the "blocked" list rather than in "alive"
+        bool is_blocked = false;
+
+        // kSeparateStack: mapping of the stack along with its guard page, saved stack pointer and routine to start
+        char *Mapping = nullptr;
+        std::size_t MappingSize = 0;
+        void *StackPointer = nullptr;
+        std::function<void()> Entry;
+
         // Saved coroutine context (registers)
         jmp_buf Environment;
 
@@ -69,11 +103,26 @@ private:
      */
     context *idle_ctx;
 
+    /**
+     * Contexts of finished coroutines along with their stack buffers, linked by next
+     */
+    context *free_contexts;
+
     /**
      * Call when all coroutines are blocked
      */
     unblocker_func _unblocker;
 
+    /**
+     * How routines get their stacks
+     */
+    const Mode _mode;
+
+    /**
+     * kSeparateStack: size of the stack rounded up to pages
+     */
+    const std::size_t _stack_size;
+
 protected:
     /**
      * Save stack of the current coroutine in the given context
@@ -87,11 +136,54 @@ protected:
 
     static void null_unblocker(Engine &) {}
 
+    /**
+     * Takes context from the free list or allocates the new one
+     */
+    context *NewContext();
+
+    /**
+     * Puts context into the free list, its stack buffer is kept
+     */
+    void FreeContext(context *ctx);
+
+    /**
+     * Suspends current routine, if any, and passes control to the given context
+     */
+    void Enter(context &ctx);
+
+    /**
+     * kSeparateStack: registers new routine on the stack of its own, nullptr if there is no memory for the stack
+     */
+    void *Spawn(std::function<void()> entry);
+
+    /**
+     * kSeparateStack: runs routines until there is nothing to run and unblocker doesn't help
+     */
+    void Loop(context *main);
+
+    /**
+     * kSeparateStack: first function on the stack of a routine, never returns
+     */
+    static void Boot(void *engine);
+
+    // Arguments of run() are bound as they are passed: lvalues by reference and rvalues by value
+    template <typename T> static std::reference_wrapper<T> Keep(T &value) { return std::ref(value); }
+    template <typename T> static T &&Keep(T &&value) { return std::forward<T>(value); }
+
 public:
     Engine(unblocker_func unblocker = null_unblocker)
-        : StackBottom(0), cur_routine(nullptr), alive(nullptr), _unblocker(unblocker) {}
+        : StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr),
+          free_contexts(nullptr), _unblocker(unblocker), _mode(Mode::kCopyStack), _stack_size(0) {}
+
+    /**
+     * @param mode how routines get their stacks, throws std::invalid_argument if mode isn't supported here
+     * @param stack_size size of the stack of the routine in kSeparateStack mode
+     */
+    explicit Engine(Mode mode, std::size_t stack_size = kDefaultStackSize,
+                    unblocker_func unblocker = null_unblocker);
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
+    ~Engine();
 
     /**
      * Gives up current routine execution and let engine to schedule other one. It is not defined when
@@ -125,6 +217,25 @@ public:
      */
     void unblock(void *coro);
 
+    /**
+     * Routine which is running now, nullptr outside of routines
+     */
+    void *current() const { return cur_routine; }
+
+    /**
+     * Replaces function called when all coroutines are blocked, empty one means there is nothing to call
+     */
+    void set_unblocker(unblocker_func unblocker) {
+        _unblocker = unblocker ? std::move(unblocker) : unblocker_func(null_unblocker);
+    }
+
+    Mode GetMode() const { return _mode; }
+
+    /**
+     * Parses mode name: copy or separate
+     */
+    static Mode ParseMode(const std::string &name);
+
     /**
      * Entry point into the engine. Prepare all internal mechanics and starts given function which is
      * considered as main.
@@ -143,8 +254,11 @@ public:
         // Start routine execution
         void *pc = run(main, std::forward<Ta>(args)...);
 
-        idle_ctx = new context();
-        if (setjmp(idle_ctx->Environment) > 0) {
+        idle_ctx = NewContext();
+        if (_mode == Mode::kSeparateStack) {
+            // Idle context is the stack of the caller, it is saved on the first switch
+            Loop(static_cast<context *>(pc));
+        } else if (setjmp(idle_ctx->Environment) > 0) {
             if (alive == nullptr) {
                 _unblocker(*this);
             }
@@ -157,7 +271,8 @@ public:
         }
 
         // Shutdown runtime
-        delete idle_ctx;
+        FreeContext(idle_ctx);
+        idle_ctx = nullptr;
         this->StackBottom = 0;
     }
 
@@ -171,8 +286,12 @@ public:
             return nullptr;
         }
 
+        if (_mode == Mode::kSeparateStack) {
+            return Spawn(std::bind(func, Keep(std::forward<Ta>(args))...));
+        }
+
         // New coroutine context that carries around all information enough to call function
-        context *pc = new context();
+        context *pc = NewContext();
 
         // Store current state right here, i.e just before enter new coroutine, later, once it gets scheduled
         // execution starts here. Note that we have to acquire stack of the current function call to ensure
@@ -202,9 +321,7 @@ public:
 
             // current coroutine finished, and the pointer is not relevant now
             cur_routine = nullptr;
-            pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
-            delete pc;
+            FreeContext(pc);
 
             // We cannot return here, as this function "returned" once already, so here we must select some other
             // coroutine to run. As current coroutine is completed and can't be scheduled anymore, it is safe to
@@ -0,0 +1,121 @@
+#ifndef AFINA_COROUTINE_POLLER_H
+#define AFINA_COROUTINE_POLLER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Coroutine aware IO on non-blocking descriptors
+ * Read, Write and Accept behave like their syscalls on a blocking descriptor, but only the calling coroutine
+ * waits: once the syscall says EAGAIN the routine is blocked in the engine until epoll reports the descriptor
+ * ready. Poller installs itself as unblocker of the engine, so when every routine waits the engine sleeps in
+ * epoll_wait and wakes those whose descriptors are ready.
+ *
+ * Descriptor is added to epoll edge-triggered on the first wait and stays there until Close, so waiting costs no
+ * syscalls besides the retried one. At most one routine may wait for reading and one for writing on a descriptor,
+ * and a descriptor must not be closed while someone waits on it.
+ *
+ * Routine may also Sleep for a while, that is the way to back off when a syscall keeps failing. Sleepers are
+ * woken by the timeout of epoll_wait, so sleeping needs no descriptors.
+ *
+ * Shutdown wakes everyone: waits in progress and all the later ones fail with ECANCELED, that is the way to stop
+ * the routines stuck in IO. Not threadsafe, the same as engine
+ */
+class Poller {
+public:
+    /**
+     * Throws std::runtime_error if there is no epoll
+     */
+    explicit Poller(Engine &engine);
+    Poller(const Poller &) = delete;
+    Poller &operator=(const Poller &) = delete;
+    ~Poller();
+
+    /**
+     * Same as read(2), -1 with errno ECANCELED once shut down
+     */
+    ssize_t Read(int fd, void *buf, std::size_t count);
+
+    /**
+     * Same as write(2), -1 with errno ECANCELED once shut down
+     */
+    ssize_t Write(int fd, const void *buf, std::size_t count);
+
+    /**
+     * Same as accept4(2) with SOCK_NONBLOCK | SOCK_CLOEXEC, so the new descriptor is ready for the poller right away
+     */
+    int Accept(int fd, struct sockaddr *addr, socklen_t *addrlen);
+
+    /**
+     * Blocks current routine until descriptor is ready for EPOLLIN or EPOLLOUT. Returns false with errno set if
+     * routine can't wait: shut down, not called from a routine or someone waits there already
+     */
+    bool Wait(int fd, uint32_t events);
+
+    /**
+     * Blocks current routine for the given time. Returns false with errno set if routine can't wait, as Wait does
+     */
+    bool Sleep(std::chrono::milliseconds timeout);
+
+    /**
+     * Forgets descriptor and closes it
+     */
+    int Close(int fd);
+
+    /**
+     * Wakes routines whose descriptors got ready or whose sleep is over within timeout in milliseconds, -1 to
+     * wait until at least one of them does. Returns number of routines woken, does nothing if no one waits
+     */
+    std::size_t Poll(int timeout);
+
+    /**
+     * Wakes all waiting routines and makes all the later waits fail
+     */
+    void Shutdown();
+
+    // Number of routines waiting for descriptors or sleeping
+    std::size_t Waiting() const { return _waiting; }
+
+private:
+    // Routines waiting on the descriptor
+    struct waiters {
+        void *reader = nullptr;
+        void *writer = nullptr;
+    };
+
+    using time_point = std::chrono::steady_clock::time_point;
+
+    // Wakes sleepers whose time has come, returns how many of them
+    std::size_t WakeSleepers(time_point now);
+
+    Engine &_engine;
+
+    int _epoll_fd;
+
+    // Descriptors added to epoll
+    std::unordered_map<int, waiters> _fds;
+
+    // Sleeping routines by the wake up time
+    std::set<std::pair<time_point, void *>> _sleepers;
+
+    std::size_t _waiting;
+
+    bool _shutdown;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_POLLER_H
@@ -18,13 +18,14 @@ namespace Execute {
  * the items have been transmitted, the server sends the string
  *
  * Each item sent by the server looks like this:
- * VALUE <key> <bytes>\r\n
+ * VALUE <key> <flags> <bytes> [<cas unique>]\r\n
  * <data>\r\n
  * VALUE ....
  * END
  *
- * Where <key> is the key for the value, <bytes> is the number of bytes in the
- * value and <data> is the value text
+ * Where <key> is the key for the value, <flags> is the flags value set by the
+ * storage command, <bytes> is the number of bytes in the value and <data> is
+ * the value text. <cas unique> is sent by the "gets" command only
  *
  * If some of the keys appearing in a retrieval request are not sent back
  * by the server in the item list this means that the server does not
@@ -34,15 +35,17 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys, bool with_cas = false) : _keys(keys), _with_cas(with_cas) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline bool with_cas() const { return _with_cas; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
     std::vector<std::string> _keys;
+    bool _with_cas;
 };
 
 } // namespace Execute
@@ -0,0 +1,46 @@
+#include <afina/allocator/Arena.h>
+
+#include <cstdint>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Allocator {
+
+const size_t Arena::kSlabSize;
+
+// See Arena.h
+Arena::Arena(size_t quota) : _quota(quota) {}
+
+// See Arena.h
+Arena::~Arena() {
+    for (void *slab : _slabs) {
+        munmap(slab, kSlabSize);
+    }
+}
+
+// See Arena.h
+void *Arena::Map() {
+    if (_quota != 0 && Used() + kSlabSize > _quota) {
+        return nullptr;
+    }
+
+    // mmap gives page alignment only, so map twice as much and trim the edges
+    char *raw = static_cast<char *>(mmap(nullptr, 2 * kSlabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                                         -1, 0));
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    char *slab = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(raw) + kSlabSize - 1) & ~(kSlabSize - 1));
+    if (slab != raw) {
+        munmap(raw, slab - raw);
+    }
+    munmap(slab + kSlabSize, raw + 2 * kSlabSize - (slab + kSlabSize));
+
+    _slabs.push_back(slab);
+    return slab;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,189 @@
+#include <afina/allocator/Mempool.h>
+
+#include <stdexcept>
+
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See Mempool.h
+Mempool::Mempool(SlabCache &cache, size_t object_size)
+    : _cache(cache), _object_size((object_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1)),
+      _first((sizeof(slab) + sizeof(void *) - 1) & ~(sizeof(void *) - 1)),
+      _capacity(uint32_t((Arena::kSlabSize - _first) / (_object_size == 0 ? 1 : _object_size))), _partial(nullptr),
+      _full(nullptr), _spare(nullptr), _draining(nullptr), _used(0), _slabs(0), _allocs(0) {
+    if (_object_size < sizeof(void *) || _capacity == 0) {
+        throw std::runtime_error("Object size " + std::to_string(object_size) + " doesn't fit into slab");
+    }
+}
+
+// See Mempool.h
+Mempool::~Mempool() {
+    for (slab *list : {_partial, _full}) {
+        while (list != nullptr) {
+            slab *next = list->next;
+            _cache.Put(list);
+            list = next;
+        }
+    }
+    for (slab *s : {_spare, _draining}) {
+        if (s != nullptr) {
+            _cache.Put(s);
+        }
+    }
+}
+
+// See Mempool.h
+void *Mempool::Alloc() {
+    slab *s = _partial;
+    if (s == nullptr) {
+        s = NewSlab();
+        if (s == nullptr) {
+            return nullptr;
+        }
+    }
+
+    void *ptr;
+    if (s->free_list != nullptr) {
+        ptr = s->free_list;
+        s->free_list = *static_cast<void **>(ptr);
+    } else {
+        ptr = s->unused;
+        s->unused += _object_size;
+    }
+
+    _used++;
+    _allocs++;
+    if (++s->used == _capacity) {
+        Unlink(_partial, s);
+        Link(_full, s);
+        s->partial = false;
+    }
+    return ptr;
+}
+
+// See Mempool.h
+void Mempool::Free(void *ptr) {
+    slab *s = SlabOf(ptr);
+    *static_cast<void **>(ptr) = s->free_list;
+    s->free_list = ptr;
+    _used--;
+    s->used--;
+
+    if (s == _draining) {
+        if (s->used == 0) {
+            _draining = nullptr;
+            _cache.Put(s);
+            _slabs--;
+        }
+        return;
+    }
+
+    if (!s->partial) {
+        Unlink(_full, s);
+        Link(_partial, s);
+        s->partial = true;
+    }
+
+    if (s->used == 0) {
+        Unlink(_partial, s);
+        if (_spare == nullptr) {
+            _spare = s;
+        } else {
+            _cache.Put(s);
+            _slabs--;
+        }
+    }
+}
+
+// See Mempool.h
+bool Mempool::ReleaseSpare() {
+    if (_spare == nullptr) {
+        return false;
+    }
+    _cache.Put(_spare);
+    _spare = nullptr;
+    _slabs--;
+    return true;
+}
+
+// See Mempool.h
+bool Mempool::Drain() {
+    if (_draining != nullptr) {
+        return false;
+    }
+
+    for (slab *list : {_partial, _full}) {
+        for (slab *s = list; s != nullptr; s = s->next) {
+            if (_draining == nullptr || s->used < _draining->used) {
+                _draining = s;
+            }
+        }
+    }
+    if (_draining == nullptr) {
+        return false;
+    }
+
+    Unlink(_draining->partial ? _partial : _full, _draining);
+    return true;
+}
+
+// See Mempool.h
+void Mempool::Undrain() {
+    if (_draining == nullptr) {
+        return;
+    }
+
+    slab *s = _draining;
+    _draining = nullptr;
+    s->partial = s->used < _capacity;
+    Link(s->partial ? _partial : _full, s);
+}
+
+// See Mempool.h
+Mempool::slab *Mempool::NewSlab() {
+    slab *s = _spare;
+    if (s != nullptr) {
+        _spare = nullptr;
+    } else {
+        s = static_cast<slab *>(_cache.Get());
+        if (s == nullptr) {
+            return nullptr;
+        }
+        _slabs++;
+    }
+
+    s->pool = this;
+    s->free_list = nullptr;
+    s->unused = reinterpret_cast<char *>(s) + _first;
+    s->used = 0;
+    s->partial = true;
+    Link(_partial, s);
+    return s;
+}
+
+// See Mempool.h
+void Mempool::Unlink(slab *&list, slab *s) {
+    if (s->prev != nullptr) {
+        s->prev->next = s->next;
+    } else {
+        list = s->next;
+    }
+    if (s->next != nullptr) {
+        s->next->prev = s->prev;
+    }
+}
+
+// See Mempool.h
+void Mempool::Link(slab *&list, slab *s) {
+    s->prev = nullptr;
+    s->next = list;
+    if (list != nullptr) {
+        list->prev = s;
+    }
+    list = s;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,169 @@
+#include <afina/allocator/SharedSmall.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+const size_t SharedSmall::kMagazineSize;
+const size_t SharedSmall::kMagazineBytes;
+
+// See SharedSmall.h
+SharedSmall::SharedSmall(size_t quota) : _small(quota) {
+    for (size_t cls = 0; cls < _small.Classes(); cls++) {
+        size_t limit = kMagazineBytes / _small.Pool(cls).ObjectSize();
+        _limits.push_back(std::max<size_t>(4, std::min(kMagazineSize, limit)));
+        _depot.emplace_back(new Concurrency::LockFreeStack<magazine *>());
+    }
+    _caches.reset(new Concurrency::ThreadLocal<thread_cache>([this] { return new thread_cache(*this); }));
+}
+
+// See SharedSmall.h
+SharedSmall::~SharedSmall() {
+    _caches.reset();
+
+    // Objects are still in the slabs, those are released by Small
+    magazine *m;
+    for (auto &depot : _depot) {
+        while (depot->Pop(m)) {
+            delete m;
+        }
+    }
+    while (_empty.Pop(m)) {
+        delete m;
+    }
+}
+
+// See SharedSmall.h
+SharedSmall::thread_cache::~thread_cache() {
+    for (size_t cls = 0; cls < slots.size(); cls++) {
+        for (magazine *m : {slots[cls].loaded, slots[cls].previous}) {
+            if (m == nullptr) {
+                continue;
+            } else if (m->count != 0) {
+                owner._depot[cls]->Push(m);
+            } else {
+                owner._empty.Push(m);
+            }
+        }
+    }
+}
+
+// See SharedSmall.h
+void *SharedSmall::Alloc(size_t size) {
+    if (size > Small::kMaxObject) {
+        void *ptr = std::malloc(size);
+        if (ptr == nullptr) {
+            throw AllocError(AllocErrorType::NoMemory, "No memory for the block of " + std::to_string(size) + " bytes");
+        }
+        return ptr;
+    }
+
+    size_t cls = Small::ClassOf(size);
+    thread_cache::slot &s = Slot(cls);
+    if (s.loaded->count == 0) {
+        magazine *full;
+        if (s.previous->count != 0) {
+            std::swap(s.loaded, s.previous);
+        } else if (_depot[cls]->Pop(full)) {
+            _empty.Push(s.loaded);
+            s.loaded = full;
+        } else {
+            Refill(cls, *s.loaded);
+        }
+    }
+    return s.loaded->objects[--s.loaded->count];
+}
+
+// See SharedSmall.h
+void SharedSmall::Free(void *ptr, size_t size) {
+    if (ptr == nullptr) {
+        return;
+    } else if (size > Small::kMaxObject) {
+        std::free(ptr);
+        return;
+    }
+
+    size_t cls = Small::ClassOf(size);
+    thread_cache::slot &s = Slot(cls);
+    if (s.loaded->count == _limits[cls]) {
+        if (s.previous->count < _limits[cls]) {
+            std::swap(s.loaded, s.previous);
+        } else {
+            // Both are full: older one goes to the depot, so that some other thread could use it
+            _depot[cls]->Push(s.previous);
+            s.previous = s.loaded;
+            s.loaded = NewMagazine();
+        }
+    }
+    s.loaded->objects[s.loaded->count++] = ptr;
+}
+
+// See SharedSmall.h
+void SharedSmall::Trim() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    magazine *m;
+    for (auto &depot : _depot) {
+        while (depot->Pop(m)) {
+            for (size_t i = 0; i < m->count; i++) {
+                Mempool::Of(m->objects[i])->Free(m->objects[i]);
+            }
+            m->count = 0;
+            _empty.Push(m);
+        }
+    }
+}
+
+// See SharedSmall.h
+size_t SharedSmall::Used() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t used = 0;
+    for (size_t cls = 0; cls < _small.Classes(); cls++) {
+        used += _small.Pool(cls).Used();
+    }
+    return used;
+}
+
+// See SharedSmall.h
+size_t SharedSmall::Mapped() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _small.Mapped();
+}
+
+// See SharedSmall.h
+SharedSmall::thread_cache::slot &SharedSmall::Slot(size_t cls) {
+    thread_cache::slot &s = _caches->Get().slots[cls];
+    if (s.loaded == nullptr) {
+        if (s.previous == nullptr) {
+            s.previous = NewMagazine();
+        }
+        s.loaded = NewMagazine();
+    }
+    return s;
+}
+
+// See SharedSmall.h
+SharedSmall::magazine *SharedSmall::NewMagazine() {
+    magazine *m;
+    if (!_empty.Pop(m)) {
+        m = new magazine();
+    }
+    m->count = 0;
+    return m;
+}
+
+// See SharedSmall.h
+void SharedSmall::Refill(size_t cls, magazine &m) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    m.count = _small.AllocBatch(cls, m.objects, _limits[cls]);
+    if (m.count == 0) {
+        throw AllocError(AllocErrorType::NoMemory,
+                         "No memory for the object of " + std::to_string(_small.Pool(cls).ObjectSize()) + " bytes");
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -1,40 +1,452 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+const size_t Simple::kClasses;
+
+namespace {
+
+const size_t kAlign = sizeof(void *);
+
+// How many blocks of the own size class to check before going to the bigger ones
+const size_t kShortScan = 8;
+
+// Free block keeps both links of its free list in the payload
+const size_t kMinPayload = 2 * sizeof(void *);
+
+inline size_t AlignUp(size_t size) { return (size + kAlign - 1) & ~(kAlign - 1); }
+
+inline size_t PayloadSize(size_t size) { return size < kMinPayload ? kMinPayload : AlignUp(size); }
+
+// Index of the free list for the block of given size, i.e floor(log2(size))
+inline size_t SizeClass(size_t size) { return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(size); }
+
+} // namespace
+
+Simple::Simple(void *base, size_t size)
+    : _base(base), _base_len(size), _free_blocks(), _free_mask(0), _used_blocks(0), _used_bytes(0), _free_bytes(0),
+      _free_counts(), _allocs(), _frees(), _free_slots(nullptr), _defrag_dst(nullptr), _defrag_src(nullptr) {
+    uintptr_t begin = AlignUp(reinterpret_cast<uintptr_t>(base));
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(kAlign - 1);
+    if (end < begin) {
+        end = begin;
+    }
+
+    _top = reinterpret_cast<char *>(begin);
+    _table_end = reinterpret_cast<void **>(end);
+    _table = _table_end;
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    CheckSize(N);
+    void **slot = TakeSlot();
+    if (slot == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for the indirection table");
+    }
+
+    block *b = TakeBlock(PayloadSize(N));
+    if (b == nullptr) {
+        ReleaseSlot(slot);
+        throw AllocError(AllocErrorType::NoMemory, "No room for the block of " + std::to_string(N) + " bytes");
+    }
+
+    b->slot = slot;
+    *slot = b + 1;
+    _used_blocks++;
+    _used_bytes += b->size;
+    _allocs[SizeClass(b->size)]++;
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    CheckSize(N);
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    block *b = BlockOf(p._slot);
+    size_t size = PayloadSize(N);
+    size_t old = b->size;
+    char *end = reinterpret_cast<char *>(b + 1) + b->size;
+
+    // The last block gives room back to the free space right away. The others keep it unless they shrink
+    // to less than a half, appended values often grow back
+    if (size <= b->size) {
+        if (end == _top) {
+            _top = reinterpret_cast<char *>(b + 1) + size;
+            b->size = size;
+        } else if (size < b->size / 2) {
+            SplitBlock(b, size);
+        }
+        _used_bytes = _used_bytes - old + b->size;
+        return;
+    }
+
+    if (GrowInPlace(b, size)) {
+        _used_bytes = _used_bytes - old + b->size;
+        return;
+    }
+
+    // Growth by half of the size at least, so that value growing by small appends is copied O(1) times
+    // per byte on average
+    size_t capacity = std::max(size, AlignUp(old + old / 2));
+    block *moved = TakeBlock(capacity);
+    if (moved == nullptr && capacity != size) {
+        moved = TakeBlock(size);
+    }
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for the block of " + std::to_string(N) + " bytes");
+    }
+
+    // Taking the block could not touch the old one, that one is in use, but it could move it
+    b = static_cast<block *>(*p._slot) - 1;
+    std::memcpy(moved + 1, b + 1, b->size);
+    moved->slot = p._slot;
+    *p._slot = moved + 1;
+    _used_bytes = _used_bytes - b->size + moved->size;
+    _allocs[SizeClass(moved->size)]++;
+    _frees[SizeClass(b->size)]++;
+
+    b->slot = nullptr;
+    ReleaseBlock(b);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+
+    block *b = BlockOf(p._slot);
+    _used_blocks--;
+    _used_bytes -= b->size;
+    _frees[SizeClass(b->size)]++;
+
+    b->slot = nullptr;
+    ReleaseBlock(b);
+    ReleaseSlot(p._slot);
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() { defrag_step(SIZE_MAX); }
+
+// See Simple.h
+bool Simple::defrag_step(size_t max_bytes) {
+    if (_defrag_dst == nullptr) {
+        // All free blocks are ahead of the cursor now, the walk takes them over
+        _defrag_dst = reinterpret_cast<char *>(AlignUp(reinterpret_cast<uintptr_t>(_base)));
+        _defrag_src = _defrag_dst;
+        std::memset(_free_blocks, 0, sizeof(_free_blocks));
+        std::memset(_free_counts, 0, sizeof(_free_counts));
+        _free_mask = 0;
+        _free_bytes = 0;
+    }
+
+    // Headers of the visited blocks are accounted too, so that walking over compact blocks is bounded as well
+    size_t spent = 0;
+    while (_defrag_src < _top) {
+        block *b = reinterpret_cast<block *>(_defrag_src);
+        size_t len = sizeof(block) + b->size;
+        bool live = b->slot != nullptr;
+        bool move = live && _defrag_dst != _defrag_src;
+        size_t cost = move ? len : sizeof(block);
+        if (spent != 0 && spent + cost > max_bytes) {
+            return false;
+        }
+        spent += cost;
+
+        if (move) {
+            std::memmove(_defrag_dst, _defrag_src, len);
+            block *moved = reinterpret_cast<block *>(_defrag_dst);
+            *moved->slot = moved + 1;
+        }
+        if (live) {
+            _defrag_dst += len;
+        }
+        _defrag_src += len;
+    }
+
+    EndDefrag();
+    return true;
+}
+
+// See Simple.h
+double Simple::usage::fragmentation() const {
+    size_t free = free_bytes + tail_bytes;
+    if (free == 0 || largest_free >= free) {
+        return 0;
+    }
+    return 1.0 - double(largest_free) / double(free);
+}
+
+// See Simple.h
+Simple::usage Simple::stats() const {
+    usage u;
+    u.used_blocks = _used_blocks;
+    u.used_bytes = _used_bytes;
+    u.free_blocks = 0;
+    u.free_bytes = _free_bytes;
+    u.tail_bytes = 0;
+    u.largest_free = 0;
+    for (size_t room : {size_t(reinterpret_cast<char *>(_table) - _top),
+                        _defrag_dst != nullptr ? size_t(_defrag_src - _defrag_dst) : 0}) {
+        if (room > sizeof(block)) {
+            u.tail_bytes += room - sizeof(block);
+            u.largest_free = std::max(u.largest_free, room - sizeof(block));
+        }
+    }
+    for (size_t cls = 0; cls < kClasses; cls++) {
+        u.free_lists[cls] = _free_counts[cls];
+        u.free_blocks += _free_counts[cls];
+        u.allocs[cls] = _allocs[cls];
+        u.frees[cls] = _frees[cls];
+    }
+
+    // Largest free block is in the top non empty class, that is a single list to scan
+    if (_free_mask != 0) {
+        size_t top = kClasses - 1 - __builtin_clzll(_free_mask);
+        for (block *b = _free_blocks[top]; b != nullptr; b = Links(b).next) {
+            if (b->size > u.largest_free) {
+                u.largest_free = b->size;
+            }
+        }
+    }
+    return u;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    usage u = stats();
+    char fragmentation[32];
+    snprintf(fragmentation, sizeof(fragmentation), "%.3f", u.fragmentation());
+
+    std::string out = "used " + std::to_string(u.used_blocks) + " blocks " + std::to_string(u.used_bytes) +
+                      " bytes, free " + std::to_string(u.free_blocks) + " blocks " + std::to_string(u.free_bytes) +
+                      " bytes, tail " + std::to_string(u.tail_bytes) + " bytes, largest " +
+                      std::to_string(u.largest_free) + ", fragmentation " + fragmentation + "\n";
+    for (size_t cls = 0; cls < kClasses; cls++) {
+        if (u.free_lists[cls] != 0 || u.allocs[cls] != 0) {
+            out += "class " + std::to_string(cls) + ": free " + std::to_string(u.free_lists[cls]) + ", allocs " +
+                   std::to_string(u.allocs[cls]) + ", frees " + std::to_string(u.frees[cls]) + "\n";
+        }
+    }
+    return out;
+}
+
+// See Simple.h
+Simple::block *Simple::BlockOf(void **slot) const {
+    if (slot < _table || slot >= _table_end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+
+    char *data = static_cast<char *>(*slot);
+    if (data < static_cast<char *>(_base) + sizeof(block) || data > _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer refers to the released block");
+    }
+
+    block *b = reinterpret_cast<block *>(data) - 1;
+    if (b->slot != slot) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer refers to the released block");
+    }
+    return b;
+}
+
+// See Simple.h
+void Simple::CheckSize(size_t N) const {
+    if (N > SIZE_MAX - kAlign || N > _base_len) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for the block of " + std::to_string(N) + " bytes");
+    }
+}
+
+// See Simple.h
+void **Simple::TakeSlot() {
+    if (_free_slots != nullptr) {
+        void **slot = _free_slots;
+        _free_slots = static_cast<void **>(*slot);
+        return slot;
+    }
+
+    if (size_t(reinterpret_cast<char *>(_table) - _top) < sizeof(void *)) {
+        return nullptr;
+    }
+    return --_table;
+}
+
+// See Simple.h
+void Simple::ReleaseSlot(void **slot) {
+    *slot = _free_slots;
+    _free_slots = slot;
+}
+
+// See Simple.h
+Simple::block *Simple::TakeBlock(size_t size) {
+    // Blocks in the own size class may be too small, look at a few of them first
+    size_t cls = SizeClass(size);
+    block *b = TakeFromClass(cls, size, kShortScan);
+    if (b != nullptr) {
+        return b;
+    }
+
+    // Any block from the bigger classes fits
+    size_t bigger = cls + 1 < kClasses ? _free_mask & ~((size_t(2) << cls) - 1) : 0;
+    if (bigger != 0) {
+        return TakeFromClass(__builtin_ctzll(bigger), size, 1);
+    }
+
+    // Gap left behind by the compaction cursor, taking it from the start keeps blocks below compact
+    if (_defrag_dst != nullptr && size_t(_defrag_src - _defrag_dst) >= sizeof(block) + size) {
+        b = reinterpret_cast<block *>(_defrag_dst);
+        b->size = size;
+        _defrag_dst += sizeof(block) + size;
+        return b;
+    }
+
+    // Free space between blocks and table
+    if (size_t(reinterpret_cast<char *>(_table) - _top) >= sizeof(block) + size) {
+        b = reinterpret_cast<block *>(_top);
+        b->size = size;
+        _top += sizeof(block) + size;
+        return b;
+    }
+
+    // Last resort is the whole own class
+    b = TakeFromClass(cls, size, SIZE_MAX);
+    if (b == nullptr && _defrag_dst != nullptr) {
+        // Free blocks ahead of the cursor are not in the lists, they are joined by finishing compaction
+        defrag();
+        return TakeBlock(size);
+    }
+    return b;
+}
+
+// See Simple.h
+Simple::block *Simple::TakeFromClass(size_t cls, size_t size, size_t max_scan) {
+    block *b = _free_blocks[cls];
+    for (size_t i = 0; i < max_scan && b != nullptr; i++, b = Links(b).next) {
+        if (b->size >= size) {
+            Unlink(b);
+            SplitBlock(b, size);
+            return b;
+        }
+    }
+    return nullptr;
+}
+
+// See Simple.h
+void Simple::Unlink(block *b) {
+    size_t cls = SizeClass(b->size);
+    free_links &links = Links(b);
+    if (links.prev != nullptr) {
+        Links(links.prev).next = links.next;
+    } else {
+        _free_blocks[cls] = links.next;
+    }
+    if (links.next != nullptr) {
+        Links(links.next).prev = links.prev;
+    }
+
+    if (_free_blocks[cls] == nullptr) {
+        _free_mask &= ~(size_t(1) << cls);
+    }
+    _free_counts[cls]--;
+    _free_bytes -= b->size;
+}
+
+// See Simple.h
+bool Simple::GrowInPlace(block *b, size_t size) {
+    char *end = reinterpret_cast<char *>(b + 1) + b->size;
+    size_t more = size - b->size;
+    if (end == _top) {
+        if (more > size_t(reinterpret_cast<char *>(_table) - _top)) {
+            return false;
+        }
+        _top += more;
+        b->size = size;
+        return true;
+    } else if (_defrag_dst != nullptr && end == _defrag_dst) {
+        if (more > size_t(_defrag_src - _defrag_dst)) {
+            return false;
+        }
+        _defrag_dst += more;
+        b->size = size;
+        return true;
+    }
+
+    block *next = reinterpret_cast<block *>(end);
+    if (next->slot != nullptr || sizeof(block) + next->size < more) {
+        return false;
+    }
+
+    // Free blocks ahead of the compaction cursor are not in the lists
+    if (_defrag_dst == nullptr || end < _defrag_dst) {
+        Unlink(next);
+    }
+    b->size += sizeof(block) + next->size;
+    SplitBlock(b, size);
+    return true;
+}
+
+// See Simple.h
+void Simple::ReleaseBlock(block *b) {
+    char *end = reinterpret_cast<char *>(b + 1) + b->size;
+    if (_defrag_dst != nullptr && end == _defrag_dst) {
+        _defrag_dst = reinterpret_cast<char *>(b);
+        return;
+    } else if (end == _top) {
+        _top = reinterpret_cast<char *>(b);
+        if (_defrag_dst != nullptr && _top == _defrag_src) {
+            EndDefrag();
+        }
+        return;
+    } else if (_defrag_dst != nullptr && reinterpret_cast<char *>(b) >= _defrag_src) {
+        // Compaction walk gets to it
+        return;
+    }
+
+    size_t cls = SizeClass(b->size);
+    Links(b).next = _free_blocks[cls];
+    Links(b).prev = nullptr;
+    if (_free_blocks[cls] != nullptr) {
+        Links(_free_blocks[cls]).prev = b;
+    }
+    _free_blocks[cls] = b;
+    _free_counts[cls]++;
+    _free_bytes += b->size;
+    _free_mask |= size_t(1) << cls;
+}
+
+// See Simple.h
+void Simple::SplitBlock(block *b, size_t size) {
+    if (b->size - size < sizeof(block) + kMinPayload) {
+        return;
+    }
+
+    block *rest = reinterpret_cast<block *>(reinterpret_cast<char *>(b + 1) + size);
+    rest->size = b->size - size - sizeof(block);
+    rest->slot = nullptr;
+    b->size = size;
+    ReleaseBlock(rest);
+}
+
+// See Simple.h
+void Simple::EndDefrag() {
+    _top = _defrag_dst;
+    _defrag_dst = nullptr;
+    _defrag_src = nullptr;
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -0,0 +1,30 @@
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See SlabCache.h
+void *SlabCache::Get() {
+    void *slab;
+    if (!_free.empty()) {
+        slab = _free.back();
+        _free.pop_back();
+    } else {
+        slab = _arena.Map();
+        if (slab == nullptr) {
+            return nullptr;
+        }
+    }
+
+    _used++;
+    return slab;
+}
+
+// See SlabCache.h
+void SlabCache::Put(void *slab) {
+    _free.push_back(slab);
+    _used--;
+}
+
+} // namespace Allocator
+} // namespace Afina
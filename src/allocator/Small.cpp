@@ -0,0 +1,92 @@
+#include <afina/allocator/Small.h>
+
+#include <cstdlib>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+const size_t Small::kMaxObject;
+
+// See Small.h
+Small::size_classes::size_classes() {
+    for (size_t size = 16; size <= 128; size += 8) {
+        sizes.push_back(size);
+    }
+    while (sizes.back() < kMaxObject) {
+        size_t next = (sizes.back() * 5 / 4 + 7) & ~size_t(7);
+        sizes.push_back(next < kMaxObject ? next : kMaxObject);
+    }
+
+    lookup.resize(kMaxObject / 8);
+    size_t cls = 0;
+    for (size_t i = 0; i < lookup.size(); i++) {
+        while (sizes[cls] < (i + 1) * 8) {
+            cls++;
+        }
+        lookup[i] = uint8_t(cls);
+    }
+}
+
+// See Small.h
+const Small::size_classes &Small::SizeClasses() {
+    static const size_classes classes;
+    return classes;
+}
+
+// See Small.h
+Small::Small(size_t quota) : _cache(quota) {
+    for (size_t size : SizeClasses().sizes) {
+        _pools.emplace_back(new Mempool(_cache, size));
+    }
+}
+
+// See Small.h
+Small::~Small() {
+    // Pools give their slabs back to the cache, so they must go first
+    _pools.clear();
+}
+
+// See Small.h
+void *Small::Alloc(size_t size) {
+    void *ptr = TryAlloc(size);
+    if (ptr == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No memory for the block of " + std::to_string(size) + " bytes");
+    }
+    return ptr;
+}
+
+// See Small.h
+void *Small::TryAlloc(size_t size) {
+    if (size > kMaxObject) {
+        return std::malloc(size);
+    }
+    return _pools[ClassOf(size)]->Alloc();
+}
+
+// See Small.h
+size_t Small::AllocBatch(size_t cls, void **objects, size_t count) {
+    Mempool &pool = *_pools[cls];
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = pool.Alloc();
+        if (objects[i] == nullptr) {
+            return i;
+        }
+    }
+    return count;
+}
+
+// See Small.h
+void Small::Free(void *ptr, size_t size) {
+    if (ptr == nullptr) {
+        return;
+    } else if (size > kMaxObject) {
+        std::free(ptr);
+    } else {
+        Mempool::Of(ptr)->Free(ptr);
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
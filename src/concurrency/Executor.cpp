@@ -1,5 +1,256 @@
 #include <afina/concurrency/Executor.h>
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <pthread.h>
+
 namespace Afina {
-namespace Concurrency {}
+namespace Concurrency {
+
+// See Executor.h
+void perform(Executor *executor, std::size_t slot) {
+    // Thread names are limited to 15 characters
+    pthread_setname_np(pthread_self(), executor->name.substr(0, 15).c_str());
+
+    Executor::queued_task exec;
+    std::size_t index;
+
+    // Taken only to sleep, but kept on the way out: Stop and destructor must not see kStopped before the
+    // thread is done with the pool
+    std::unique_lock<std::mutex> lock(executor->mutex, std::defer_lock);
+    for (;;) {
+        if (executor->Pop(exec, index)) {
+            Executor::lane_state &lane = *executor->lanes[index];
+            executor->free_threads--;
+            executor->queued--;
+
+            std::uint64_t wait = std::uint64_t(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - exec.enqueued)
+                    .count());
+            lane.total_wait.fetch_add(wait, std::memory_order_relaxed);
+            std::uint64_t max_wait = lane.max_wait.load(std::memory_order_relaxed);
+            while (wait > max_wait && !lane.max_wait.compare_exchange_weak(max_wait, wait, std::memory_order_relaxed)) {
+            }
+
+            try {
+                exec.task();
+            } catch (...) {
+                // Task is on its own with errors, the thread goes on
+            }
+
+            // Bound arguments are released right away, their destructors could use the pool
+            exec.task = nullptr;
+            lane.executed.fetch_add(1, std::memory_order_relaxed);
+            lane.running--;
+            executor->free_threads++;
+
+            // Task of the capped lane could be left waiting for this one to finish, while threads sleep
+            if (lane.max_running != 0 && lane.queued.load() != 0 && executor->sleeping.load() != 0) {
+                std::lock_guard<std::mutex> lock(executor->mutex);
+                executor->empty_condition.notify_one();
+            }
+            continue;
+        }
+
+        lock.lock();
+
+        // Pairs with Dispatch: either the task is seen here or this thread is seen sleeping there
+        executor->sleeping++;
+        bool timed_out = false;
+        while (!executor->Runnable() && executor->state.load() == Executor::State::kRun && !timed_out) {
+            timed_out = executor->empty_condition.wait_for(lock, executor->idle_time) == std::cv_status::timeout;
+        }
+        executor->sleeping--;
+
+        // Task could be reserved, but not pushed yet: next pop gets it, just a bit later
+        if (executor->Runnable()) {
+            lock.unlock();
+            continue;
+        }
+
+        // Either pool is stopping or thread is idle for too long. Tasks of the capped lanes could still be
+        // queued, but then the threads running that lane are alive to take them
+        if (executor->state.load() != Executor::State::kRun ||
+            (timed_out && executor->threads.load() > executor->low_watermark)) {
+            break;
+        }
+        lock.unlock();
+    }
+
+    // Bits of slots share words, so the slot is given back under the same lock StartThread looks for it
+    if (!lock.owns_lock()) {
+        lock.lock();
+    }
+    executor->slots[slot] = false;
+    executor->free_threads--;
+    executor->threads--;
+    if (executor->threads.load() == 0 && executor->state.load() == Executor::State::kStopping) {
+        executor->state.store(Executor::State::kStopped);
+        executor->stop_condition.notify_all();
+    }
+}
+
+// See Executor.h
+Executor::Executor(std::string name, std::size_t low_watermark, std::size_t high_watermark,
+                   std::size_t max_queue_size, std::chrono::milliseconds idle_time)
+    : Executor(std::move(name), low_watermark, high_watermark, max_queue_size, idle_time, {Lane()}) {}
+
+// See Executor.h
+Executor::Executor(std::string name, std::size_t low_watermark, std::size_t high_watermark,
+                   std::size_t max_queue_size, std::chrono::milliseconds idle_time, std::vector<Lane> lanes,
+                   Placement placement)
+    : name(std::move(name)), low_watermark(low_watermark), high_watermark(high_watermark),
+      max_queue_size(max_queue_size), idle_time(idle_time), placement(std::move(placement)), threads(0),
+      slots(high_watermark, false), free_threads(0), sleeping(0), queued(0), virtual_time(0), state(State::kRun) {
+    if (high_watermark == 0 || low_watermark > high_watermark) {
+        throw std::invalid_argument("Executor needs 0 < high_watermark and low_watermark <= high_watermark");
+    }
+    if (lanes.empty()) {
+        throw std::invalid_argument("Executor needs at least one lane");
+    }
+    for (const Lane &lane : lanes) {
+        if (lane.weight == 0) {
+            throw std::invalid_argument("Lane weight must be positive");
+        }
+        this->lanes.emplace_back(new lane_state(lane, high_watermark + max_queue_size));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < low_watermark; i++) {
+        StartThread();
+    }
+}
+
+// See Executor.h
+Executor::~Executor() { Stop(true); }
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (state.load() == State::kRun) {
+        state.store(threads.load() == 0 ? State::kStopped : State::kStopping);
+        empty_condition.notify_all();
+    }
+
+    if (await) {
+        stop_condition.wait(lock, [this] { return state.load() == State::kStopped; });
+    }
+}
+
+// See Executor.h
+Executor::State Executor::GetState() { return state.load(); }
+
+// See Executor.h
+std::size_t Executor::Threads() { return threads.load(); }
+
+// See Executor.h
+std::size_t Executor::Queued() { return queued.load(); }
+
+// See Executor.h
+Executor::LaneStats Executor::Stats(std::size_t lane) {
+    lane_state &l = *lanes.at(lane);
+    LaneStats stats;
+    stats.queued = l.queued.load();
+    stats.running = l.running.load();
+    stats.executed = l.executed.load(std::memory_order_relaxed);
+    stats.rejected = l.rejected.load(std::memory_order_relaxed);
+    stats.total_wait = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(l.total_wait.load(std::memory_order_relaxed)));
+    stats.max_wait = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(l.max_wait.load(std::memory_order_relaxed)));
+    return stats;
+}
+
+// See Executor.h
+bool Executor::Runnable() {
+    for (auto &l : lanes) {
+        if (l->queued.load() != 0 && (l->max_running == 0 || l->running.load() < l->max_running)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See Executor.h
+bool Executor::Pop(queued_task &exec, std::size_t &lane) {
+    for (;;) {
+        lane_state *best = nullptr;
+        std::uint64_t best_pass = 0;
+        for (std::size_t i = 0; i < lanes.size(); i++) {
+            lane_state *l = lanes[i].get();
+            if (l->queued.load() == 0 || (l->max_running != 0 && l->running.load() >= l->max_running)) {
+                continue;
+            }
+            std::uint64_t pass = l->pass.load(std::memory_order_relaxed);
+            if (best == nullptr || pass < best_pass) {
+                best = l;
+                best_pass = pass;
+                lane = i;
+            }
+        }
+        if (best == nullptr) {
+            return false;
+        }
+
+        // Slot under the cap is claimed first, other thread could have taken the last one
+        std::size_t running = best->running.fetch_add(1);
+        if (best->max_running != 0 && running >= best->max_running) {
+            best->running--;
+            continue;
+        }
+
+        if (!best->tasks.TryPop(exec)) {
+            // Task is reserved, but not pushed yet
+            best->running--;
+            return false;
+        }
+        best->queued--;
+
+        // Lane that has been idle starts from the pass of the last served one, not from where it stopped
+        std::uint64_t now = virtual_time.load(std::memory_order_relaxed);
+        std::uint64_t pass = best->pass.load(std::memory_order_relaxed);
+        if (pass < now) {
+            pass = now;
+        }
+        best->pass.store(pass + best->stride, std::memory_order_relaxed);
+        virtual_time.store(pass, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+// See Executor.h
+void Executor::Dispatch() {
+    if (queued.load() > free_threads.load() && threads.load() < high_watermark) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued.load() > free_threads.load() && threads.load() < high_watermark) {
+            StartThread();
+        }
+    }
+
+    if (sleeping.load() != 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        empty_condition.notify_one();
+    }
+}
+
+// See Executor.h
+void Executor::StartThread() {
+    // There are at most high_watermark threads, so some slot is free unless the counter went wrong
+    auto free = std::find(slots.begin(), slots.end(), false);
+    if (free == slots.end()) {
+        return;
+    }
+    std::size_t slot = free - slots.begin();
+    *free = true;
+    std::thread thread(perform, this, slot);
+
+    // Thread that could not be placed still runs, just anywhere
+    placement.Apply(thread, slot);
+    thread.detach();
+    threads++;
+    free_threads++;
+}
+
+} // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,228 @@
+#include <afina/concurrency/Placement.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <dirent.h>
+#include <sched.h>
+
+namespace Afina {
+namespace Concurrency {
+
+namespace {
+
+// Parses CPU list of the sysfs, like "0-3,8,10-11"
+std::vector<int> ParseList(const std::string &list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        char *end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = std::strtol(end + 1, &end, 10);
+        }
+        for (long id = first; id <= last && id >= 0; id++) {
+            ids.push_back(int(id));
+        }
+    }
+    return ids;
+}
+
+// Reads the first line of the file, false if there is no such file
+bool ReadLine(const std::string &path, std::string &line) {
+    std::ifstream in(path);
+    return bool(std::getline(in, line));
+}
+
+// Reads the number from the file, or returns fallback
+int ReadInt(const std::string &path, int fallback) {
+    std::string line;
+    if (!ReadLine(path, line) || line.empty()) {
+        return fallback;
+    }
+    char *end = nullptr;
+    long value = std::strtol(line.c_str(), &end, 10);
+    return end == line.c_str() ? fallback : int(value);
+}
+
+// Node of the CPU is the nodeN link in its directory
+int ReadNode(const std::string &dir) {
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return 0;
+    }
+    int node = 0;
+    while (struct dirent *entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+            node = std::atoi(name.c_str() + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+// CPUs the process is allowed to run on, empty if unknown
+std::set<int> AllowedCpus() {
+    std::set<int> allowed;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int id = 0; id < CPU_SETSIZE; id++) {
+            if (CPU_ISSET(id, &set)) {
+                allowed.insert(id);
+            }
+        }
+    }
+    return allowed;
+}
+
+} // namespace
+
+// See Placement.h
+Topology::Topology(std::vector<CpuInfo> cpus) : _cpus(std::move(cpus)) {
+    std::sort(_cpus.begin(), _cpus.end(), [](const CpuInfo &a, const CpuInfo &b) { return a.id < b.id; });
+}
+
+// See Placement.h
+Topology Topology::Detect(const std::string &root, bool allowed_only) {
+    std::set<int> allowed;
+    if (allowed_only) {
+        allowed = AllowedCpus();
+    }
+
+    std::string online;
+    std::vector<int> ids;
+    if (ReadLine(root + "/online", online)) {
+        ids = ParseList(online);
+    }
+    if (ids.empty()) {
+        ids.assign(allowed.begin(), allowed.end());
+    }
+    if (ids.empty()) {
+        for (unsigned id = 0; id < std::max(1u, std::thread::hardware_concurrency()); id++) {
+            ids.push_back(int(id));
+        }
+    }
+
+    std::vector<CpuInfo> cpus;
+    for (int id : ids) {
+        if (!allowed.empty() && allowed.count(id) == 0) {
+            continue;
+        }
+        std::string dir = root + "/cpu" + std::to_string(id);
+        CpuInfo cpu;
+        cpu.id = id;
+        cpu.node = ReadNode(dir);
+        cpu.package = ReadInt(dir + "/topology/physical_package_id", 0);
+        cpu.core = ReadInt(dir + "/topology/core_id", id);
+        cpus.push_back(cpu);
+    }
+    return Topology(std::move(cpus));
+}
+
+// See Placement.h
+std::size_t Topology::Nodes() const {
+    std::set<int> nodes;
+    for (const CpuInfo &cpu : _cpus) {
+        nodes.insert(cpu.node);
+    }
+    return nodes.size();
+}
+
+// See Placement.h
+Placement::Placement() : _mode(Mode::kNone) {}
+
+// See Placement.h
+Placement::Placement(Mode mode) : Placement(mode, mode == Mode::kNone ? Topology() : Topology::Detect()) {}
+
+// See Placement.h
+Placement::Placement(Mode mode, const Topology &topology) : _mode(mode) {
+    if (mode == Mode::kNone) {
+        return;
+    }
+
+    _order = topology.Cpus();
+    if (mode == Mode::kPin) {
+        return;
+    }
+
+    // Position of the core within its node and of the CPU among the SMT siblings of its core
+    std::map<std::pair<int, int>, int> sibling_count;
+    std::map<int, std::map<std::pair<int, int>, int>> core_index;
+    std::map<int, std::pair<int, int>> rank;
+    for (const CpuInfo &cpu : _order) {
+        auto core = std::make_pair(cpu.package, cpu.core);
+        auto &cores = core_index[cpu.node];
+        if (cores.count(core) == 0) {
+            int index = int(cores.size());
+            cores[core] = index;
+        }
+        rank[cpu.id] = std::make_pair(sibling_count[core]++, cores[core]);
+    }
+
+    if (mode == Mode::kCompact) {
+        std::stable_sort(_order.begin(), _order.end(), [&rank](const CpuInfo &a, const CpuInfo &b) {
+            return std::make_tuple(a.node, rank[a.id].second, rank[a.id].first) <
+                   std::make_tuple(b.node, rank[b.id].second, rank[b.id].first);
+        });
+    } else {
+        std::stable_sort(_order.begin(), _order.end(), [&rank](const CpuInfo &a, const CpuInfo &b) {
+            return std::make_tuple(rank[a.id].first, rank[a.id].second, a.node) <
+                   std::make_tuple(rank[b.id].first, rank[b.id].second, b.node);
+        });
+    }
+}
+
+// See Placement.h
+Placement::Mode Placement::ParseMode(const std::string &name) {
+    if (name == "none") {
+        return Mode::kNone;
+    } else if (name == "pin") {
+        return Mode::kPin;
+    } else if (name == "compact") {
+        return Mode::kCompact;
+    } else if (name == "spread") {
+        return Mode::kSpread;
+    }
+    throw std::invalid_argument("Unknown placement mode: " + name);
+}
+
+// See Placement.h
+int Placement::CpuFor(std::size_t index) const { return _order.empty() ? -1 : _order[index % _order.size()].id; }
+
+// See Placement.h
+int Placement::NodeFor(std::size_t index) const { return _order.empty() ? -1 : _order[index % _order.size()].node; }
+
+// See Placement.h
+bool Placement::Apply(pthread_t thread, std::size_t index) const {
+    int cpu = CpuFor(index);
+    if (cpu < 0) {
+        return true;
+    }
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+} // namespace Concurrency
+} // namespace Afina
@@ -0,0 +1,286 @@
+#include <afina/concurrency/Scheduler.h>
+
+#include <limits>
+#include <stdexcept>
+
+#include <pthread.h>
+
+namespace Afina {
+namespace Concurrency {
+
+const Scheduler::TimerId Scheduler::kNoTimer;
+
+// See Scheduler.h
+Scheduler::Scheduler(std::string name, std::chrono::milliseconds tick)
+    : _name(std::move(name)), _tick(std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick)),
+      _start(std::chrono::steady_clock::now()), _running(true), _current(0),
+      _next_wakeup(std::numeric_limits<std::uint64_t>::max()), _size(0) {
+    if (tick.count() <= 0) {
+        throw std::invalid_argument("Scheduler tick must be positive");
+    }
+
+    for (auto &level : _wheel) {
+        for (auto &slot : level) {
+            slot.prev = slot.next = &slot;
+        }
+    }
+    _overflow.prev = _overflow.next = &_overflow;
+
+    _thread = std::thread(&Scheduler::Perform, this);
+}
+
+// See Scheduler.h
+Scheduler::~Scheduler() { Stop(); }
+
+// See Scheduler.h
+void Scheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+        _wakeup.notify_all();
+    }
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Scheduler.h
+bool Scheduler::Cancel(TimerId id) {
+    std::size_t index = std::size_t(id & 0xffffffffu);
+    std::uint32_t generation = std::uint32_t(id >> 32);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (index >= _timers.size() || _timers[index]->generation != generation) {
+        return false;
+    }
+
+    timer *t = _timers[index].get();
+    if (!t->scheduled) {
+        // Being executed: periodic one is not put back, one-shot one is done anyway
+        if (t->period == 0 || t->cancelled) {
+            return false;
+        }
+        t->cancelled = true;
+        return true;
+    }
+
+    Unlink(t);
+    _size--;
+    Release(t);
+    return true;
+}
+
+// See Scheduler.h
+std::size_t Scheduler::Size() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+// See Scheduler.h
+Scheduler::TimerId Scheduler::Schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period,
+                                       Task task) {
+    auto ticks = [this](std::chrono::milliseconds d) -> std::uint64_t {
+        auto duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(d);
+        if (duration.count() <= 0) {
+            return 0;
+        }
+        return std::uint64_t((duration + _tick - std::chrono::steady_clock::duration(1)) / _tick);
+    };
+    // Tick is counted from its start, so one more is needed to be sure that the whole delay has passed
+    std::uint64_t expires = Now() + ticks(delay) + 1;
+    std::uint64_t every = ticks(period);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+        return kNoTimer;
+    }
+
+    if (_free.empty()) {
+        if (_timers.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Too many timers");
+        }
+        _timers.emplace_back(new timer());
+        _timers.back()->index = std::uint32_t(_timers.size() - 1);
+        _timers.back()->generation = 1;
+        _free.push_back(std::uint32_t(_timers.size() - 1));
+    }
+    std::uint32_t index = _free.back();
+    _free.pop_back();
+
+    timer *t = _timers[index].get();
+    t->expires = expires > _current ? expires : _current + 1;
+    t->period = every;
+    t->scheduled = true;
+    t->cancelled = false;
+    t->task = std::move(task);
+    Insert(t);
+    _size++;
+
+    if (t->expires < _next_wakeup) {
+        _wakeup.notify_one();
+    }
+    return (TimerId(t->generation) << 32) | index;
+}
+
+// See Scheduler.h
+void Scheduler::Perform() {
+    // Thread names are limited to 15 characters
+    pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+
+    std::vector<timer *> expired;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        std::uint64_t now = Now();
+        if (_size == 0 && _current < now) {
+            // Empty wheel has nothing to cascade, no need to walk the ticks
+            _current = now;
+        }
+        while (_current < now) {
+            Advance(expired);
+        }
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (timer *t : expired) {
+                try {
+                    t->task();
+                } catch (...) {
+                    // Task is on its own with errors, timers go on
+                }
+            }
+            lock.lock();
+
+            for (timer *t : expired) {
+                if (t->period != 0 && !t->cancelled && _running) {
+                    // Fixed rate, but never in the past
+                    t->expires += t->period;
+                    if (t->expires <= _current) {
+                        t->expires = _current + 1;
+                    }
+                    t->scheduled = true;
+                    Insert(t);
+                    _size++;
+                } else {
+                    Release(t);
+                }
+            }
+            expired.clear();
+            continue;
+        }
+
+        _next_wakeup = NextWakeup();
+        if (_next_wakeup == std::numeric_limits<std::uint64_t>::max()) {
+            _wakeup.wait(lock);
+        } else {
+            _wakeup.wait_until(lock, _start + _tick * _next_wakeup);
+        }
+        _next_wakeup = std::numeric_limits<std::uint64_t>::max();
+    }
+}
+
+// See Scheduler.h
+std::uint64_t Scheduler::Now() const { return std::uint64_t((std::chrono::steady_clock::now() - _start) / _tick); }
+
+// See Scheduler.h
+void Scheduler::Insert(timer *t) {
+    for (std::size_t level = 0; level < kLevels; level++) {
+        unsigned shift = kLevelBits * unsigned(level);
+        if ((t->expires >> (shift + kLevelBits)) == (_current >> (shift + kLevelBits))) {
+            PushBack(_wheel[level][(t->expires >> shift) & (kSlots - 1)], t);
+            return;
+        }
+    }
+    PushBack(_overflow, t);
+}
+
+// See Scheduler.h
+void Scheduler::Cascade(link &list) {
+    if (list.next == &list) {
+        return;
+    }
+
+    // Detached first: timers from the overflow could go right back to it
+    link detached;
+    detached.next = list.next;
+    detached.prev = list.prev;
+    detached.next->prev = detached.prev->next = &detached;
+    list.prev = list.next = &list;
+
+    while (detached.next != &detached) {
+        timer *t = static_cast<timer *>(detached.next);
+        Unlink(t);
+        Insert(t);
+    }
+}
+
+// See Scheduler.h
+void Scheduler::Advance(std::vector<timer *> &expired) {
+    _current++;
+
+    // Upper levels go first, so that their timers could fall through the lower ones to level 0
+    if ((_current & ((std::uint64_t(1) << (kLevelBits * kLevels)) - 1)) == 0) {
+        Cascade(_overflow);
+    }
+    for (std::size_t level = kLevels - 1; level > 0; level--) {
+        unsigned shift = kLevelBits * unsigned(level);
+        if ((_current & ((std::uint64_t(1) << shift) - 1)) == 0) {
+            Cascade(_wheel[level][(_current >> shift) & (kSlots - 1)]);
+        }
+    }
+
+    link &slot = _wheel[0][_current & (kSlots - 1)];
+    while (slot.next != &slot) {
+        timer *t = static_cast<timer *>(slot.next);
+        Unlink(t);
+        t->scheduled = false;
+        _size--;
+        expired.push_back(t);
+    }
+}
+
+// See Scheduler.h
+std::uint64_t Scheduler::NextWakeup() const {
+    if (_size == 0) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    std::uint64_t base = _current & ~std::uint64_t(kSlots - 1);
+    for (std::size_t i = (_current & (kSlots - 1)) + 1; i < kSlots; i++) {
+        if (_wheel[0][i].next != &_wheel[0][i]) {
+            return base + i;
+        }
+    }
+
+    // Nothing on level 0 till the end of its rotation, where the cascade could bring something
+    return base + kSlots;
+}
+
+// See Scheduler.h
+void Scheduler::Release(timer *t) {
+    t->task = nullptr;
+    t->scheduled = false;
+    t->cancelled = false;
+    if (++t->generation == 0) {
+        t->generation = 1;
+    }
+    _free.push_back(t->index);
+}
+
+// See Scheduler.h
+void Scheduler::Unlink(link *l) {
+    l->prev->next = l->next;
+    l->next->prev = l->prev;
+    l->prev = l->next = l;
+}
+
+// See Scheduler.h
+void Scheduler::PushBack(link &list, link *l) {
+    l->prev = list.prev;
+    l->next = &list;
+    list.prev->next = l;
+    list.prev = l;
+}
+
+} // namespace Concurrency
+} // namespace Afina
@@ -0,0 +1,215 @@
+#include <afina/concurrency/StealingExecutor.h>
+
+#include <stdexcept>
+
+#include <pthread.h>
+
+namespace Afina {
+namespace Concurrency {
+
+namespace {
+
+// Pool and worker index of the calling thread, if it is a worker
+thread_local const StealingExecutor *current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+} // namespace
+
+// See StealingExecutor.h
+StealingExecutor::StealingExecutor(std::string name, std::size_t size, Placement placement)
+    : _name(std::move(name)), _state(State::kRun), _pending(0), _next_inbox(0), _alive(size), _sleeping(0) {
+    if (size == 0) {
+        throw std::invalid_argument("StealingExecutor needs at least one thread");
+    }
+
+    for (std::size_t i = 0; i < size; i++) {
+        _workers.emplace_back(new worker());
+        _workers.back()->random = uint32_t(i * 2654435761u + 1);
+    }
+
+    // Threads start once every worker is there to steal from
+    for (std::size_t i = 0; i < size; i++) {
+        _workers[i]->thread = std::thread(&StealingExecutor::Perform, this, i);
+
+        // Worker that could not be placed still runs, just anywhere
+        placement.Apply(_workers[i]->thread, i);
+    }
+}
+
+// See StealingExecutor.h
+StealingExecutor::~StealingExecutor() { Stop(true); }
+
+// See StealingExecutor.h
+void StealingExecutor::Stop(bool await) {
+    State expected = State::kRun;
+    if (_state.compare_exchange_strong(expected, State::kStopping)) {
+        Wake(true);
+    }
+
+    if (await) {
+        std::lock_guard<std::mutex> lock(_join_mutex);
+        for (auto &w : _workers) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+}
+
+// See StealingExecutor.h
+bool StealingExecutor::Submit(task *t) {
+    // Counted before the state check, so that workers could not see zero pending while task is on its way
+    _pending.fetch_add(1);
+    if (_state.load() != State::kRun) {
+        if (_pending.fetch_sub(1) == 1) {
+            Wake(true);
+        }
+        return false;
+    }
+
+    if (current_pool == this) {
+        _workers[current_index]->deque.Push(t);
+    } else {
+        worker &w = *_workers[_next_inbox.fetch_add(1, std::memory_order_relaxed) % _workers.size()];
+        std::lock_guard<std::mutex> lock(w.inbox_mutex);
+        w.inbox.push_back(t);
+    }
+
+    // Pairs with the fence of the worker going to sleep: either it sees the task or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_relaxed) != 0) {
+        Wake(false);
+    }
+    return true;
+}
+
+// See StealingExecutor.h
+void StealingExecutor::Perform(std::size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    // Thread names are limited to 15 characters
+    pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+
+    worker &w = *_workers[index];
+    for (;;) {
+        task *t = Next(w);
+        if (t != nullptr) {
+            try {
+                (*t)();
+            } catch (...) {
+                // Task is on its own with errors, the thread goes on
+            }
+            delete t;
+
+            if (_pending.fetch_sub(1) == 1 && _state.load() != State::kRun) {
+                Wake(true);
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleep_mutex);
+        _sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool done = false;
+        while (!HasWork()) {
+            if (_state.load() != State::kRun && _pending.load() == 0) {
+                done = true;
+                break;
+            }
+            _wakeup.wait(lock);
+        }
+        _sleeping.fetch_sub(1);
+        if (done) {
+            break;
+        }
+    }
+
+    if (_alive.fetch_sub(1) == 1) {
+        _state.store(State::kStopped);
+    }
+}
+
+// See StealingExecutor.h
+StealingExecutor::task *StealingExecutor::Next(worker &w) {
+    task *t = w.deque.Pop();
+    if (t == nullptr) {
+        t = DrainInbox(w);
+    }
+    if (t == nullptr) {
+        t = Steal(w);
+    }
+    return t;
+}
+
+// See StealingExecutor.h
+StealingExecutor::task *StealingExecutor::DrainInbox(worker &w) {
+    std::lock_guard<std::mutex> lock(w.inbox_mutex);
+    if (w.inbox.empty()) {
+        return nullptr;
+    }
+
+    task *t = w.inbox.front();
+    w.inbox.pop_front();
+    for (task *rest : w.inbox) {
+        w.deque.Push(rest);
+    }
+    w.inbox.clear();
+    return t;
+}
+
+// See StealingExecutor.h
+StealingExecutor::task *StealingExecutor::Steal(worker &w) {
+    // Every other worker is tried once, starting from a random one, so that thieves don't pile up
+    std::size_t n = _workers.size();
+    w.random = w.random * 1103515245u + 12345u;
+    std::size_t start = (w.random >> 16) % n;
+    for (std::size_t i = 0; i < n; i++) {
+        worker &victim = *_workers[(start + i) % n];
+        if (&victim == &w) {
+            continue;
+        }
+
+        task *t = victim.deque.Steal();
+        if (t != nullptr) {
+            return t;
+        }
+
+        // Inbox of a busy worker is up for grabs too, but not worth waiting for
+        std::unique_lock<std::mutex> lock(victim.inbox_mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.inbox.empty()) {
+            t = victim.inbox.front();
+            victim.inbox.pop_front();
+            return t;
+        }
+    }
+    return nullptr;
+}
+
+// See StealingExecutor.h
+bool StealingExecutor::HasWork() {
+    for (auto &w : _workers) {
+        if (w->deque.Size() != 0) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(w->inbox_mutex);
+        if (!w->inbox.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See StealingExecutor.h
+void StealingExecutor::Wake(bool all) {
+    std::lock_guard<std::mutex> lock(_sleep_mutex);
+    if (all) {
+        _wakeup.notify_all();
+    } else {
+        _wakeup.notify_one();
+    }
+}
+
+} // namespace Concurrency
+} // namespace Afina
@@ -1,19 +1,293 @@
 #include <afina/coroutine/Engine.h>
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <alloca.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Switch.h"
 
 namespace Afina {
 namespace Coroutine {
 
-void Engine::Store(context &ctx) {}
+const std::size_t Engine::kDefaultStackSize;
+
+// See Engine.h
+Engine::Engine(Mode mode, std::size_t stack_size, unblocker_func unblocker)
+    : StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr),
+      free_contexts(nullptr), _unblocker(unblocker), _mode(mode), _stack_size([stack_size] {
+          std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+          return (std::max(stack_size, page) + page - 1) / page * page;
+      }()) {
+    if (mode == Mode::kSeparateStack && !AFINA_COROUTINE_HAS_SWITCH) {
+        throw std::invalid_argument("Separate stacks are not supported on this platform");
+    }
+}
+
+// See Engine.h
+Engine::~Engine() {
+    for (context **list : {&alive, &blocked, &free_contexts}) {
+        while (*list != nullptr) {
+            context *ctx = *list;
+            *list = ctx->next;
+            delete[] std::get<0>(ctx->Stack);
+            if (ctx->Mapping != nullptr) {
+                munmap(ctx->Mapping, ctx->MappingSize);
+            }
+            delete ctx;
+        }
+    }
+}
+
+// See Engine.h
+Engine::Mode Engine::ParseMode(const std::string &name) {
+    if (name == "copy") {
+        return Mode::kCopyStack;
+    } else if (name == "separate") {
+        return Mode::kSeparateStack;
+    }
+    throw std::invalid_argument("Unknown coroutine mode: " + name);
+}
+
+// See Engine.h
+void Engine::Store(context &ctx) {
+    char StackStartsHere;
+    if (&StackStartsHere < StackBottom) {
+        ctx.Low = &StackStartsHere;
+        ctx.Hight = StackBottom;
+    } else {
+        ctx.Low = StackBottom;
+        ctx.Hight = &StackStartsHere;
+    }
+
+    // Buffer only grows, routine that went deep once is likely to go there again
+    uint32_t size = uint32_t(ctx.Hight - ctx.Low);
+    if (std::get<1>(ctx.Stack) < size) {
+        delete[] std::get<0>(ctx.Stack);
+        uint32_t capacity = std::max(size, std::get<1>(ctx.Stack) * 2);
+        ctx.Stack = std::make_tuple(new char[capacity], capacity);
+    }
+    memcpy(std::get<0>(ctx.Stack), ctx.Low, size);
+}
+
+// See Engine.h
+void Engine::Restore(context &ctx) {
+    // Frame doing the copy must not be overwritten by the stack being restored: move stack pointer out of
+    // the way and start over from the frame below it
+    char StackStartsHere;
+    if (ctx.Low <= &StackStartsHere && &StackStartsHere <= ctx.Hight) {
+        std::size_t gap = StackBottom > &StackStartsHere ? &StackStartsHere - ctx.Low : ctx.Hight - &StackStartsHere;
+        volatile char *pad = static_cast<char *>(alloca(gap + 256));
+        pad[0] = 0;
+        Restore(ctx);
+    }
+
+    memcpy(ctx.Low, std::get<0>(ctx.Stack), ctx.Hight - ctx.Low);
+    cur_routine = &ctx == idle_ctx ? nullptr : &ctx;
+    longjmp(ctx.Environment, 1);
+}
+
+// See Engine.h
+void Engine::yield() {
+    context *next = alive;
+    while (next != nullptr && next == cur_routine) {
+        next = next->next;
+    }
+
+    if (next != nullptr) {
+        Enter(*next);
+    } else if (cur_routine != nullptr && cur_routine->is_blocked) {
+        // Nothing to run, but current routine can't go on: engine waits for someone to be unblocked
+        Enter(*idle_ctx);
+    }
+}
+
+// See Engine.h
+void Engine::sched(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr) {
+        yield();
+    } else if (routine != cur_routine && !routine->is_blocked) {
+        Enter(*routine);
+    }
+}
+
+// See Engine.h
+void Engine::block(void *coro) {
+    context *routine = coro == nullptr ? cur_routine : static_cast<context *>(coro);
+    if (routine == nullptr || routine->is_blocked) {
+        return;
+    }
+
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        alive = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->is_blocked = true;
+    routine->prev = nullptr;
+    routine->next = blocked;
+    if (blocked != nullptr) {
+        blocked->prev = routine;
+    }
+    blocked = routine;
+
+    if (routine == cur_routine) {
+        yield();
+    }
+}
+
+// See Engine.h
+void Engine::unblock(void *coro) {
+    context *routine = static_cast<context *>(coro);
+    if (routine == nullptr || !routine->is_blocked) {
+        return;
+    }
+
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        blocked = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->is_blocked = false;
+    routine->prev = nullptr;
+    routine->next = alive;
+    if (alive != nullptr) {
+        alive->prev = routine;
+    }
+    alive = routine;
+}
+
+// See Engine.h
+Engine::context *Engine::NewContext() {
+    if (free_contexts == nullptr) {
+        return new context();
+    }
+
+    context *ctx = free_contexts;
+    free_contexts = ctx->next;
+    ctx->next = nullptr;
+    return ctx;
+}
+
+// See Engine.h
+void Engine::FreeContext(context *ctx) {
+    ctx->Low = ctx->Hight = nullptr;
+    ctx->is_blocked = false;
+    ctx->prev = nullptr;
+    ctx->next = free_contexts;
+    free_contexts = ctx;
+}
+
+// See Engine.h
+void Engine::Enter(context &ctx) {
+    if (_mode == Mode::kSeparateStack) {
+        context *from = cur_routine != nullptr ? cur_routine : idle_ctx;
+        cur_routine = &ctx == idle_ctx ? nullptr : &ctx;
+        afina_coroutine_switch(&from->StackPointer, ctx.StackPointer);
+        return;
+    }
+
+    // Idle context is never saved here: it is always entered at the scheduling loop of start()
+    if (cur_routine != nullptr) {
+        if (setjmp(cur_routine->Environment) > 0) {
+            // Resumed by someone
+            return;
+        }
+        Store(*cur_routine);
+    }
+    Restore(ctx);
+}
+
+// See Engine.h
+void *Engine::Spawn(std::function<void()> entry) {
+    context *pc = NewContext();
+    if (pc->Mapping == nullptr) {
+        // Guard page goes below the stack as it grows down
+        std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+        void *mapping = mmap(nullptr, _stack_size + page, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            FreeContext(pc);
+            return nullptr;
+        }
+        if (mprotect(mapping, page, PROT_NONE) != 0) {
+            munmap(mapping, _stack_size + page);
+            FreeContext(pc);
+            return nullptr;
+        }
+        pc->Mapping = static_cast<char *>(mapping);
+        pc->MappingSize = _stack_size + page;
+    }
+
+    pc->Entry = std::move(entry);
+    pc->StackPointer = PrepareStack(pc->Mapping + pc->MappingSize, &Engine::Boot, this);
+
+    // Add routine as alive double-linked list
+    pc->next = alive;
+    alive = pc;
+    if (pc->next != nullptr) {
+        pc->next->prev = pc;
+    }
+
+    return pc;
+}
+
+// See Engine.h
+void Engine::Loop(context *main) {
+    if (main != nullptr) {
+        Enter(*main);
+    }
+
+    // Back here once there is no one to switch to
+    for (;;) {
+        if (alive == nullptr) {
+            _unblocker(*this);
+        }
+        if (alive == nullptr) {
+            break;
+        }
+        Enter(*alive);
+    }
+}
+
+// See Engine.h
+void Engine::Boot(void *engine_) {
+    Engine &engine = *static_cast<Engine *>(engine_);
+    context *pc = engine.cur_routine;
+    pc->Entry();
+    pc->Entry = nullptr;
+
+    // Same as the end of the routine in run(): the context and its stack go back to the pool, while we are still
+    // on that stack. That is fine as nobody takes it before we switch away
+    if (pc->prev != nullptr) {
+        pc->prev->next = pc->next;
+    }
 
-void Engine::Restore(context &ctx) {}
+    if (pc->next != nullptr) {
+        pc->next->prev = pc->prev;
+    }
 
-void Engine::yield() {}
+    if (engine.alive == pc) {
+        engine.alive = engine.alive->next;
+    }
 
-void Engine::sched(void *routine_) {}
+    engine.FreeContext(pc);
+    engine.Enter(*engine.idle_ctx);
+}
 
 } // namespace Coroutine
 } // namespace Afina
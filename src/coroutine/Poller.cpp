@@ -0,0 +1,235 @@
+#include <afina/coroutine/Poller.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Coroutine {
+
+// See Poller.h
+Poller::Poller(Engine &engine) : _engine(engine), _waiting(0), _shutdown(false) {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+    _engine.set_unblocker([this](Engine &) { Poll(-1); });
+}
+
+// See Poller.h
+Poller::~Poller() {
+    _engine.set_unblocker(Engine::unblocker_func());
+    close(_epoll_fd);
+}
+
+// See Poller.h
+ssize_t Poller::Read(int fd, void *buf, std::size_t count) {
+    for (;;) {
+        ssize_t n = read(fd, buf, count);
+        if (n >= 0) {
+            return n;
+        } else if (errno == EINTR) {
+            continue;
+        } else if ((errno != EAGAIN && errno != EWOULDBLOCK) || !Wait(fd, EPOLLIN)) {
+            return -1;
+        }
+    }
+}
+
+// See Poller.h
+ssize_t Poller::Write(int fd, const void *buf, std::size_t count) {
+    for (;;) {
+        ssize_t n = write(fd, buf, count);
+        if (n >= 0) {
+            return n;
+        } else if (errno == EINTR) {
+            continue;
+        } else if ((errno != EAGAIN && errno != EWOULDBLOCK) || !Wait(fd, EPOLLOUT)) {
+            return -1;
+        }
+    }
+}
+
+// See Poller.h
+int Poller::Accept(int fd, struct sockaddr *addr, socklen_t *addrlen) {
+    for (;;) {
+        int client = accept4(fd, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client >= 0) {
+            return client;
+        } else if (errno == EINTR) {
+            continue;
+        } else if ((errno != EAGAIN && errno != EWOULDBLOCK) || !Wait(fd, EPOLLIN)) {
+            return -1;
+        }
+    }
+}
+
+// See Poller.h
+bool Poller::Wait(int fd, uint32_t events) {
+    void *self = _engine.current();
+    if (_shutdown) {
+        errno = ECANCELED;
+        return false;
+    } else if (self == nullptr) {
+        errno = EINVAL;
+        return false;
+    }
+
+    auto it = _fds.find(fd);
+    if (it == _fds.end()) {
+        // Edge-triggered for both directions at once: edges that come while nobody waits are dropped, but
+        // whoever waits next tries the syscall first anyway
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return false;
+        }
+        it = _fds.emplace(fd, waiters()).first;
+    }
+
+    void *&slot = (events & EPOLLIN) ? it->second.reader : it->second.writer;
+    if (slot != nullptr) {
+        errno = EBUSY;
+        return false;
+    }
+
+    slot = self;
+    _waiting++;
+    _engine.block();
+
+    // Poll and Shutdown clear the slot, anyone else unblocking the routine just makes it try once again
+    if (slot == self) {
+        slot = nullptr;
+        _waiting--;
+    }
+    if (_shutdown) {
+        errno = ECANCELED;
+        return false;
+    }
+    return true;
+}
+
+// See Poller.h
+bool Poller::Sleep(std::chrono::milliseconds timeout) {
+    void *self = _engine.current();
+    if (_shutdown) {
+        errno = ECANCELED;
+        return false;
+    } else if (self == nullptr) {
+        errno = EINVAL;
+        return false;
+    }
+
+    auto key = std::make_pair(std::chrono::steady_clock::now() + timeout, self);
+    _sleepers.insert(key);
+    _waiting++;
+    _engine.block();
+
+    // Same as in Wait: if it is still there, someone else has woken the routine
+    if (_sleepers.erase(key) > 0) {
+        _waiting--;
+    }
+    if (_shutdown) {
+        errno = ECANCELED;
+        return false;
+    }
+    return true;
+}
+
+// See Poller.h
+int Poller::Close(int fd) {
+    // Closed descriptor leaves epoll by itself
+    _fds.erase(fd);
+    return close(fd);
+}
+
+// See Poller.h
+std::size_t Poller::Poll(int timeout) {
+    std::size_t woken = 0;
+    std::array<struct epoll_event, 64> events;
+    while (_waiting > 0 && woken == 0) {
+        // Don't oversleep the first sleeper
+        int wait = timeout;
+        if (!_sleepers.empty()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(_sleepers.begin()->first -
+                                                                              std::chrono::steady_clock::now()) +
+                        std::chrono::milliseconds(1);
+            int left_ms = int(std::max<long>(0, std::min<long>(left.count(), 1 << 30)));
+            wait = timeout < 0 ? left_ms : std::min(timeout, left_ms);
+        }
+
+        int n = epoll_wait(_epoll_fd, events.data(), events.size(), wait);
+        if (n == -1 && errno != EINTR) {
+            throw std::runtime_error("Failed to wait for epoll events: " + std::string(strerror(errno)));
+        }
+
+        for (int i = 0; i < n; i++) {
+            auto it = _fds.find(events[i].data.fd);
+            if (it == _fds.end()) {
+                continue;
+            }
+
+            waiters &fd = it->second;
+            if (fd.reader != nullptr && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP))) {
+                _engine.unblock(fd.reader);
+                fd.reader = nullptr;
+                _waiting--;
+                woken++;
+            }
+            if (fd.writer != nullptr && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                _engine.unblock(fd.writer);
+                fd.writer = nullptr;
+                _waiting--;
+                woken++;
+            }
+        }
+        woken += WakeSleepers(std::chrono::steady_clock::now());
+
+        if (timeout >= 0) {
+            break;
+        }
+    }
+    return woken;
+}
+
+// See Poller.h
+void Poller::Shutdown() {
+    _shutdown = true;
+    for (auto &sleeper : _sleepers) {
+        _engine.unblock(sleeper.second);
+        _waiting--;
+    }
+    _sleepers.clear();
+    for (auto &fd : _fds) {
+        for (void **slot : {&fd.second.reader, &fd.second.writer}) {
+            if (*slot != nullptr) {
+                _engine.unblock(*slot);
+                *slot = nullptr;
+                _waiting--;
+            }
+        }
+    }
+}
+
+// See Poller.h
+std::size_t Poller::WakeSleepers(time_point now) {
+    std::size_t woken = 0;
+    while (!_sleepers.empty() && _sleepers.begin()->first <= now) {
+        _engine.unblock(_sleepers.begin()->second);
+        _sleepers.erase(_sleepers.begin());
+        _waiting--;
+        woken++;
+    }
+    return woken;
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -0,0 +1,137 @@
+#include "Switch.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace Afina {
+namespace Coroutine {
+
+#if defined(__x86_64__)
+
+// Frame of the switch, from the stack pointer up: mxcsr and x87 control word, r15, r14, r13, r12, rbx, rbp and
+// return address. New stack starts in afina_coroutine_boot with arg in r12 and entry in r13
+asm(R"(
+    .pushsection .text
+    .globl afina_coroutine_switch
+    .type afina_coroutine_switch, @function
+afina_coroutine_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size afina_coroutine_switch, .-afina_coroutine_switch
+
+    .type afina_coroutine_boot, @function
+afina_coroutine_boot:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size afina_coroutine_boot, .-afina_coroutine_boot
+    .popsection
+)");
+
+extern "C" void afina_coroutine_boot();
+
+// See Switch.h
+void *PrepareStack(char *top, void (*entry)(void *), void *arg) {
+    // Call from boot pushes return address, so entry gets stack aligned as ABI requires
+    uint64_t *sp = reinterpret_cast<uint64_t *>(reinterpret_cast<uintptr_t>(top) & ~uintptr_t(15));
+    *--sp = reinterpret_cast<uint64_t>(&afina_coroutine_boot);
+    *--sp = 0;                                 // rbp
+    *--sp = 0;                                 // rbx
+    *--sp = reinterpret_cast<uint64_t>(arg);   // r12
+    *--sp = reinterpret_cast<uint64_t>(entry); // r13
+    *--sp = 0;                                 // r14
+    *--sp = 0;                                 // r15
+    *--sp = (uint64_t(0x037F) << 32) | 0x1F80; // default x87 control word and mxcsr
+    return sp;
+}
+
+#elif defined(__aarch64__)
+
+// Frame of the switch, from the stack pointer up: x19-x28, x29 (frame pointer), x30 (return address) and d8-d15.
+// New stack starts in afina_coroutine_boot with arg in x19 and entry in x20
+asm(R"(
+    .pushsection .text
+    .globl afina_coroutine_switch
+    .type afina_coroutine_switch, %function
+afina_coroutine_switch:
+    sub sp, sp, #160
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x2, sp
+    str x2, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #160
+    ret
+    .size afina_coroutine_switch, .-afina_coroutine_switch
+
+    .type afina_coroutine_boot, %function
+afina_coroutine_boot:
+    mov x0, x19
+    blr x20
+    brk #0
+    .size afina_coroutine_boot, .-afina_coroutine_boot
+    .popsection
+)");
+
+extern "C" void afina_coroutine_boot();
+
+// See Switch.h
+void *PrepareStack(char *top, void (*entry)(void *), void *arg) {
+    uint64_t *sp = reinterpret_cast<uint64_t *>(reinterpret_cast<uintptr_t>(top) & ~uintptr_t(15)) - 20;
+    std::memset(sp, 0, 20 * sizeof(uint64_t));
+    sp[0] = reinterpret_cast<uint64_t>(arg);                    // x19
+    sp[1] = reinterpret_cast<uint64_t>(entry);                  // x20
+    sp[11] = reinterpret_cast<uint64_t>(&afina_coroutine_boot); // x30
+    return sp;
+}
+
+#else
+
+// See Switch.h
+extern "C" void afina_coroutine_switch(void **, void *) { std::abort(); }
+
+// See Switch.h
+void *PrepareStack(char *, void (*)(void *), void *) { std::abort(); }
+
+#endif
+
+} // namespace Coroutine
+} // namespace Afina
@@ -0,0 +1,30 @@
+#ifndef AFINA_COROUTINE_SWITCH_H
+#define AFINA_COROUTINE_SWITCH_H
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define AFINA_COROUTINE_HAS_SWITCH 1
+#else
+#define AFINA_COROUTINE_HAS_SWITCH 0
+#endif
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Context switch between separate stacks
+ * Pushes callee saved registers onto the current stack, stores stack pointer into *from and pops registers of
+ * the other context from the stack pointer to. Everything else is saved by the caller already, as for any other
+ * function call, so the switch costs the same whatever deep the stacks are
+ */
+extern "C" void afina_coroutine_switch(void **from, void *to);
+
+/**
+ * Lays out the stack ending at top so that the first switch to the returned stack pointer calls entry(arg).
+ * Entry must never return, it has to switch away instead
+ */
+void *PrepareStack(char *top, void (*entry)(void *), void *arg);
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_SWITCH_H
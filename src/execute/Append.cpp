@@ -9,13 +9,12 @@ namespace Execute {
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::cout << "Append(" << _key << ")" << args << std::endl;
-    std::string value;
-    if (!storage.Get(_key, value)) {
+    // append ignores flags and exptime of the command, item keeps its own
+    if (storage.Append(_key, args)) {
+        out.assign("STORED");
+    } else {
         out.assign("NOT_STORED");
-        return;
     }
-    storage.Put(_key, value + args);
-    out.assign("STORED");
 }
 
 } // namespace Execute
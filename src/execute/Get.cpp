@@ -12,7 +12,7 @@ namespace Execute {
 
 Each item sent by the server looks like this:
 
-VALUE <key> <flags> <bytes>\r\n
+VALUE <key> <flags> <bytes> [<cas unique>]\r\n
 <data block>\r\n
 
 After all the items have been transmitted, the server sends the string
@@ -29,10 +29,16 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::stringstream outStream;
 
     std::string value;
+    ItemHeader header;
     for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+        // Client missing the key is going to set it, so concurrent gets don't all go to the database
+        if (!storage.LeaseGet(key, value, header))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
+        outStream << "VALUE " << key << " " << header.flags << " " << value.size();
+        if (_with_cas) {
+            outStream << " " << header.cas;
+        }
+        outStream << "\r\n";
         outStream << value << "\r\n";
     }
     outStream << "END"; // networking layer should add the last \r\n
@@ -8,7 +8,28 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Each statistic is sent as
+
+STAT <name> <value>\r\n
+
+and the list is terminated by "END\r\n"
+
+*/
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+
+    std::stringstream outStream;
+    for (auto &stat : stats) {
+        outStream << "STAT " << stat.first << " " << stat.second << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
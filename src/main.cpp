@@ -1,6 +1,8 @@
 #include <chrono>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 
 #include <atomic>
 #include <semaphore.h>
@@ -11,6 +13,8 @@
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/concurrency/Placement.h>
+#include <afina/coroutine/Engine.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
@@ -21,9 +25,13 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/Loader.h"
+#include "storage/NamespacedLRU.h"
+#include "storage/ReadThroughStorage.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 #include "storage/StripedLRU.h"
+#include "storage/StripedLeaseLRU.h"
 
 using namespace Afina;
 
@@ -52,32 +60,84 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Values of that size and above are stored compressed, 0 turns compression off
+        size_t compress_threshold = 0;
+        if (options.count("compress") > 0) {
+            compress_threshold = options["compress"].as<size_t>();
+        }
+
+        // Memory for slabs of lru storages, 0 means no limit
+        size_t slab_memory = 0;
+        if (options.count("slab-memory") > 0) {
+            slab_memory = options["slab-memory"].as<size_t>();
+        }
+
+        // Bytes moved by a single step of mt_lru slab mover
+        size_t slab_move_step = 64 * 1024;
+        if (options.count("slab-move-step") > 0) {
+            slab_move_step = options["slab-move-step"].as<size_t>();
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(1024, compress_threshold, nullptr, slab_memory);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimpleLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimpleLRU>(
+                1024, compress_threshold, slab_memory, std::chrono::milliseconds(1000), slab_move_step);
         } else if (storage_type == "mt_slru") {
-            storage = Afina::Backend::StripedLRU::CreateStorage(1024*1024*512, 4);
+            storage = Afina::Backend::StripedLRU::CreateStorage(1024*1024*512, 4, compress_threshold);
+        } else if (storage_type == "mt_lease") {
+            storage = Afina::Backend::StripedLeaseLRU::CreateStorage(1024*1024*512, 4);
+        } else if (storage_type == "mt_ns") {
+            // Namespace quotas as a comma separated list of <name>=<bytes>
+            std::map<std::string, size_t> quotas;
+            if (options.count("namespaces") > 0) {
+                std::stringstream list(options["namespaces"].as<std::string>());
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    size_t eq = item.find('=');
+                    if (eq == std::string::npos) {
+                        throw std::runtime_error("Invalid namespace quota: " + item);
+                    }
+                    quotas[item.substr(0, eq)] = std::stoull(item.substr(eq + 1));
+                }
+            }
+            storage = std::make_shared<Afina::Backend::NamespacedLRU>(1024*1024*512, quotas);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Backfill misses from the external loader if there is one
+        if (options.count("loader") > 0) {
+            auto loader = Afina::Backend::Loader::Connect(options["loader"].as<std::string>());
+            storage = std::make_shared<Afina::Backend::ReadThroughStorage>(storage, std::move(loader));
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
             network_type = options["network"].as<std::string>();
         }
 
+        Afina::Concurrency::Placement placement;
+        if (options.count("affinity") > 0) {
+            placement = Afina::Concurrency::Placement(
+                Afina::Concurrency::Placement::ParseMode(options["affinity"].as<std::string>()));
+        }
+
         if (network_type == "st_block") {
             server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
         } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService, placement);
         } else if (network_type == "st_nonblock") {
             server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, placement);
         } else if (network_type == "st_coroutine") {
-            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+            auto mode = Afina::Coroutine::Engine::Mode::kCopyStack;
+            if (options.count("coroutine-stack") > 0) {
+                mode = Afina::Coroutine::Engine::ParseMode(options["coroutine-stack"].as<std::string>());
+            }
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService, mode);
         } else {
             throw std::runtime_error("Unknown network type");
         }
@@ -135,6 +195,19 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("namespaces", "Namespace quotas for mt_ns storage: <name>=<bytes>,...",
+                              cxxopts::value<std::string>());
+        options.add_options()("compress", "Compress values of that many bytes and above in lru storages",
+                              cxxopts::value<size_t>());
+        options.add_options()("slab-memory", "Memory limit for slabs of st_lru and mt_lru storages in bytes",
+                              cxxopts::value<size_t>());
+        options.add_options()("slab-move-step", "Bytes moved by a single step of mt_lru slab mover under the lock",
+                              cxxopts::value<size_t>());
+        options.add_options()("affinity", "Placement of mt_block and mt_nonblock threads: none, pin, compact, spread",
+                              cxxopts::value<std::string>());
+        options.add_options()("coroutine-stack", "Stacks of st_coroutine routines: copy, separate",
+                              cxxopts::value<std::string>());
+        options.add_options()("l,loader", "Unix socket of the read-through loader", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -28,7 +28,9 @@ namespace Network {
 namespace MTblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       Concurrency::Placement placement)
+    : Server(ps, pl), _placement(std::move(placement)) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -37,7 +39,8 @@ ServerImpl::~ServerImpl() {}
 void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     _logger = pLogging->select("network");
     _logger->info("Start mt_blocking network service");
-    _max_threads = n_workers;
+    _executor.reset(new Concurrency::Executor("mt_blocking", 1, n_workers, n_workers, std::chrono::seconds(5),
+                                              {Concurrency::Executor::Lane()}, _placement));
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -85,6 +88,10 @@ void ServerImpl::Stop() {
     for (auto socket: _sockets) {
         shutdown(socket, SHUT_RD);
     }
+    // Could be stopped before it was started
+    if (_executor) {
+        _executor->Stop();
+    }
 }
 
 // See Server.h
@@ -175,8 +182,11 @@ void ServerImpl::ExecutableFunction(const int client_socket) {
         } else {
             throw std::runtime_error(std::string(strerror(errno)));
         }
-    } catch (std::runtime_error &ex) {
+    } catch (std::exception &ex) {
         _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    } catch (...) {
+        // Socket must be unregistered whatever happened, otherwise OnRun waits for it forever on stop
+        _logger->error("Failed to process connection on descriptor {}: unknown error", client_socket);
     }
     {
         std::unique_lock<std::mutex> _lock_thread(_mutex);
@@ -231,13 +241,13 @@ void ServerImpl::OnRun() {
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
 
-        // TODO: Start new thread and process data from/to connection
+        // Process data from/to connection on the pool, socket is registered before so that the task
+        // could unregister it
         {
             std::lock_guard<std::mutex> _connection_lock(_mutex);
-            if ((_sockets.size() + 1) <= _max_threads && running) {
-                _sockets.insert(client_socket);
-                std::thread(&ServerImpl::ExecutableFunction, this, client_socket).detach();
-            } else {
+            _sockets.insert(client_socket);
+            if (!running || !_executor->Execute(&ServerImpl::ExecutableFunction, this, client_socket)) {
+                _sockets.erase(client_socket);
                 close(client_socket);
             }
         }
@@ -248,6 +258,7 @@ void ServerImpl::OnRun() {
             _wait_stop.wait(_lock);
         }
     }
+    _executor->Stop(true);
 
     // Cleanup on exit...
     _logger->warn("Network stopped");
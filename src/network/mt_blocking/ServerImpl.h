@@ -5,7 +5,10 @@
 #include <thread>
 #include <set>
 #include <condition_variable>
+#include <memory>
 
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/Placement.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -18,11 +21,14 @@ namespace MTblocking {
 
 /**
  * # Network resource manager implementation
- * Server that is spawning a separate thread for each connection
+ * Server that serves each connection by a separate thread of the pool. Connections that find every
+ * worker busy wait in the pool queue, the ones that find queue full are closed right away. Pool threads
+ * are pinned to CPUs by the placement
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               Concurrency::Placement placement = Concurrency::Placement());
     ~ServerImpl();
 
     // See Server.h
@@ -54,8 +60,11 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
-    // Number of maximum working threads.
-    size_t _max_threads;
+    // CPUs of the connection workers
+    const Concurrency::Placement _placement;
+
+    // Connection workers, at most n_workers of them
+    std::unique_ptr<Concurrency::Executor> _executor;
 
     // Thread to run network on
     std::thread _thread;
@@ -30,7 +30,9 @@ namespace Network {
 namespace MTnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       Concurrency::Placement placement)
+    : Server(ps, pl), _placement(std::move(placement)) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -97,13 +99,16 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.back().Start(_data_epoll_fd, _placement, i);
     }
 
     // Start acceptors
     _acceptors.reserve(n_acceptors);
     for (int i = 0; i < n_acceptors; i++) {
         _acceptors.emplace_back(&ServerImpl::OnRun, this);
+        if (!_placement.Apply(_acceptors.back(), n_workers + i)) {
+            _logger->warn("Failed to pin acceptor {} to cpu {}", i, _placement.CpuFor(n_workers + i));
+        }
     }
 }
 
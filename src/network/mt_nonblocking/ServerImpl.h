@@ -4,6 +4,7 @@
 #include <thread>
 #include <vector>
 
+#include <afina/concurrency/Placement.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -19,11 +20,12 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server. Workers and then acceptors are pinned to CPUs by the placement, in that order
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               Concurrency::Placement placement = Concurrency::Placement());
     ~ServerImpl();
 
     // See Server.h
@@ -43,6 +45,9 @@ private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
 
+    // CPUs of the threads
+    const Concurrency::Placement _placement;
+
     // Port to listen for new connections, permits access only from
     // inside of accept_thread
     // Read-only
@@ -47,12 +47,15 @@ Worker &Worker::operator=(Worker &&other) {
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int epoll_fd, const Concurrency::Placement &placement, size_t index) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
         _logger = _pLogging->select("network.worker");
         _thread = std::thread(&Worker::OnRun, this);
+        if (!placement.Apply(_thread, index)) {
+            _logger->warn("Failed to pin worker {} to cpu {}", index, placement.CpuFor(index));
+        }
     }
 }
 
@@ -5,6 +5,8 @@
 #include <memory>
 #include <thread>
 
+#include <afina/concurrency/Placement.h>
+
 namespace spdlog {
 class logger;
 }
@@ -36,9 +38,10 @@ public:
     /**
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * on this thread. Thread is pinned as the index-th one of the placement, or runs anywhere if it
+     * could not be
      */
-    void Start(int epoll_fd);
+    void Start(int epoll_fd, const Concurrency::Placement &placement = Concurrency::Placement(), size_t index = 0);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
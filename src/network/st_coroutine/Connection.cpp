@@ -1,25 +1,110 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+
+#include "protocol/Parser.h"
 
 namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
 // See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+void Connection::Run(Coroutine::Poller &poller) {
+    // Connection state, see st_blocking
+    std::size_t arg_remains = 0;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
 
-// See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+    try {
+        ssize_t readed_bytes = -1;
+        char client_buffer[4096];
+        while ((readed_bytes = poller.Read(_socket, client_buffer, sizeof(client_buffer))) > 0) {
+            _logger->debug("Got {} bytes from socket", readed_bytes);
 
-// See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+            while (readed_bytes > 0) {
+                // There is no command yet
+                if (!command_to_execute) {
+                    std::size_t parsed = 0;
+                    if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        command_to_execute = parser.Build(arg_remains);
+                        if (arg_remains > 0) {
+                            arg_remains += 2;
+                        }
+                    }
 
-// See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+                    if (parsed == 0) {
+                        break;
+                    } else {
+                        std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                        readed_bytes -= parsed;
+                    }
+                }
+
+                // There is command, but we still wait for argument to arrive...
+                if (command_to_execute && arg_remains > 0) {
+                    std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
+                    argument_for_command.append(client_buffer, to_read);
+
+                    std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                    arg_remains -= to_read;
+                    readed_bytes -= to_read;
+                }
+
+                // There is command & argument - RUN!
+                if (command_to_execute && arg_remains == 0) {
+                    std::string result;
+                    if (argument_for_command.size()) {
+                        argument_for_command.resize(argument_for_command.size() - 2);
+                    }
+                    command_to_execute->Execute(*pStorage, argument_for_command, result);
+
+                    result += "\r\n";
+                    Send(poller, result);
+
+                    // Prepare for the next command
+                    command_to_execute.reset();
+                    argument_for_command.resize(0);
+                    parser.Reset();
+                }
+            } // while (readed_bytes)
+        }
+
+        if (readed_bytes == 0) {
+            _logger->debug("Connection closed");
+        } else if (errno == ECANCELED) {
+            _logger->debug("Connection on descriptor {} dropped on stop", _socket);
+        } else {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+    }
+
+    poller.Close(_socket);
+}
 
 // See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+void Connection::Send(Coroutine::Poller &poller, const std::string &data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = poller.Write(_socket, data.data() + sent, data.size() - sent);
+        if (n <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+        sent += n;
+    }
+}
 
 } // namespace STcoroutine
 } // namespace Network
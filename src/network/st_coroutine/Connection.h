@@ -1,36 +1,47 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 #define AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 
-#include <cstring>
+#include <memory>
+#include <string>
 
-#include <sys/epoll.h>
+#include <afina/coroutine/Poller.h>
+
+namespace spdlog {
+class logger;
+}
 
 namespace Afina {
+class Storage;
+
 namespace Network {
 namespace STcoroutine {
 
+/**
+ * # Client connection
+ * Serves the client in the straight-line manner of st_blocking, but all IO goes through poller, so waiting for
+ * the client blocks only the coroutine of the connection
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
-
-    inline bool isAlive() const { return true; }
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl)
+        : _socket(s), pStorage(ps), _logger(pl) {}
 
-    void Start();
+    /**
+     * Reads commands and sends responses until client goes away or poller is shut down, closes socket at the end.
+     * Must be called from the coroutine of the connection
+     */
+    void Run(Coroutine::Poller &poller);
 
 protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
+    // Sends the whole buffer, throws std::runtime_error on failure
+    void Send(Coroutine::Poller &poller, const std::string &data);
 
 private:
-    friend class ServerImpl;
-
     int _socket;
-    struct epoll_event _event;
+
+    std::shared_ptr<Afina::Storage> pStorage;
+
+    std::shared_ptr<spdlog::logger> _logger;
 };
 
 } // namespace STcoroutine
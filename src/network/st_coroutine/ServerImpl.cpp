@@ -10,7 +10,6 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <signal.h>
-#include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -28,8 +27,12 @@ namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
+const std::chrono::milliseconds ServerImpl::kAcceptBackoff(100);
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       Coroutine::Engine::Mode mode)
+    : Server(ps, pl), _mode(mode) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -37,7 +40,7 @@ ServerImpl::~ServerImpl() {}
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start st_nonblocking network service");
+    _logger->info("Start st_coroutine network service");
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -87,9 +90,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup coroutine waiting for the stop
     if (eventfd_write(_event_fd, 1)) {
-        throw std::runtime_error("Failed to wakeup workers");
+        throw std::runtime_error("Failed to wakeup coroutines");
     }
 }
 
@@ -101,126 +104,70 @@ void ServerImpl::Join() {
 
 // See ServerImpl.h
 void ServerImpl::OnRun() {
-    _logger->info("Start acceptor");
-    int epoll_descr = epoll_create1(0);
-    if (epoll_descr == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
-
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _server_socket, &event)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
-    }
-
-    struct epoll_event event2;
-    event2.events = EPOLLIN;
-    event2.data.fd = _event_fd;
-    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _event_fd, &event2)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
-    }
-
-    bool run = true;
-    std::array<struct epoll_event, 64> mod_list;
-    while (run) {
-        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
-        _logger->debug("Acceptor wokeup: {} events", nmod);
-
-        for (int i = 0; i < nmod; i++) {
-            struct epoll_event &current_event = mod_list[i];
-            if (current_event.data.fd == _event_fd) {
-                _logger->debug("Break acceptor due to stop signal");
-                run = false;
-                continue;
-            } else if (current_event.data.fd == _server_socket) {
-                OnNewConnection(epoll_descr);
-                continue;
-            }
-
-            // That is some connection!
-            Connection *pc = static_cast<Connection *>(current_event.data.ptr);
-
-            auto old_mask = pc->_event.events;
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                pc->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pc->OnClose();
-            } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    pc->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    pc->DoWrite();
-                }
-            }
-
-            // Does it alive?
-            if (!pc->isAlive()) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
-                }
+    _logger->info("Start coroutines");
 
-                close(pc->_socket);
-                pc->OnClose();
+    // Engine and poller are above the stack of coroutines, so they may share them in any mode
+    Coroutine::Engine engine(_mode);
+    Coroutine::Poller poller(engine);
+    engine.start(&ServerImpl::OnAccept, *this, engine, poller);
 
-                delete pc;
-            } else if (pc->_event.events != old_mask) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
-
-                    close(pc->_socket);
-                    pc->OnClose();
-
-                    delete pc;
-                }
-            }
-        }
-    }
-    _logger->warn("Acceptor stopped");
+    close(_server_socket);
+    close(_event_fd);
+    _logger->warn("Network stopped");
 }
 
-void ServerImpl::OnNewConnection(int epoll_descr) {
+// See ServerImpl.h
+void ServerImpl::OnAccept(ServerImpl &self, Coroutine::Engine &engine, Coroutine::Poller &poller) {
+    engine.run(&ServerImpl::OnStop, self, poller);
+
     for (;;) {
         struct sockaddr in_addr;
-        socklen_t in_len;
-
-        // No need to make these sockets non blocking since accept4() takes care of it.
-        in_len = sizeof in_addr;
-        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        socklen_t in_len = sizeof(in_addr);
+        int infd = poller.Accept(self._server_socket, &in_addr, &in_len);
         if (infd == -1) {
-            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-                break; // We have processed all incoming connections.
-            } else {
-                _logger->error("Failed to accept socket");
+            if (errno == ECANCELED) {
                 break;
             }
-        }
 
-        // Print host and service info.
-        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-            getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
-        if (retval == 0) {
-            _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+            // Out of descriptors or memory: listening socket stays ready, so retrying right away would spin
+            // forever and starve everyone else, connections that could free resources included
+            self._logger->error("Failed to accept socket: {}", strerror(errno));
+            if (!poller.Sleep(kAcceptBackoff)) {
+                break;
+            }
+            continue;
         }
 
-        // Register the new FD to be monitored by epoll.
-        Connection *pc = new (std::nothrow) Connection(infd);
-        if (pc == nullptr) {
-            throw std::runtime_error("Failed to allocate connection");
+        if (self._logger->should_log(spdlog::level::debug)) {
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                self._logger->debug("Accepted connection on descriptor {} (host={}, port={})", infd, hbuf, sbuf);
+            }
         }
 
-        // Register connection in worker's epoll
-        pc->Start();
-        if (pc->isAlive()) {
-            if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
-                pc->OnError();
-                delete pc;
-            }
+        if (engine.run(&ServerImpl::OnConnection, self, poller, int(infd)) == nullptr) {
+            self._logger->error("Failed to start coroutine for descriptor {}", infd);
+            close(infd);
         }
     }
+    self._logger->warn("Acceptor stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::OnStop(ServerImpl &self, Coroutine::Poller &poller) {
+    eventfd_t value;
+    if (poller.Read(self._event_fd, &value, sizeof(value)) == -1) {
+        self._logger->error("Failed to wait for stop: {}", strerror(errno));
+    }
+    self._logger->debug("Shutdown coroutines due to stop signal");
+    poller.Shutdown();
+}
+
+// See ServerImpl.h
+void ServerImpl::OnConnection(ServerImpl &self, Coroutine::Poller &poller, int client_socket) {
+    Connection connection(client_socket, self.pStorage, self._logger);
+    connection.Run(poller);
 }
 
 } // namespace STcoroutine
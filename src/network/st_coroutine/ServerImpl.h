@@ -1,9 +1,12 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
 #define AFINA_NETWORK_ST_COROUTINE_SERVER_H
 
+#include <chrono>
 #include <thread>
 #include <vector>
 
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Poller.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -14,16 +17,15 @@ namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
-// Forward declaration, see Worker.h
-class Worker;
-
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Single threaded server where each connection is the coroutine with straight-line code, while IO of all of
+ * them is multiplexed by epoll of the poller
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               Coroutine::Engine::Mode mode = Coroutine::Engine::Mode::kCopyStack);
     ~ServerImpl();
 
     // See Server.h
@@ -36,8 +38,28 @@ public:
     void Join() override;
 
 protected:
+    // Pause of the acceptor after accept failed for the reason other than no clients
+    static const std::chrono::milliseconds kAcceptBackoff;
+
+    /**
+     * Method is running in the IO thread, serves until the stop
+     */
     void OnRun();
-    void OnNewConnection(int);
+
+    /**
+     * Main coroutine: accepts connections and starts a coroutine for each of them
+     */
+    static void OnAccept(ServerImpl &self, Coroutine::Engine &engine, Coroutine::Poller &poller);
+
+    /**
+     * Waits for the stop signal and shuts poller down, which makes all other coroutines to finish
+     */
+    static void OnStop(ServerImpl &self, Coroutine::Poller &poller);
+
+    /**
+     * Coroutine of the connection
+     */
+    static void OnConnection(ServerImpl &self, Coroutine::Poller &poller, int client_socket);
 
 private:
     // logger to use
@@ -51,11 +73,14 @@ private:
     // Socket to accept new connection on, shared between acceptors
     int _server_socket;
 
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup IO thread on stop
     int _event_fd;
 
     // IO thread
     std::thread _work_thread;
+
+    // How coroutines of the engine get their stacks
+    Coroutine::Engine::Mode _mode;
 };
 
 } // namespace STcoroutine
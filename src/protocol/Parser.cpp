@@ -6,6 +6,7 @@
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
@@ -28,7 +29,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                if (name == "set" || name == "add" || name == "append" || name == "prepend" || name == "cas") {
                     state = State::spKey;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
@@ -109,25 +110,19 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::spBytes;
                 // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
-                if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
+                int64_t et = int64_t(exprtime) * 10 + (negative ? -(c - '0') : (c - '0'));
+                if (et > INT32_MAX || et < INT32_MIN) {
+                    throw std::runtime_error("Expire time field overflow");
                 }
-                exprtime = et;
+                exprtime = int32_t(et);
             }
             break;
         }
 
         case State::spBytes: {
-            if (c == '\r') {
+            if (c == ' ' && name == "cas") {
+                state = State::spCas;
+            } else if (c == '\r') {
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
@@ -141,6 +136,20 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::spCas: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t u = (cas * 10) + (c - '0');
+                if (u / 10 != cas) {
+                    // Overflow
+                    throw std::runtime_error("Cas unique field overflow");
+                }
+                cas = u;
+            }
+            break;
+        }
+
         case State::sLF: {
             if (c == '\n') {
                 parse_complete = true;
@@ -174,8 +183,12 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
         return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
     } else if (name == "append") {
         return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
+    } else if (name == "cas") {
+        return std::unique_ptr<Execute::Command>(new Execute::Cas(keys[0], flags, exprtime, cas));
     } else if (name == "get") {
         return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+    } else if (name == "gets") {
+        return std::unique_ptr<Execute::Command>(new Execute::Get(keys, true));
     } else if (name == "stats") {
         return std::unique_ptr<Execute::Command>(new Execute::Stats());
     } else {
@@ -193,6 +206,7 @@ void Parser::Reset() {
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    cas = 0;
 }
 
 } // namespace Protocol
@@ -62,7 +62,7 @@ private:
      * - sp: for PUT commands only
      * - sg: for GET commands only
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, spCas, sgKey };
 
     // Current parser state
     State state;
@@ -88,6 +88,10 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> is a unique 64-bit value of an existing entry, clients should use the value returned
+    // from the "gets" command when issuing "cas" updates
+    uint64_t cas;
+
     bool negative;
     std::string curKey;
     bool parse_complete;
@@ -0,0 +1,265 @@
+#include "Loader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const std::chrono::milliseconds kMinBackoff(100);
+const std::chrono::milliseconds kMaxBackoff(10000);
+
+void SetTimeouts(int fd, std::chrono::milliseconds timeout) {
+    struct timeval tv;
+    tv.tv_sec = timeout.count() / 1000;
+    tv.tv_usec = (timeout.count() % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof(tv));
+}
+
+// Connected descriptor of the unix socket
+int Dial(const std::string &path) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Loader socket path is too long: " + path);
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open loader socket: " + std::string(strerror(errno)));
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(fd);
+        throw std::runtime_error("Failed to connect loader on " + path + ": " + std::string(strerror(errno)));
+    }
+    return fd;
+}
+
+// Starts the command, returns descriptor connected to its stdin/stdout
+int Start(const std::string &command, pid_t &child) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == -1) {
+        throw std::runtime_error("Failed to create loader socket pair: " + std::string(strerror(errno)));
+    }
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(sv[0]);
+        close(sv[1]);
+        throw std::runtime_error("Failed to spawn loader: " + std::string(strerror(errno)));
+    }
+
+    if (pid == 0) {
+        // dup2 clears close-on-exec on the new descriptors
+        dup2(sv[1], STDIN_FILENO);
+        dup2(sv[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+
+    close(sv[1]);
+    child = pid;
+    return sv[0];
+}
+
+} // namespace
+
+// See Loader.h
+Loader::Loader(int fd, pid_t child, std::chrono::milliseconds timeout)
+    : _fd(fd), _child(child), _timeout(timeout), _retry_at(std::chrono::steady_clock::now()), _backoff(kMinBackoff) {
+    SetTimeouts(_fd, _timeout);
+}
+
+// See Loader.h
+Loader::~Loader() {
+    if (_fd != -1) {
+        close(_fd);
+    }
+    Reap();
+}
+
+// See Loader.h
+std::unique_ptr<Loader> Loader::Connect(const std::string &path) {
+    std::unique_ptr<Loader> loader(new Loader(Dial(path)));
+    loader->_path = path;
+    return loader;
+}
+
+// See Loader.h
+std::unique_ptr<Loader> Loader::Spawn(const std::string &command) {
+    pid_t child = -1;
+    int fd = Start(command, child);
+    std::unique_ptr<Loader> loader(new Loader(fd, child));
+    loader->_command = command;
+    return loader;
+}
+
+// See Loader.h
+void Loader::Load(const std::vector<std::string> &keys, std::vector<Item> &out) {
+    if (_fd == -1) {
+        Reconnect();
+    }
+
+    std::string request = "get";
+    for (auto &key : keys) {
+        request += ' ';
+        request += key;
+    }
+    request += "\r\n";
+
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(_fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            Fail("Failed to send request to loader: " + std::string(strerror(errno)));
+        }
+        sent += n;
+    }
+
+    for (;;) {
+        std::string line = ReadLine();
+        if (line == "END") {
+            _backoff = kMinBackoff;
+            return;
+        }
+
+        std::istringstream header(line);
+        std::string tag, key;
+        uint32_t flags;
+        size_t bytes;
+        if (!(header >> tag >> key >> flags >> bytes) || tag != "VALUE") {
+            Fail("Unexpected loader response: " + line);
+        }
+
+        std::string data;
+        ReadBytes(data, bytes + 2);
+        if (data.compare(bytes, 2, "\r\n") != 0) {
+            Fail("Loader data block for " + key + " is not terminated");
+        }
+        data.resize(bytes);
+        out.push_back(Item{std::move(key), std::move(data), flags});
+    }
+}
+
+// See Loader.h
+std::string Loader::ReadLine() {
+    size_t scanned = 0;
+    for (;;) {
+        size_t pos = _buffer.find("\r\n", scanned);
+        if (pos != std::string::npos) {
+            std::string line = _buffer.substr(0, pos);
+            _buffer.erase(0, pos + 2);
+            return line;
+        }
+
+        scanned = _buffer.empty() ? 0 : _buffer.size() - 1;
+        if (!Fill()) {
+            Fail("Loader closed connection");
+        }
+    }
+}
+
+// See Loader.h
+void Loader::ReadBytes(std::string &out, size_t size) {
+    while (_buffer.size() < size) {
+        if (!Fill()) {
+            Fail("Loader closed connection");
+        }
+    }
+    out.assign(_buffer, 0, size);
+    _buffer.erase(0, size);
+}
+
+// See Loader.h
+bool Loader::Fill() {
+    char chunk[4096];
+    for (;;) {
+        ssize_t n = read(_fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            _buffer.append(chunk, n);
+            return true;
+        } else if (n == 0) {
+            return false;
+        } else if (errno != EINTR) {
+            Fail("Failed to read loader response: " + std::string(strerror(errno)));
+        }
+    }
+}
+
+// See Loader.h
+void Loader::Fail(const std::string &message) {
+    // Stream is out of sync from now on, the only way to recover is to start over
+    close(_fd);
+    _fd = -1;
+    _buffer.clear();
+    _retry_at = std::chrono::steady_clock::now() + _backoff;
+    _backoff = std::min(_backoff * 2, kMaxBackoff);
+    throw std::runtime_error(message);
+}
+
+// See Loader.h
+void Loader::Reconnect() {
+    if (_path.empty() && _command.empty()) {
+        throw std::runtime_error("Loader is not connected");
+    }
+    if (std::chrono::steady_clock::now() < _retry_at) {
+        throw std::runtime_error("Loader is not connected, waiting to reconnect");
+    }
+
+    try {
+        if (!_path.empty()) {
+            _fd = Dial(_path);
+        } else {
+            // Previous process got EOF already, it is either gone or stuck
+            Reap();
+            _fd = Start(_command, _child);
+        }
+    } catch (std::runtime_error &) {
+        _retry_at = std::chrono::steady_clock::now() + _backoff;
+        _backoff = std::min(_backoff * 2, kMaxBackoff);
+        throw;
+    }
+    SetTimeouts(_fd, _timeout);
+}
+
+// See Loader.h
+void Loader::Reap() {
+    // Loader is expected to exit once it gets EOF, but don't let it hang around forever
+    if (_child > 0) {
+        bool exited = false;
+        for (int i = 0; i < 100 && !exited; i++) {
+            exited = waitpid(_child, nullptr, WNOHANG) != 0;
+            if (!exited) {
+                usleep(1000);
+            }
+        }
+        if (!exited) {
+            kill(_child, SIGKILL);
+            waitpid(_child, nullptr, 0);
+        }
+        _child = -1;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,112 @@
+#ifndef AFINA_STORAGE_LOADER_H
+#define AFINA_STORAGE_LOADER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Connection to the external loader process
+ * Loader is whatever sits behind the cache: database proxy, another service, e.t.c. Afina talks to it over
+ * the local stream socket using subset of memcached text protocol, so that any memcached-speaking process
+ * could be used as a loader:
+ *
+ * get <key1> <key2> ... <keyN>\r\n
+ *
+ * Loader responds with zero or more items followed by END, keys not found are just skipped:
+ *
+ * VALUE <key> <flags> <bytes>\r\n
+ * <data>\r\n
+ * END\r\n
+ *
+ * Loader obtained by Connect or Spawn survives errors: once the stream is broken, the next Load connects again
+ * (or starts a new process), retries are spaced by the back-off growing from 100ms to 10s while they fail.
+ * Loader wrapping the given descriptor has no way to reconnect, so it is broken for good.
+ *
+ * Not thread safe, expected to be used by a single thread
+ */
+class Loader {
+public:
+    // Item found by the loader
+    struct Item {
+        std::string key;
+        std::string value;
+        uint32_t flags;
+    };
+
+    /**
+     * Wraps already connected stream descriptor. If child pid given, loader process will be terminated
+     * and reaped on destruction
+     */
+    Loader(int fd, pid_t child = -1, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+    ~Loader();
+
+    /**
+     * Connects to loader listening on the given unix socket
+     */
+    static std::unique_ptr<Loader> Connect(const std::string &path);
+
+    /**
+     * Starts loader as "sh -c <command>" having stdin/stdout connected to the socket
+     */
+    static std::unique_ptr<Loader> Spawn(const std::string &command);
+
+    /**
+     * Requests given keys in one round trip and appends found items to out. Throws
+     * std::runtime_error on any IO or protocol error, as well as when loader is broken and it isn't time to
+     * reconnect yet
+     */
+    void Load(const std::vector<std::string> &keys, std::vector<Item> &out);
+
+    inline bool isAlive() const { return _fd != -1; }
+
+private:
+    Loader(const Loader &) = delete;
+    Loader &operator=(const Loader &) = delete;
+
+    // Reads next \r\n terminated line, without terminator
+    std::string ReadLine();
+
+    // Reads exactly size bytes
+    void ReadBytes(std::string &out, size_t size);
+
+    // Reads more data into the buffer, returns false on EOF
+    bool Fill();
+
+    // Releases descriptor and fails with given message
+    void Fail(const std::string &message);
+
+    // Connects again or starts a new process if it is time to, throws std::runtime_error otherwise
+    void Reconnect();
+
+    // Waits for the loader process to exit, kills it if it doesn't
+    void Reap();
+
+    int _fd;
+    pid_t _child;
+    std::chrono::milliseconds _timeout;
+
+    // Where to reconnect to: socket path or command, both empty if loader can't reconnect
+    std::string _path;
+    std::string _command;
+
+    // No reconnects until then, the back-off doubles on every failed attempt
+    std::chrono::steady_clock::time_point _retry_at;
+    std::chrono::milliseconds _backoff;
+
+    // Data received but not consumed yet
+    std::string _buffer;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOADER_H
@@ -0,0 +1,184 @@
+#include "LzCodec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const size_t kMinMatch = 4;
+const size_t kMaxOffset = 65535;
+const size_t kHashLog = 12;
+const size_t kHeaderSize = 4;
+
+inline uint32_t Read32(const char *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Hash(uint32_t v) { return (v * 2654435761U) >> (32 - kHashLog); }
+
+// Writes tail of the length that doesn't fit into the token nibble
+inline void PutLength(std::string &out, size_t len) {
+    for (; len >= 255; len -= 255) {
+        out.push_back(char(255));
+    }
+    out.push_back(char(len));
+}
+
+inline void PutSequence(std::string &out, const char *literals, size_t lit_len, size_t offset, size_t match_len) {
+    size_t ml = match_len == 0 ? 0 : match_len - kMinMatch;
+    uint8_t token = uint8_t(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    out.push_back(char(token));
+    if (lit_len >= 15) {
+        PutLength(out, lit_len - 15);
+    }
+    out.append(literals, lit_len);
+    if (match_len == 0) {
+        return;
+    }
+
+    out.push_back(char(offset & 0xff));
+    out.push_back(char(offset >> 8));
+    if (ml >= 15) {
+        PutLength(out, ml - 15);
+    }
+}
+
+// Reads tail of the length encoded by PutLength
+inline size_t GetLength(const char *in, size_t size, size_t &pos) {
+    size_t len = 0;
+    for (;;) {
+        if (pos >= size) {
+            throw std::runtime_error("Compressed block is truncated");
+        }
+        uint8_t b = uint8_t(in[pos++]);
+        len += b;
+        if (b != 255) {
+            return len;
+        }
+    }
+}
+
+} // namespace
+
+// See LzCodec.h
+bool LzCodec::Compress(const std::string &in, std::string &out) {
+    const size_t n = in.size();
+    if (n < kMinMatch || n > UINT32_MAX) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(n);
+    for (size_t i = 0; i < kHeaderSize; i++) {
+        out.push_back(char((n >> (8 * i)) & 0xff));
+    }
+
+    // Positions are stored shifted by one, so that zero means empty slot
+    std::vector<uint32_t> table(1 << kHashLog, 0);
+    const char *src = in.data();
+    size_t anchor = 0;
+    size_t ip = 0;
+    while (ip + kMinMatch <= n) {
+        uint32_t seq = Read32(src + ip);
+        uint32_t &slot = table[Hash(seq)];
+        size_t ref = slot;
+        slot = uint32_t(ip + 1);
+
+        if (ref == 0 || ip + 1 - ref > kMaxOffset || Read32(src + ref - 1) != seq) {
+            // Skip faster over data that doesn't compress
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        ref--;
+
+        size_t len = kMinMatch;
+        while (ip + len < n && src[ref + len] == src[ip + len]) {
+            len++;
+        }
+
+        PutSequence(out, src + anchor, ip - anchor, ip - ref, len);
+        ip += len;
+        anchor = ip;
+        if (out.size() >= n) {
+            return false;
+        }
+    }
+
+    PutSequence(out, src + anchor, n - anchor, 0, 0);
+    return out.size() < n;
+}
+
+// See LzCodec.h
+void LzCodec::Decompress(const char *in, size_t size, std::string &out) {
+    if (size < kHeaderSize) {
+        throw std::runtime_error("Compressed block is truncated");
+    }
+
+    size_t raw = 0;
+    for (size_t i = 0; i < kHeaderSize; i++) {
+        raw |= size_t(uint8_t(in[i])) << (8 * i);
+    }
+
+    out.resize(raw);
+    size_t op = 0;
+    size_t pos = kHeaderSize;
+    bool terminated = false;
+    while (pos < size) {
+        uint8_t token = uint8_t(in[pos++]);
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            lit_len += GetLength(in, size, pos);
+        }
+        if (lit_len > size - pos || lit_len > raw - op) {
+            throw std::runtime_error("Compressed block literals are out of bounds");
+        }
+        std::memcpy(&out[op], in + pos, lit_len);
+        pos += lit_len;
+        op += lit_len;
+
+        // The last sequence has no match
+        if (pos == size) {
+            terminated = true;
+            break;
+        }
+
+        if (size - pos < 2) {
+            throw std::runtime_error("Compressed block is truncated");
+        }
+        size_t offset = size_t(uint8_t(in[pos])) | (size_t(uint8_t(in[pos + 1])) << 8);
+        pos += 2;
+
+        size_t match_len = token & 0x0f;
+        if (match_len == 15) {
+            match_len += GetLength(in, size, pos);
+        }
+        match_len += kMinMatch;
+
+        if (offset == 0 || offset > op || match_len > raw - op) {
+            throw std::runtime_error("Compressed block match is out of bounds");
+        }
+
+        // Source and destination overlap for repeating patterns, so copy byte by byte
+        const char *match = &out[op - offset];
+        char *dst = &out[op];
+        for (size_t i = 0; i < match_len; i++) {
+            dst[i] = match[i];
+        }
+        op += match_len;
+    }
+
+    if (!terminated || op != raw) {
+        throw std::runtime_error("Compressed block size mismatch");
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
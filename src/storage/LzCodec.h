@@ -0,0 +1,42 @@
+#ifndef AFINA_STORAGE_LZ_CODEC_H
+#define AFINA_STORAGE_LZ_CODEC_H
+
+#include <cstddef>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Fast LZ77 codec
+ * Byte oriented LZ77 in the spirit of LZ4: greedy matching through a small hash table of 4-byte
+ * sequences, no entropy stage. Compression ratio is modest, but both directions run at memory speed,
+ * which is what a cache serving text payloads (JSON, HTML) needs.
+ *
+ * Block layout is raw size (4 bytes, little endian) followed by sequences:
+ * token | [literal length bytes] | literals | offset (2 bytes) | [match length bytes]
+ * High nibble of the token is the literal length, low nibble is the match length minus 4, value 15
+ * in either of them means that length continues in the following bytes, each one adds up to 255.
+ * The last sequence has literals only.
+ */
+class LzCodec {
+public:
+    /**
+     * Compresses input into out
+     *
+     * @return false if data doesn't compress, out is unspecified then
+     */
+    static bool Compress(const std::string &in, std::string &out);
+
+    /**
+     * Restores data compressed by the Compress, throws std::runtime_error if input is corrupted
+     */
+    static void Decompress(const char *in, size_t size, std::string &out);
+
+    static void Decompress(const std::string &in, std::string &out) { Decompress(in.data(), in.size(), out); }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LZ_CODEC_H
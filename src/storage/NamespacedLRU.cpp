@@ -0,0 +1,209 @@
+#include "NamespacedLRU.h"
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+// See NamespacedLRU.h
+NamespacedLRU::NamespacedLRU(size_t max_size, const std::map<std::string, size_t> &quotas, char delimiter)
+    : _max_size(max_size), _delimiter(delimiter) {
+    size_t reserved = 0;
+    for (auto &q : quotas) {
+        if (q.first.empty() || q.first.find(delimiter) != std::string::npos) {
+            throw std::runtime_error("Invalid namespace name: '" + q.first + "'");
+        }
+
+        reserved += q.second;
+        _index[q.first] = _tenants.size();
+        _tenants.emplace_back(new tenant(max_size, q.second));
+    }
+
+    if (reserved > max_size) {
+        throw std::runtime_error("Namespace quotas exceed total storage size");
+    }
+
+    // Default namespace
+    _tenants.emplace_back(new tenant(max_size, max_size - reserved));
+}
+
+bool NamespacedLRU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0, 0); }
+
+bool NamespacedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, value, 0, 0);
+}
+
+bool NamespacedLRU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0, 0); }
+
+bool NamespacedLRU::Delete(const std::string &key) {
+    tenant &t = TenantFor(key);
+    std::lock_guard<std::mutex> lock(t.mutex);
+    bool result = t.storage.Delete(key);
+    t.used = t.storage.CurrentSize();
+    return result;
+}
+
+bool NamespacedLRU::Get(const std::string &key, std::string &value) {
+    tenant &t = TenantFor(key);
+    std::lock_guard<std::mutex> lock(t.mutex);
+    bool result = t.storage.Get(key, value);
+    t.used = t.storage.CurrentSize();
+    return result;
+}
+
+bool NamespacedLRU::Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    tenant &t = TenantFor(key);
+    bool result;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        result = t.storage.Put(key, value, flags, expire);
+        t.used = t.storage.CurrentSize();
+    }
+    Rebalance();
+    return result;
+}
+
+bool NamespacedLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    tenant &t = TenantFor(key);
+    bool result;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        result = t.storage.PutIfAbsent(key, value, flags, expire);
+        t.used = t.storage.CurrentSize();
+    }
+    Rebalance();
+    return result;
+}
+
+bool NamespacedLRU::Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    tenant &t = TenantFor(key);
+    bool result;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        result = t.storage.Set(key, value, flags, expire);
+        t.used = t.storage.CurrentSize();
+    }
+    Rebalance();
+    return result;
+}
+
+bool NamespacedLRU::Get(const std::string &key, std::string &value, ItemHeader &header) {
+    tenant &t = TenantFor(key);
+    std::lock_guard<std::mutex> lock(t.mutex);
+    bool result = t.storage.Get(key, value, header);
+    // Expired items are dropped on lookup
+    t.used = t.storage.CurrentSize();
+    return result;
+}
+
+CasResult NamespacedLRU::CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                        int32_t expire, uint64_t cas) {
+    tenant &t = TenantFor(key);
+    CasResult result;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        result = t.storage.CompareAndSwap(key, value, flags, expire, cas);
+        t.used = t.storage.CurrentSize();
+    }
+    Rebalance();
+    return result;
+}
+
+bool NamespacedLRU::Append(const std::string &key, const std::string &value) {
+    tenant &t = TenantFor(key);
+    bool result;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        result = t.storage.Append(key, value);
+        t.used = t.storage.CurrentSize();
+    }
+    Rebalance();
+    return result;
+}
+
+// See NamespacedLRU.h
+void NamespacedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::pair<std::string, std::string>> total;
+    for (auto &t : _tenants) {
+        std::vector<std::pair<std::string, std::string>> part;
+        {
+            std::lock_guard<std::mutex> lock(t->mutex);
+            t->storage.Stats(part);
+        }
+        SimpleLRU::MergeStats(total, part);
+    }
+
+    // Every namespace may grow up to the whole budget, but all of them together don't
+    for (auto &stat : total) {
+        if (stat.first == "limit_maxbytes") {
+            stat.second = std::to_string(_max_size);
+        }
+    }
+    stats.insert(stats.end(), total.begin(), total.end());
+
+    for (auto &ns : _index) {
+        const tenant &t = *_tenants[ns.second];
+        stats.emplace_back("namespace:" + ns.first + ":bytes", std::to_string(t.used));
+        stats.emplace_back("namespace:" + ns.first + ":quota", std::to_string(t.quota));
+    }
+}
+
+// See NamespacedLRU.h
+size_t NamespacedLRU::Usage(const std::string &name) const {
+    auto it = _index.find(name);
+    if (it == _index.end()) {
+        return _tenants.back()->used;
+    }
+    return _tenants[it->second]->used;
+}
+
+// See NamespacedLRU.h
+NamespacedLRU::tenant &NamespacedLRU::TenantFor(const std::string &key) {
+    size_t pos = key.find(_delimiter);
+    if (pos != std::string::npos) {
+        auto it = _index.find(key.substr(0, pos));
+        if (it != _index.end()) {
+            return *_tenants[it->second];
+        }
+    }
+    return *_tenants.back();
+}
+
+// See NamespacedLRU.h
+void NamespacedLRU::Rebalance() {
+    size_t total = 0;
+    for (auto &t : _tenants) {
+        total += t->used;
+    }
+    if (total <= _max_size) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> evict_lock(_evict_mutex);
+    for (;;) {
+        // Victim is the namespace that borrowed the most from the others
+        tenant *victim = nullptr;
+        long long worst = 0;
+        total = 0;
+        for (auto &t : _tenants) {
+            size_t used = t->used;
+            long long over = (long long)used - (long long)t->quota;
+            total += used;
+            if (used > 0 && (victim == nullptr || over > worst)) {
+                victim = t.get();
+                worst = over;
+            }
+        }
+
+        if (total <= _max_size || victim == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        victim->storage.EvictOne();
+        victim->used = victim->storage.CurrentSize();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
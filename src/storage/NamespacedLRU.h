@@ -0,0 +1,112 @@
+#ifndef AFINA_STORAGE_NAMESPACED_LRU_H
+#define AFINA_STORAGE_NAMESPACED_LRU_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Multi-tenant LRU
+ * Keys are split into namespaces by prefix: key "<namespace><delimiter><rest>" belongs to the namespace if
+ * it is configured, everything else goes to the default namespace. Each namespace has its own LRU list,
+ * lock and guaranteed byte quota, default namespace gets whatever is left from the total budget.
+ *
+ * Namespace could grow over its quota while there is free space. Once total budget is exhausted eviction
+ * always starts from the namespace that is the furthest over its quota, so tenant staying within its quota
+ * never loses data because of somebody else's writes
+ */
+class NamespacedLRU : public Afina::Storage {
+public:
+    /**
+     * @param max_size total number of bytes for all namespaces
+     * @param quotas guaranteed number of bytes for each namespace, sum must not exceed max_size
+     * @param delimiter separates namespace from the rest of the key
+     */
+    NamespacedLRU(size_t max_size, const std::map<std::string, size_t> &quotas, char delimiter = ':');
+    ~NamespacedLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Number of bytes used by the given namespace, empty name means default namespace
+     */
+    size_t Usage(const std::string &name) const;
+
+private:
+    // Single namespace
+    struct tenant {
+        tenant(size_t max_size, size_t quota) : storage(max_size), quota(quota), used(0) {}
+
+        std::mutex mutex;
+        SimpleLRU storage;
+        const size_t quota;
+
+        // Mirror of storage.CurrentSize() readable without lock
+        std::atomic<size_t> used;
+    };
+
+    // Finds namespace the key belongs to
+    tenant &TenantFor(const std::string &key);
+
+    // Evicts from the namespaces over quota until total usage fits into budget, must be called without
+    // any tenant lock held
+    void Rebalance();
+
+    const size_t _max_size;
+    const char _delimiter;
+
+    // Namespace name to index in _tenants, default namespace is the last one
+    std::map<std::string, size_t> _index;
+    std::vector<std::unique_ptr<tenant>> _tenants;
+
+    // Serializes eviction across namespaces, always taken before tenant lock
+    std::mutex _evict_mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_NAMESPACED_LRU_H
@@ -0,0 +1,198 @@
+#include "ReadThroughStorage.h"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+// See ReadThroughStorage.h
+ReadThroughStorage::ReadThroughStorage(std::shared_ptr<Afina::Storage> backend, std::unique_ptr<Loader> loader,
+                                       size_t max_batch, duration batch_delay, duration load_timeout)
+    : _backend(backend), _loader(std::move(loader)), _max_batch(max_batch), _batch_delay(batch_delay),
+      _load_timeout(load_timeout), _running(false) {
+    if (_max_batch == 0) {
+        throw std::runtime_error("Loader batch size must be positive");
+    }
+}
+
+// See ReadThroughStorage.h
+ReadThroughStorage::~ReadThroughStorage() { Stop(); }
+
+// See ReadThroughStorage.h
+void ReadThroughStorage::Start() {
+    _backend->Start();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+        _running = true;
+        _thread = std::thread(&ReadThroughStorage::OnRun, this);
+    }
+}
+
+// See ReadThroughStorage.h
+void ReadThroughStorage::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+        _has_work.notify_all();
+    }
+
+    _thread.join();
+    _backend->Stop();
+}
+
+bool ReadThroughStorage::Put(const std::string &key, const std::string &value) { return _backend->Put(key, value); }
+
+bool ReadThroughStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return _backend->PutIfAbsent(key, value);
+}
+
+bool ReadThroughStorage::Set(const std::string &key, const std::string &value) { return _backend->Set(key, value); }
+
+bool ReadThroughStorage::Delete(const std::string &key) { return _backend->Delete(key); }
+
+bool ReadThroughStorage::Get(const std::string &key, std::string &value) {
+    ItemHeader header;
+    return Get(key, value, header);
+}
+
+bool ReadThroughStorage::Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    return _backend->Put(key, value, flags, expire);
+}
+
+bool ReadThroughStorage::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags,
+                                     int32_t expire) {
+    return _backend->PutIfAbsent(key, value, flags, expire);
+}
+
+bool ReadThroughStorage::Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    return _backend->Set(key, value, flags, expire);
+}
+
+CasResult ReadThroughStorage::CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                             int32_t expire, uint64_t cas) {
+    return _backend->CompareAndSwap(key, value, flags, expire, cas);
+}
+
+bool ReadThroughStorage::Append(const std::string &key, const std::string &value) {
+    if (_backend->Append(key, value)) {
+        return true;
+    }
+
+    // Missing item is loaded the same way Get does
+    std::string loaded;
+    return Get(key, loaded) && _backend->Append(key, value);
+}
+
+bool ReadThroughStorage::Get(const std::string &key, std::string &value, ItemHeader &header) {
+    if (_backend->Get(key, value, header)) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        return false;
+    }
+
+    // Join load in progress or schedule a new one
+    std::shared_ptr<pending_load> &slot = _pending[key];
+    if (!slot) {
+        slot = std::make_shared<pending_load>();
+        _queue.push_back(key);
+        _has_work.notify_one();
+    }
+
+    std::shared_ptr<pending_load> pl = slot;
+    if (!pl->loaded.wait_for(lock, _load_timeout, [&pl] { return pl->done; }) || !pl->found) {
+        return false;
+    }
+    lock.unlock();
+
+    // Client could have updated key while load was in progress, prefer whatever is in the backend
+    if (!_backend->Get(key, value, header)) {
+        value = pl->value;
+        header = ItemHeader();
+        header.flags = pl->flags;
+    }
+    return true;
+}
+
+// See ReadThroughStorage.h
+void ReadThroughStorage::OnRun() {
+    std::vector<std::string> batch;
+    std::vector<Loader::Item> loaded;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        if (_queue.empty()) {
+            _has_work.wait(lock);
+            continue;
+        }
+
+        // Give concurrent misses a chance to join the batch
+        if (_queue.size() < _max_batch) {
+            _has_work.wait_for(lock, _batch_delay, [this] { return !_running || _queue.size() >= _max_batch; });
+            if (!_running) {
+                break;
+            }
+        }
+
+        batch.clear();
+        while (!_queue.empty() && batch.size() < _max_batch) {
+            batch.push_back(std::move(_queue.front()));
+            _queue.pop_front();
+        }
+        lock.unlock();
+
+        loaded.clear();
+        try {
+            _loader->Load(batch, loaded);
+        } catch (std::runtime_error &) {
+            // Broken loader turns read-through into plain cache, readers just get miss
+            loaded.clear();
+        }
+
+        for (auto &item : loaded) {
+            _backend->PutIfAbsent(item.key, item.value, item.flags, 0);
+        }
+
+        lock.lock();
+        for (auto &item : loaded) {
+            Complete(item.key, true, std::move(item.value), item.flags);
+        }
+        for (auto &key : batch) {
+            Complete(key, false, std::string(), 0);
+        }
+    }
+
+    // Nobody is going to load the rest
+    for (auto &key : _queue) {
+        Complete(key, false, std::string(), 0);
+    }
+    _queue.clear();
+}
+
+// See ReadThroughStorage.h
+void ReadThroughStorage::Complete(const std::string &key, bool found, std::string value, uint32_t flags) {
+    auto it = _pending.find(key);
+    if (it == _pending.end()) {
+        return;
+    }
+
+    std::shared_ptr<pending_load> pl = it->second;
+    _pending.erase(it);
+
+    pl->done = true;
+    pl->found = found;
+    pl->value = std::move(value);
+    pl->flags = flags;
+    pl->loaded.notify_all();
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,124 @@
+#ifndef AFINA_STORAGE_READ_THROUGH_STORAGE_H
+#define AFINA_STORAGE_READ_THROUGH_STORAGE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <afina/Storage.h>
+
+#include "Loader.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Read-through decorator
+ * Wraps any storage and backfills misses from the external loader. Loads are asynchronous: a miss just
+ * registers key in the pending table and waits for the background thread, that one collects all pending
+ * keys for a short delay and sends them to the loader in one batch. Concurrent misses on the same key
+ * share single pending entry, so each key gets loaded once.
+ *
+ * Loaded values are inserted by PutIfAbsent with the flags given by the loader, so write issued by a client
+ * during the load always wins
+ */
+class ReadThroughStorage : public Afina::Storage {
+public:
+    using duration = std::chrono::milliseconds;
+
+    ReadThroughStorage(std::shared_ptr<Afina::Storage> backend, std::unique_ptr<Loader> loader,
+                       size_t max_batch = 64, duration batch_delay = duration(1),
+                       duration load_timeout = duration(100));
+    ~ReadThroughStorage();
+
+    // Starts backend and thread talking to the loader
+    void Start() override;
+
+    // Stops loader thread, pending readers get miss
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, on backend miss waits up to load_timeout for the loader
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface, same as Get above
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface, item missing in the backend is loaded first
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface, reports backend statistics
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override { _backend->Stats(stats); }
+
+private:
+    // Load of the single key requested by one or more readers
+    struct pending_load {
+        bool done = false;
+        bool found = false;
+        std::string value;
+        uint32_t flags = 0;
+        std::condition_variable loaded;
+    };
+
+    // Method executing by background thread
+    void OnRun();
+
+    // Wraps up load of the given key, expects _mutex to be locked
+    void Complete(const std::string &key, bool found, std::string value, uint32_t flags);
+
+    std::shared_ptr<Afina::Storage> _backend;
+    std::unique_ptr<Loader> _loader;
+
+    const size_t _max_batch;
+    const duration _batch_delay;
+    const duration _load_timeout;
+
+    // Protects everything below
+    std::mutex _mutex;
+
+    // Wakes up loader thread
+    std::condition_variable _has_work;
+
+    // Keys waiting for the loader in order of arrival, each one has entry in _pending
+    std::deque<std::string> _queue;
+
+    // Loads in progress
+    std::unordered_map<std::string, std::shared_ptr<pending_load>> _pending;
+
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_READ_THROUGH_STORAGE_H
@@ -1,5 +1,17 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <new>
+
+#include <afina/allocator/Error.h>
+
+#include "LzCodec.h"
+
 namespace Afina {
 namespace Backend {
 
@@ -34,91 +46,180 @@ void SimpleLRU::MoveNodeToHead(lru_node &node) {
     }
 }
 
+void SimpleLRU::node_deleter::operator()(lru_node *node) const {
+    Free(node->value, node->value_capacity);
+    node->~lru_node();
+    Free(node, sizeof(lru_node));
+}
+
+void SimpleLRU::node_deleter::Free(void *ptr, std::size_t size) const {
+    if (shared != nullptr) {
+        shared->Free(ptr, size);
+    } else {
+        Allocator::Small::Free(ptr, size);
+    }
+}
+
 void SimpleLRU::DeleteElementFromTail() {
-    std::size_t deltaSize = _lru_tail->key.size() + _lru_tail->value.size();
+    if (_on_drop) {
+        std::string value;
+        Unpack(*_lru_tail, value);
+        _on_drop(_lru_tail->key, value, _lru_tail->header);
+    }
+
+    std::size_t deltaSize = _lru_tail->key.size() + _lru_tail->value_size;
     _lru_index.erase(_lru_tail->key);
     if (_lru_head.get() != _lru_tail) {
         _lru_tail = _lru_tail->prev;
         _lru_tail->next.reset(nullptr);
     } else { // trivial case: 1 element in LRU
         _lru_head.reset(nullptr);
+        _lru_tail = nullptr;
     }
     _current_size -= (deltaSize);
 }
 
 void SimpleLRU::MakeKeyValue(const std::string &key,
-                             const std::string &value) {
+                             const std::string &value,
+                             bool compressed,
+                             const ItemHeader &header) {
     while (_current_size + key.size() + value.size() > _max_size) {
         DeleteElementFromTail();
     }
-    auto *node = new lru_node{key, value, nullptr, nullptr};
-    MakeNewHead(*node);
+
+    const node_deleter &deleter = _lru_head.get_deleter();
+    void *memory = Alloc(sizeof(lru_node));
+    lru_node *node;
+    try {
+        node = new (memory) lru_node{key, nullptr, 0, 0, header, compressed, nullptr,
+                                     std::unique_ptr<lru_node, node_deleter>(nullptr, deleter)};
+    } catch (...) {
+        deleter.Free(memory, sizeof(lru_node));
+        throw;
+    }
+
+    // Node is destroyed properly from now on
+    std::unique_ptr<lru_node, node_deleter> guard(node, deleter);
+    node->value = CopyValue(value);
+    node->value_size = value.size();
+    node->value_capacity = Allocator::Small::BlockSize(value.size());
+
+    MakeNewHead(*guard.release());
     _lru_index.insert({std::reference_wrapper<const std::string>(node->key),
         std::reference_wrapper<lru_node>(*node)});
     _current_size += key.size() + value.size();
 }
 
 void SimpleLRU::ChangeKeyValue(lru_node &node,
-                               const std::string &value) {
+                               const std::string &value,
+                               bool compressed,
+                               const ItemHeader &header) {
     MoveNodeToHead(node);
-    if (value.size() > node.value.size()) {
-        while (_current_size + value.size() - node.value.size() > _max_size) {
+    char *copy = CopyValue(value, &node);
+    if (value.size() > node.value_size) {
+        while (_current_size + value.size() - node.value_size > _max_size) {
             DeleteElementFromTail();
         }
-        _current_size += (value.size() - node.value.size());
+        _current_size += (value.size() - node.value_size);
     } else {
-        _current_size -= (node.value.size() - value.size());
+        _current_size -= (node.value_size - value.size());
     }
-    node.value = value;
+
+    _lru_head.get_deleter().Free(node.value, node.value_capacity);
+    node.value = copy;
+    node.value_size = value.size();
+    node.value_capacity = Allocator::Small::BlockSize(value.size());
+    node.compressed = compressed;
+    node.header = header;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
-        return false;
+void *SimpleLRU::Alloc(std::size_t size, const lru_node *keep) {
+    if (_shared_allocator) {
+        return _shared_allocator->Alloc(size);
     }
-    auto node = _lru_index.find(key);
-    if (node != _lru_index.end()) { // key exist
-        ChangeKeyValue((node->second).get(), value);
-    } else { // key doesn't exist
-        MakeKeyValue(key, value);
+
+    // Out of slabs: make room at the expense of the least recently used items, the class is remembered
+    // so that MoveSlab could give it more memory
+    void *ptr;
+    while ((ptr = _allocator->TryAlloc(size)) == nullptr && size <= Allocator::Small::kMaxObject &&
+           _lru_tail != nullptr && _lru_tail != keep) {
+        _slab_evictions[Allocator::Small::ClassOf(size)]++;
+        DeleteElementFromTail();
     }
-    return true;
+
+    if (ptr == nullptr) {
+        throw Allocator::AllocError(Allocator::AllocErrorType::NoMemory,
+                                    "No memory for the block of " + std::to_string(size) + " bytes");
+    }
+    return ptr;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
+char *SimpleLRU::CopyValue(const std::string &value, const lru_node *keep) {
+    char *copy = static_cast<char *>(Alloc(value.size(), keep));
+    std::memcpy(copy, value.data(), value.size());
+    return copy;
+}
+
+bool SimpleLRU::RelocateValue(lru_node &node) {
+    char *copy = static_cast<char *>(_allocator->TryAlloc(node.value_capacity));
+    if (copy == nullptr) {
         return false;
     }
-    if (_lru_index.find(key) == _lru_index.end()) {
-        MakeKeyValue(key, value);
-        return true;
-    }
-    return false;
+    std::memcpy(copy, node.value, node.value_size);
+    Allocator::Small::Free(node.value, node.value_capacity);
+    node.value = copy;
+    return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    if (key.size() + value.size() > _max_size) {
+bool SimpleLRU::RelocateNode(lru_node &node) {
+    void *memory = _allocator->TryAlloc(sizeof(lru_node));
+    if (memory == nullptr) {
         return false;
     }
-    auto node = _lru_index.find(key);
-    if (node != _lru_index.end()) {
-        ChangeKeyValue((node->second).get(), value);
-        return true;
+
+    // Index refers to the key inside of the node
+    _lru_index.erase(node.key);
+    lru_node *copy = new (memory) lru_node{node.key,           node.value,      node.value_size,
+                                           node.value_capacity, node.header,     node.compressed,
+                                           node.prev,           std::move(node.next)};
+    node.value = nullptr;
+    node.value_size = 0;
+    node.value_capacity = 0;
+
+    if (copy->next) {
+        copy->next->prev = copy;
+    } else {
+        _lru_tail = copy;
     }
-    return false;
+
+    // Old node is released from its owner by hand, it has nothing else to free
+    std::unique_ptr<lru_node, node_deleter> &owner = copy->prev != nullptr ? copy->prev->next : _lru_head;
+    owner.release();
+    owner.reset(copy);
+    _lru_head.get_deleter()(&node);
+
+    _lru_index.insert({std::reference_wrapper<const std::string>(copy->key),
+        std::reference_wrapper<lru_node>(*copy)});
+    return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) {
-    auto temp = _lru_index.find(key);
-    if (temp == _lru_index.end()) {
-        return false;
+const std::string &SimpleLRU::Pack(const std::string &value, std::string &buffer, bool &compressed) const {
+    compressed = _compress_threshold != 0 && value.size() >= _compress_threshold && LzCodec::Compress(value, buffer);
+    return compressed ? buffer : value;
+}
+
+void SimpleLRU::Unpack(const lru_node &node, std::string &value) const {
+    if (node.compressed) {
+        LzCodec::Decompress(node.value, node.value_size, value);
+    } else {
+        value.assign(node.value, node.value_size);
     }
-    lru_node *nodePointer = &(temp->second.get());
-    _lru_index.erase(temp);
+}
+
+void SimpleLRU::DeleteNode(lru_node &node) {
+    lru_node *nodePointer = &node;
+    _lru_index.erase(nodePointer->key);
+    _current_size -= nodePointer->key.size() + nodePointer->value_size;
     if (nodePointer != _lru_head.get()) {
         if (nodePointer->next) { // default case
             nodePointer->next->prev = nodePointer->prev;
@@ -136,19 +237,411 @@ bool SimpleLRU::Delete(const std::string &key) {
             _lru_tail = nullptr;
         }
     }
+}
+
+SimpleLRU::lru_node *SimpleLRU::FindNode(const std::string &key) {
+    auto node = _lru_index.find(key);
+    if (node == _lru_index.end()) {
+        return nullptr;
+    }
+
+    // Expired items are removed lazily, once somebody touches them
+    lru_node &found = node->second.get();
+    if (found.header.expire != 0 && found.header.expire <= std::time(nullptr)) {
+        if (_on_drop) {
+            std::string value;
+            Unpack(found, value);
+            _on_drop(found.key, value, found.header);
+        }
+        DeleteNode(found);
+        return nullptr;
+    }
+    return &found;
+}
+
+ItemHeader SimpleLRU::MakeHeader(uint32_t flags, int32_t expire) {
+    ItemHeader header;
+    header.cas = _next_cas++;
+    header.flags = flags;
+
+    // memcached treats values up to 30 days as relative time, anything bigger is a unix timestamp
+    const int32_t max_relative = 60 * 60 * 24 * 30;
+    if (expire < 0) {
+        header.expire = 1;
+    } else if (expire == 0) {
+        header.expire = 0;
+    } else if (expire <= max_relative) {
+        header.expire = static_cast<uint32_t>(std::time(nullptr) + expire);
+    } else {
+        header.expire = static_cast<uint32_t>(expire);
+    }
+    return header;
+}
+
+// See MapBasedGlobalLockImpl.h
+// Calls below are not virtual on purpose: ThreadSafeSimpleLRU guards both overloads with the same lock
+bool SimpleLRU::Put(const std::string &key, const std::string &value) { return SimpleLRU::Put(key, value, 0, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return SimpleLRU::PutIfAbsent(key, value, 0, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value) { return SimpleLRU::Set(key, value, 0, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Delete(const std::string &key) {
+    lru_node *node = FindNode(key);
+    if (node == nullptr) {
+        return false;
+    }
+    DeleteNode(*node);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
-    auto node = _lru_index.find(key);
-    if (node != _lru_index.end()) {
-        value = node->second.get().value;
-        MoveNodeToHead(node->second.get());
+    ItemHeader header;
+    return SimpleLRU::Get(key, value, header);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::EvictOne() {
+    if (!_lru_head) {
+        return false;
+    }
+    DeleteElementFromTail();
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::MoveSlab() {
+    uint64_t moved = _slabs_moved;
+    while (MoveSlabStep(SIZE_MAX)) {
+    }
+    return _slabs_moved != moved;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::MoveSlabStep(std::size_t budget) {
+    if (!_allocator) {
+        return false;
+    }
+    size_t classes = _allocator->Classes();
+    if (_move_class == classes && !StartMove()) {
+        return false;
+    }
+
+    // Slab goes back to the cache as soon as the last object leaves it. Walk goes by the index, not LRU
+    // list, so that the next step could find where to continue whatever happened in between
+    Allocator::Mempool &pool = _allocator->Pool(_move_class);
+    size_t spent = 0;
+    for (auto it = _lru_index.lower_bound(_move_cursor); it != _lru_index.end() && pool.Draining();) {
+        lru_node &node = it->second.get();
+        bool in_node = pool.Draining(&node);
+        bool in_value = pool.Draining(node.value);
+        size_t cost = sizeof(lru_node) + (in_value ? node.value_size : 0);
+        if (spent != 0 && spent + cost > budget) {
+            _move_cursor = it->first.get();
+            return true;
+        }
+        spent += cost;
+
+        auto next = std::next(it);
+        if (in_node || in_value) {
+            if (!_move_relocate || (in_value && !RelocateValue(node)) || (in_node && !RelocateNode(node))) {
+                DeleteNode(node);
+            }
+        }
+        it = next;
+    }
+
+    // Nothing is expected to be left, but don't leave the slab stuck if it happens
+    if (pool.Draining()) {
+        pool.Undrain();
+    } else {
+        _slabs_moved++;
+    }
+    _move_class = classes;
+    _move_cursor.clear();
+    return false;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::StartMove() {
+    // Receiver is the class that suffered the most since the previous call
+    size_t classes = _allocator->Classes();
+    std::vector<uint64_t> pressure(classes);
+    size_t hungry = classes;
+    for (size_t cls = 0; cls < classes; cls++) {
+        pressure[cls] = _slab_evictions[cls] - _slab_evictions_seen[cls];
+        if (pressure[cls] > 0 && (hungry == classes || pressure[cls] > pressure[hungry])) {
+            hungry = cls;
+        }
+    }
+    _slab_evictions_seen = _slab_evictions;
+    if (hungry == classes) {
+        return false;
+    }
+
+    // Items of the class having a slab worth of free room fit into its other slabs, so it gives the page
+    // away for free, the more free pages the better. Otherwise the coldest class owning the most pages pays
+    // with its items
+    size_t donor = classes;
+    bool relocate = false;
+    size_t room = 0;
+    for (size_t cls = 0; cls < classes; cls++) {
+        const Allocator::Mempool &pool = _allocator->Pool(cls);
+        size_t free = (pool.Slabs() * pool.Capacity() - pool.Used()) / pool.Capacity();
+        if (cls != hungry && free > room) {
+            donor = cls;
+            room = free;
+            relocate = true;
+        }
+    }
+    size_t victim = classes;
+    for (size_t cls = 0; donor == classes && cls < classes; cls++) {
+        const Allocator::Mempool &pool = _allocator->Pool(cls);
+        if (cls == hungry || pool.Slabs() == 0 || pressure[cls] >= pressure[hungry]) {
+            continue;
+        }
+        if (victim == classes || pressure[cls] < pressure[victim] ||
+            (pressure[cls] == pressure[victim] && pool.Slabs() > _allocator->Pool(victim).Slabs())) {
+            victim = cls;
+        }
+    }
+    if (donor == classes) {
+        donor = victim;
+    }
+    if (donor == classes) {
+        return false;
+    }
+
+    // Spare slab is given away right away
+    Allocator::Mempool &pool = _allocator->Pool(donor);
+    if (pool.ReleaseSpare()) {
+        _slabs_moved++;
+        return false;
+    }
+    if (!pool.Drain()) {
+        return false;
+    }
+
+    _move_class = donor;
+    _move_relocate = relocate;
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_lru_index.size()));
+    stats.emplace_back("bytes", std::to_string(_current_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("index_malloced", std::to_string(_index_allocator->Mapped()));
+    if (!_allocator) {
+        return;
+    }
+
+    // Free chunks tell fragmentation from lack of memory: evictions with plenty of free chunks mean that
+    // slabs are in the wrong classes, without them the cache is just full
+    size_t mapped = _allocator->Mapped();
+    size_t used = 0;
+    size_t free = 0;
+    for (size_t cls = 0; cls < _allocator->Classes(); cls++) {
+        const Allocator::Mempool &pool = _allocator->Pool(cls);
+        used += pool.Used() * pool.ObjectSize();
+        free += (pool.Slabs() * pool.Capacity() - pool.Used()) * pool.ObjectSize();
+    }
+    char fragmentation[32];
+    snprintf(fragmentation, sizeof(fragmentation), "%.3f", mapped == 0 ? 0.0 : double(free) / mapped);
+
+    stats.emplace_back("total_malloced", std::to_string(mapped));
+    stats.emplace_back("slab_used_bytes", std::to_string(used));
+    stats.emplace_back("slab_free_bytes", std::to_string(free));
+    stats.emplace_back("slab_fragmentation", fragmentation);
+    stats.emplace_back("slabs_moved", std::to_string(_slabs_moved));
+    for (size_t cls = 0; cls < _allocator->Classes(); cls++) {
+        const Allocator::Mempool &pool = _allocator->Pool(cls);
+        if (pool.Slabs() == 0 && _slab_evictions[cls] == 0) {
+            continue;
+        }
+        std::string prefix = std::to_string(cls) + ":";
+        stats.emplace_back(prefix + "chunk_size", std::to_string(pool.ObjectSize()));
+        stats.emplace_back(prefix + "chunks_per_page", std::to_string(pool.Capacity()));
+        stats.emplace_back(prefix + "total_pages", std::to_string(pool.Slabs()));
+        stats.emplace_back(prefix + "used_chunks", std::to_string(pool.Used()));
+        stats.emplace_back(prefix + "free_chunks", std::to_string(pool.Slabs() * pool.Capacity() - pool.Used()));
+        stats.emplace_back(prefix + "allocs", std::to_string(pool.Allocs()));
+        stats.emplace_back(prefix + "frees", std::to_string(pool.Frees()));
+        stats.emplace_back(prefix + "evictions", std::to_string(_slab_evictions[cls]));
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::MergeStats(std::vector<std::pair<std::string, std::string>> &total,
+                           const std::vector<std::pair<std::string, std::string>> &part) {
+    auto find = [&total](const std::string &name) {
+        return std::find_if(total.begin(), total.end(),
+                            [&name](const std::pair<std::string, std::string> &stat) { return stat.first == name; });
+    };
+
+    for (auto &stat : part) {
+        auto it = find(stat.first);
+        if (it == total.end()) {
+            total.push_back(stat);
+            continue;
+        }
+
+        const std::string &name = stat.first;
+        bool constant = name == "slab_fragmentation" ||
+                        (name.size() > 11 && name.compare(name.size() - 11, 11, ":chunk_size") == 0) ||
+                        (name.size() > 16 && name.compare(name.size() - 16, 16, ":chunks_per_page") == 0);
+        if (!constant) {
+            it->second = std::to_string(std::stoull(it->second) + std::stoull(stat.second));
+        }
+    }
+
+    auto free = find("slab_free_bytes");
+    auto mapped = find("total_malloced");
+    auto fragmentation = find("slab_fragmentation");
+    if (free != total.end() && mapped != total.end() && fragmentation != total.end()) {
+        size_t mapped_bytes = std::stoull(mapped->second);
+        char value[32];
+        snprintf(value, sizeof(value), "%.3f",
+                 mapped_bytes == 0 ? 0.0 : double(std::stoull(free->second)) / mapped_bytes);
+        fragmentation->second = value;
+    }
+}
+
+// See afina/Storage.h
+bool SimpleLRU::Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    std::string buffer;
+    bool compressed;
+    const std::string &stored = Pack(value, buffer, compressed);
+    if (key.size() + stored.size() > _max_size) {
+        return false;
+    }
+    lru_node *node = FindNode(key);
+    if (node != nullptr) { // key exist
+        ChangeKeyValue(*node, stored, compressed, MakeHeader(flags, expire));
+    } else { // key doesn't exist
+        MakeKeyValue(key, stored, compressed, MakeHeader(flags, expire));
+    }
+    return true;
+}
+
+// See afina/Storage.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    if (FindNode(key) != nullptr) {
+        return false;
+    }
+    std::string buffer;
+    bool compressed;
+    const std::string &stored = Pack(value, buffer, compressed);
+    if (key.size() + stored.size() > _max_size) {
+        return false;
+    }
+    MakeKeyValue(key, stored, compressed, MakeHeader(flags, expire));
+    return true;
+}
+
+// See afina/Storage.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    lru_node *node = FindNode(key);
+    if (node == nullptr) {
+        return false;
+    }
+    std::string buffer;
+    bool compressed;
+    const std::string &stored = Pack(value, buffer, compressed);
+    if (key.size() + stored.size() > _max_size) {
+        return false;
+    }
+    ChangeKeyValue(*node, stored, compressed, MakeHeader(flags, expire));
+    return true;
+}
+
+// See afina/Storage.h
+bool SimpleLRU::Get(const std::string &key, std::string &value, ItemHeader &header) {
+    lru_node *node = FindNode(key);
+    if (node != nullptr) {
+        Unpack(*node, value);
+        header = node->header;
+        MoveNodeToHead(*node);
         return true;
     }
     return false;
 }
 
+// See afina/Storage.h
+CasResult SimpleLRU::CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                    int32_t expire, uint64_t cas) {
+    lru_node *node = FindNode(key);
+    if (node == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (node->header.cas != cas) {
+        return CasResult::kExists;
+    }
+    std::string buffer;
+    bool compressed;
+    const std::string &stored = Pack(value, buffer, compressed);
+    if (key.size() + stored.size() > _max_size) {
+        return CasResult::kNotFound;
+    }
+    ChangeKeyValue(*node, stored, compressed, MakeHeader(flags, expire));
+    return CasResult::kStored;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Append(const std::string &key, const std::string &value) {
+    lru_node *node = FindNode(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    ItemHeader header = node->header;
+    header.cas = _next_cas++;
+    if (node->compressed) {
+        std::string whole;
+        Unpack(*node, whole);
+        whole += value;
+        std::string buffer;
+        bool compressed;
+        const std::string &stored = Pack(whole, buffer, compressed);
+        if (key.size() + stored.size() > _max_size) {
+            return false;
+        }
+        ChangeKeyValue(*node, stored, compressed, header);
+        return true;
+    }
+
+    std::size_t size = node->value_size + value.size();
+    if (key.size() + size > _max_size) {
+        return false;
+    }
+
+    // Node is the head now, so it is the last one to be evicted and the check above keeps it
+    MoveNodeToHead(*node);
+    while (_current_size + value.size() > _max_size) {
+        DeleteElementFromTail();
+    }
+
+    if (size > node->value_capacity) {
+        std::size_t capacity = Allocator::Small::BlockSize(std::max(size, node->value_size + node->value_size / 2));
+        char *grown = static_cast<char *>(Alloc(capacity, node));
+        std::memcpy(grown, node->value, node->value_size);
+        _lru_head.get_deleter().Free(node->value, node->value_capacity);
+        node->value = grown;
+        node->value_capacity = capacity;
+    }
+    std::memcpy(node->value + node->value_size, value.data(), value.size());
+    node->value_size = size;
+    node->header = header;
+    _current_size += value.size();
+    return true;
+}
+
 } // namespace Backend
 } // namespace Afina
@@ -1,12 +1,17 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/allocator/SharedSmall.h>
+#include <afina/allocator/Small.h>
+#include <afina/allocator/StlAllocator.h>
 
 namespace Afina {
 namespace Backend {
@@ -14,16 +19,69 @@ namespace Backend {
 /**
  * # Map based implementation
  * That is NOT thread safe implementaiton!!
+ *
+ * Values of compress_threshold bytes and above are kept compressed by LzCodec if that makes them
+ * smaller, sizes are accounted after compression so the same budget holds more items. Compression
+ * happens in the writing call, values are inflated only when they are read.
+ *
+ * Nodes and values live in the slab allocator owned by the cache, so each item costs two O(1) slab
+ * allocations of known size class instead of general purpose malloc calls. Caches guarded by different
+ * locks could share the thread caching one instead, so that memory freed by one of them is reused by
+ * the others.
+ *
+ * With memory limit set, cache that runs out of slabs evicts least recently used items until the block
+ * fits. As slabs stay in the size classes they were first given to, shift of value sizes leads to
+ * evictions while other classes have plenty of free room, MoveSlab gives pages back to where they are
+ * needed.
+ *
+ * Index nodes come from a separate allocator of the cache, outside of the memory limit, so that lookup
+ * structure never competes with items for slabs and its footprint is reported on its own.
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    explicit SimpleLRU(size_t max_size = 1024) : _max_size(max_size),
+    // Gets key, value and header of the item leaving the cache
+    using drop_hook = std::function<void(const std::string &, const std::string &, const ItemHeader &)>;
+
+    /**
+     * @param shared_allocator slab allocator shared with other caches, own one is created if it is null
+     * @param memory_limit number of bytes own allocator could take for slabs, 0 means no limit
+     */
+    explicit SimpleLRU(size_t max_size = 1024, size_t compress_threshold = 0,
+                       std::shared_ptr<Allocator::SharedSmall> shared_allocator = nullptr,
+                       size_t memory_limit = 0) : _max_size(max_size),
+                                        _compress_threshold(compress_threshold),
                                         _current_size(0),
                                         _lru_tail(nullptr),
-                                        _lru_index(),
-                                        _lru_head() {}
+                                        _allocator(shared_allocator ? nullptr : new Allocator::Small(memory_limit)),
+                                        _shared_allocator(std::move(shared_allocator)),
+                                        _slab_evictions(_allocator ? _allocator->Classes() : 0, 0),
+                                        _slab_evictions_seen(_slab_evictions),
+                                        _move_class(_slab_evictions.size()),
+                                        _index_allocator(new Allocator::Small()),
+                                        _lru_index(index_allocator(*_index_allocator)),
+                                        _lru_head(nullptr, node_deleter{_shared_allocator.get()}) {}
 
-    SimpleLRU(SimpleLRU&&) = default;
+    SimpleLRU(SimpleLRU &&other) : _current_size(other._current_size),
+                                   _next_cas(other._next_cas),
+                                   _max_size(other._max_size),
+                                   _compress_threshold(other._compress_threshold),
+                                   _allocator(std::move(other._allocator)),
+                                   _shared_allocator(std::move(other._shared_allocator)),
+                                   _slab_evictions(std::move(other._slab_evictions)),
+                                   _slab_evictions_seen(std::move(other._slab_evictions_seen)),
+                                   _slabs_moved(other._slabs_moved),
+                                   _move_class(other._move_class),
+                                   _move_relocate(other._move_relocate),
+                                   _move_cursor(std::move(other._move_cursor)),
+                                   _index_allocator(std::move(other._index_allocator)),
+                                   _lru_head(std::move(other._lru_head)),
+                                   _lru_tail(other._lru_tail),
+                                   _lru_index(std::move(other._lru_index)),
+                                   _on_drop(std::move(other._on_drop)) {
+        other._current_size = 0;
+        other._lru_tail = nullptr;
+        other._lru_index.clear();
+    }
 
     ~SimpleLRU() override {
         _lru_index.clear();
@@ -49,14 +107,97 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override;
+
+    /**
+     * Implements Afina::Storage interface. Data is copied right after the value when its block has room,
+     * otherwise value moves to the block half as big again, so that value built by small appends costs
+     * amortized O(appended bytes). Compressed value is rebuilt as a whole, uncompressed one stays so
+     */
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Number of bytes (keys+values) currently stored in this cache
+    inline std::size_t CurrentSize() const { return _current_size; }
+
+    /**
+     * Sets function called with the last value of every item that expires or gets evicted, but not of the
+     * deleted or overwritten ones. It is called in the middle of the cache operation, so it must not touch
+     * this cache
+     */
+    void OnDrop(drop_hook hook) { _on_drop = std::move(hook); }
+
+    // Removes least recently used element, returns false if cache is empty
+    bool EvictOne();
+
+    /**
+     * Moves one slab to the size class that had the most evictions because of lack of memory since the
+     * previous call, from the class that has the most free room. Items living in that slab are moved to
+     * the other slabs of their class, if there is no class with enough free room items of the coldest
+     * class are evicted instead. Returns true if slab has been moved.
+     *
+     * Walks the whole cache, so it is meant to be called every now and then. Finishes the move started by
+     * MoveSlabStep if there is one. Does nothing if allocator is shared.
+     */
+    bool MoveSlab();
+
+    /**
+     * Same as MoveSlab, but done in steps: each call walks index until items worth of about budget bytes
+     * are visited or moved, so that pause of a single call is bounded whatever the cache size is. Cache is
+     * fully usable in between. Returns true if the move is in progress and more calls are needed
+     */
+    bool MoveSlabStep(std::size_t budget);
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Adds stats of one more cache to the totals of several ones, e.g. stripes of a striped storage: counters
+     * are summed, chunk sizes are kept and fragmentation is recomputed from the sums
+     */
+    static void MergeStats(std::vector<std::pair<std::string, std::string>> &total,
+                           const std::vector<std::pair<std::string, std::string>> &part);
+
 private:
 
+    struct lru_node;
+
+    // Destroys node allocated from the slab allocator along with its value
+    struct node_deleter {
+        void operator()(lru_node *node) const;
+
+        // Releases block to the allocator of the cache
+        void Free(void *ptr, std::size_t size) const;
+
+        // Null if the cache owns its allocator
+        Allocator::SharedSmall *shared;
+    };
+
     // LRU cache node
-    using lru_node = struct lru_node {
+    struct lru_node {
         const std::string key;
-        std::string value;
+        // Bytes from the slab allocator, compressed by LzCodec if compressed is set
+        char *value;
+        std::size_t value_size;
+        // Bytes allocated for the value, it grows in place up to that
+        std::size_t value_capacity;
+        ItemHeader header;
+        bool compressed;
         lru_node* prev;
-        std::unique_ptr<lru_node> next;
+        std::unique_ptr<lru_node, node_deleter> next;
     };
 
     // The function makes new LRU head.
@@ -68,33 +209,102 @@ private:
     // The function delete the last element from LRU tail.
     void DeleteElementFromTail();
 
-    // Put new value and key in LRU.
+    // Put new value and key in LRU, value is in the stored form already.
     void MakeKeyValue(const std::string &key,
-                      const std::string &value);
+                      const std::string &value,
+                      bool compressed,
+                      const ItemHeader &header);
 
-    // This function changes the value of the given key.
+    // This function changes the value of the given key, value is in the stored form already.
     void ChangeKeyValue(lru_node &node,
-                        const std::string &value);
+                        const std::string &value,
+                        bool compressed,
+                        const ItemHeader &header);
+
+    // Allocates block from the allocator of the cache, lack of slabs is resolved by evictions, the
+    // keep node is never evicted.
+    void *Alloc(std::size_t size, const lru_node *keep = nullptr);
+
+    // Copies value into the block from the slab allocator.
+    char *CopyValue(const std::string &value, const lru_node *keep = nullptr);
+
+    // Moves value of the node to the new block of the same size class, returns false if there is no room.
+    bool RelocateValue(lru_node &node);
+
+    // Moves node itself to the new block of the same size class, returns false if there is no room.
+    bool RelocateNode(lru_node &node);
+
+    // Returns value in the form it is to be stored in, compressed one is put into the buffer.
+    const std::string &Pack(const std::string &value, std::string &buffer, bool &compressed) const;
+
+    // Restores value of the node as it was put by a client.
+    void Unpack(const lru_node &node, std::string &value) const;
+
+    // Unlinks the node from LRU and index and destroys it.
+    void DeleteNode(lru_node &node);
+
+    // Finds node for the key, expired node is deleted and never returned.
+    lru_node *FindNode(const std::string &key);
+
+    // Builds metadata for the new version of an item.
+    ItemHeader MakeHeader(uint32_t flags, int32_t expire);
+
+    // Picks class to take slab from and starts draining it, returns false if there is nothing to drain.
+    bool StartMove();
 
     // Current number of bytes (keys+values)
     // that are stored in this cache.
     std::size_t _current_size = 0;
 
+    // Cas unique for the next modification of an item.
+    uint64_t _next_cas = 1;
+
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be less the _max_size
     std::size_t _max_size;
 
+    // Values of this size and above are compressed, 0 disables compression
+    std::size_t _compress_threshold;
+
+    // Memory for nodes and values, must outlive all of them. Only one of them is set
+    std::unique_ptr<Allocator::Small> _allocator;
+    std::shared_ptr<Allocator::SharedSmall> _shared_allocator;
+
+    // Evictions caused by lack of slabs by size class of own allocator
+    std::vector<uint64_t> _slab_evictions;
+
+    // Evictions seen by the previous MoveSlab call
+    std::vector<uint64_t> _slab_evictions_seen;
+
+    // Number of slabs moved between size classes
+    uint64_t _slabs_moved = 0;
+
+    // Slab move in progress: class being drained, number of classes if there is none; whether its items
+    // are relocated or evicted; key of the next index entry to visit
+    std::size_t _move_class;
+    bool _move_relocate = false;
+    std::string _move_cursor;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
-    // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
+    // List owns all nodes, all links carry the same deleter as the head
+    std::unique_ptr<lru_node, node_deleter> _lru_head;
 
     lru_node *_lru_tail;
 
+    // Memory for the index nodes, must outlive the index
+    std::unique_ptr<Allocator::Small> _index_allocator;
+
+    using index_entry = std::pair<const std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>>;
+    using index_allocator = Allocator::StlAllocator<index_entry, Allocator::Small>;
+
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
     std::map<std::reference_wrapper<const std::string>,
-             std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+             std::reference_wrapper<lru_node>, std::less<std::string>, index_allocator> _lru_index;
+
+    // Called for items that expire or get evicted, could be empty
+    drop_hook _on_drop;
 };
 
 } // namespace Backend
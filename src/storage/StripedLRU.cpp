@@ -3,7 +3,9 @@
 namespace Afina {
 namespace Backend {
 
-std::unique_ptr<StripedLRU> StripedLRU::CreateStorage(const size_t max_size, const size_t stripe_count) {
+std::unique_ptr<StripedLRU> StripedLRU::CreateStorage(const size_t max_size, const size_t stripe_count,
+                                                      const size_t compress_threshold,
+                                                      std::chrono::milliseconds trim_interval) {
     size_t capacity = 0;
     if (stripe_count != 0) {
         capacity = max_size / stripe_count;
@@ -14,9 +16,39 @@ std::unique_ptr<StripedLRU> StripedLRU::CreateStorage(const size_t max_size, con
         throw std::runtime_error("There is no reason to use so big number "
                                  "of stripes, because size of each of them is too small!!!!");
     }
-    return std::unique_ptr<StripedLRU>(new StripedLRU(max_size, stripe_count));
+    return std::unique_ptr<StripedLRU>(new StripedLRU(max_size, stripe_count, compress_threshold, trim_interval));
 };
 
+void StripedLRU::Start() {
+    if (_trimmer.joinable()) {
+        return;
+    }
+
+    _stopping = false;
+    _trimmer = std::thread(&StripedLRU::Trim, this);
+}
+
+void StripedLRU::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_trimmer_mutex);
+        _stopping = true;
+    }
+    _trimmer_stop.notify_all();
+
+    if (_trimmer.joinable()) {
+        _trimmer.join();
+    }
+}
+
+void StripedLRU::Trim() {
+    // Freed objects pile up in the depot of their size class and never go back to slabs otherwise, so
+    // shift of value sizes would leave memory stuck in the classes that aren't used anymore
+    std::unique_lock<std::mutex> lock(_trimmer_mutex);
+    while (!_trimmer_stop.wait_for(lock, _trim_interval, [this] { return _stopping; })) {
+        _allocator->Trim();
+    }
+}
+
 bool StripedLRU::Put(const std::string &key, const std::string &value) {
     std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
     return _shard[hash(key) % _stripe_count].Put(key, value);
@@ -42,12 +74,65 @@ bool StripedLRU::Get(const std::string &key, std::string &value) {
     return _shard[hash(key) % _stripe_count].Get(key, value);
 }
 
+bool StripedLRU::Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].Put(key, value, flags, expire);
+}
+
+bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].PutIfAbsent(key, value, flags, expire);
+}
+
+bool StripedLRU::Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].Set(key, value, flags, expire);
+}
+
+bool StripedLRU::Get(const std::string &key, std::string &value, ItemHeader &header) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].Get(key, value, header);
+}
+
+CasResult StripedLRU::CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                     int32_t expire, uint64_t cas) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].CompareAndSwap(key, value, flags, expire, cas);
+}
+
+bool StripedLRU::Append(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> _lock(_mutex_for_shard[hash(key) % _stripe_count]);
+    return _shard[hash(key) % _stripe_count].Append(key, value);
+}
+
+void StripedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::pair<std::string, std::string>> total;
+    for (size_t i = 0; i < _stripe_count; i++) {
+        std::vector<std::pair<std::string, std::string>> stripe;
+        {
+            std::lock_guard<std::mutex> _lock(_mutex_for_shard[i]);
+            _shard[i].Stats(stripe);
+        }
+        SimpleLRU::MergeStats(total, stripe);
+    }
+    stats.insert(stats.end(), total.begin(), total.end());
+
+    // Stripes don't report slabs of the shared allocator, it is the same for all of them
+    stats.emplace_back("stripes", std::to_string(_stripe_count));
+    stats.emplace_back("total_malloced", std::to_string(_allocator->Mapped()));
+    stats.emplace_back("slab_used_chunks", std::to_string(_allocator->Used()));
+}
+
 StripedLRU::StripedLRU(size_t max_size,
-                       size_t stripe_count):  _stripe_count(stripe_count),
-                                              _capacity(max_size / _stripe_count),
-                                              _mutex_for_shard(stripe_count) {
+                       size_t stripe_count,
+                       size_t compress_threshold,
+                       std::chrono::milliseconds trim_interval):  _stripe_count(stripe_count),
+                                              _capacity(max_size / stripe_count),
+                                              _allocator(new Allocator::SharedSmall()),
+                                              _mutex_for_shard(stripe_count),
+                                              _trim_interval(trim_interval) {
     for (size_t i = 0; i < _stripe_count; i++) {
-        _shard.emplace_back(SimpleLRU(_capacity));
+        _shard.emplace_back(SimpleLRU(_capacity, compress_threshold, _allocator));
     }
 };
 
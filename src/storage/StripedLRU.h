@@ -6,16 +6,33 @@
 #define AFINA_STORAGE_TRIPED_LRU_H
 
 #include "SimpleLRU.h"
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 #include <vector>
 
 namespace Afina {
 namespace Backend {
 
+/**
+ * # Striped LRU
+ * Keys are spread over stripes by hash, each stripe has its own lock. Stripes allocate from the shared thread
+ * caching allocator, Start runs background thread giving objects cached by it back to slabs every
+ * trim_interval, so that memory freed in one size class could be reused by the others.
+ */
 class StripedLRU: public Afina::Storage {
 public:
 
     static std::unique_ptr<StripedLRU>
-        CreateStorage(const size_t max_size  = 1024, const size_t stripe_count = 2);
+        CreateStorage(const size_t max_size  = 1024, const size_t stripe_count = 2,
+                      const size_t compress_threshold = 0,
+                      std::chrono::milliseconds trim_interval = std::chrono::milliseconds(1000));
+
+    // Starts allocator trimmer
+    void Start() override;
+
+    // Stops allocator trimmer
+    void Stop() override;
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -32,17 +49,53 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
-    ~StripedLRU() {};
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    ~StripedLRU() { Stop(); };
 
 private:
 
-    StripedLRU(size_t max_size, size_t stripe_count);
+    StripedLRU(size_t max_size, size_t stripe_count, size_t compress_threshold,
+               std::chrono::milliseconds trim_interval);
+
+    // Trimmer thread body
+    void Trim();
 
     std::size_t _capacity = 0;
     size_t _stripe_count = 0;
     std::hash<std::string> hash;
+    // Stripes are locked separately, so they allocate through the thread caching front end
+    std::shared_ptr<Allocator::SharedSmall> _allocator;
     std::vector<SimpleLRU> _shard;
     std::vector<std::mutex> _mutex_for_shard;
+
+    const std::chrono::milliseconds _trim_interval;
+
+    // Wakes trimmer up on stop
+    std::mutex _trimmer_mutex;
+    std::condition_variable _trimmer_stop;
+    bool _stopping = false;
+    std::thread _trimmer;
     // hash
 };
 } // namespace Backend
@@ -0,0 +1,269 @@
+#include "StripedLeaseLRU.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+std::unique_ptr<StripedLeaseLRU> StripedLeaseLRU::CreateStorage(const size_t max_size, const size_t stripe_count,
+                                                                duration wait_timeout, duration lease_ttl,
+                                                                duration stale_ttl) {
+    if (stripe_count == 0) {
+        throw std::runtime_error("Number of stripes is equal to zero!!!!");
+    }
+    if (max_size / stripe_count < 1 * 1024 * 1024UL) {
+        throw std::runtime_error("There is no reason to use so big number "
+                                 "of stripes, because size of each of them is too small!!!!");
+    }
+    return std::unique_ptr<StripedLeaseLRU>(
+        new StripedLeaseLRU(max_size, stripe_count, wait_timeout, lease_ttl, stale_ttl));
+}
+
+StripedLeaseLRU::StripedLeaseLRU(size_t max_size, size_t stripe_count, duration wait_timeout, duration lease_ttl,
+                                 duration stale_ttl)
+    : _stripe_count(stripe_count), _capacity(max_size / stripe_count), _wait_timeout(wait_timeout),
+      _lease_ttl(lease_ttl),
+      _stale_expire(static_cast<int32_t>(std::max<duration::rep>(1, (stale_ttl.count() + 999) / 1000))),
+      _next_token(1) {
+    for (size_t i = 0; i < _stripe_count; i++) {
+        _shard.emplace_back(new stripe(_capacity));
+
+        // Hot key that expires or gets evicted is the one readers are going to miss on all at once
+        stripe *s = _shard.back().get();
+        int32_t expire = _stale_expire;
+        s->storage.OnDrop([s, expire](const std::string &key, const std::string &value, const ItemHeader &header) {
+            s->stale.Put(key, value, header.flags, expire);
+        });
+    }
+}
+
+// See StripedLeaseLRU.h
+StripedLeaseLRU::Lease StripedLeaseLRU::GetOrLease(const std::string &key, std::string &value, uint64_t &token) {
+    stripe &s = StripeFor(key);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    ItemHeader header;
+    return Lookup(s, lock, key, value, header, token);
+}
+
+// See StripedLeaseLRU.h
+bool StripedLeaseLRU::Fill(const std::string &key, const std::string &value, uint64_t token, uint32_t flags,
+                           int32_t expire) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.leases.find(key);
+    if (it == s.leases.end() || it->second->token != token ||
+        it->second->deadline <= std::chrono::steady_clock::now()) {
+        return false;
+    }
+
+    bool result = s.storage.Put(key, value, flags, expire);
+    s.stale.Delete(key);
+    Complete(s, key);
+    return result;
+}
+
+// See StripedLeaseLRU.h
+void StripedLeaseLRU::Release(const std::string &key, uint64_t token) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.leases.find(key);
+    if (it != s.leases.end() && it->second->token == token) {
+        Complete(s, key);
+    }
+}
+
+bool StripedLeaseLRU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0, 0); }
+
+bool StripedLeaseLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, value, 0, 0);
+}
+
+bool StripedLeaseLRU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0, 0); }
+
+bool StripedLeaseLRU::Delete(const std::string &key) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // Keep last known value around, so that readers could be served while someone refills the key
+    std::string value;
+    ItemHeader header;
+    if (!s.storage.Get(key, value, header)) {
+        return false;
+    }
+    s.storage.Delete(key);
+    s.stale.Put(key, value, header.flags, _stale_expire);
+    return true;
+}
+
+bool StripedLeaseLRU::Get(const std::string &key, std::string &value) {
+    ItemHeader header;
+    return Get(key, value, header);
+}
+
+bool StripedLeaseLRU::Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.storage.Put(key, value, flags, expire)) {
+        return false;
+    }
+    s.stale.Delete(key);
+    Complete(s, key);
+    return true;
+}
+
+bool StripedLeaseLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags,
+                                  int32_t expire) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.storage.PutIfAbsent(key, value, flags, expire)) {
+        return false;
+    }
+    s.stale.Delete(key);
+    Complete(s, key);
+    return true;
+}
+
+bool StripedLeaseLRU::Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.storage.Set(key, value, flags, expire)) {
+        return false;
+    }
+    Complete(s, key);
+    return true;
+}
+
+bool StripedLeaseLRU::Get(const std::string &key, std::string &value, ItemHeader &header) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // Plain Get neither takes nor waits for leases: nobody may ever fill the key it missed, so it would just
+    // make misses slower. Stale data isn't returned either as that breaks Storage contract
+    return s.storage.Get(key, value, header);
+}
+
+CasResult StripedLeaseLRU::CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags,
+                                          int32_t expire, uint64_t cas) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    CasResult result = s.storage.CompareAndSwap(key, value, flags, expire, cas);
+    if (result == CasResult::kStored) {
+        Complete(s, key);
+    }
+    return result;
+}
+
+bool StripedLeaseLRU::Append(const std::string &key, const std::string &value) {
+    stripe &s = StripeFor(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.storage.Append(key, value)) {
+        return false;
+    }
+    Complete(s, key);
+    return true;
+}
+
+bool StripedLeaseLRU::LeaseGet(const std::string &key, std::string &value, ItemHeader &header) {
+    stripe &s = StripeFor(key);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    uint64_t token;
+    Lease result = Lookup(s, lock, key, value, header, token);
+    return result == Lease::kHit || result == Lease::kStale;
+}
+
+void StripedLeaseLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::pair<std::string, std::string>> live, stale;
+    size_t leases = 0;
+    for (auto &ps : _shard) {
+        std::vector<std::pair<std::string, std::string>> live_part, stale_part;
+        {
+            std::lock_guard<std::mutex> lock(ps->mutex);
+            ps->storage.Stats(live_part);
+            ps->stale.Stats(stale_part);
+            leases += ps->leases.size();
+        }
+        SimpleLRU::MergeStats(live, live_part);
+        SimpleLRU::MergeStats(stale, stale_part);
+    }
+    stats.insert(stats.end(), live.begin(), live.end());
+
+    // Stale copies are reported in short, their slabs are not of much interest
+    for (auto &stat : stale) {
+        if (stat.first == "curr_items" || stat.first == "bytes" || stat.first == "total_malloced") {
+            stats.emplace_back("stale_" + stat.first, stat.second);
+        }
+    }
+    stats.emplace_back("stripes", std::to_string(_stripe_count));
+    stats.emplace_back("leases", std::to_string(leases));
+}
+
+// See StripedLeaseLRU.h
+StripedLeaseLRU::Lease StripedLeaseLRU::Lookup(stripe &s, std::unique_lock<std::mutex> &lock,
+                                               const std::string &key, std::string &value, ItemHeader &header,
+                                               uint64_t &token) {
+    if (s.storage.Get(key, value, header)) {
+        return Lease::kHit;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto it = s.leases.find(key);
+    if (it == s.leases.end() || it->second->deadline <= now) {
+        // Lease holder has gone away, there is no reason to keep its waiters
+        if (it != s.leases.end()) {
+            Complete(s, key);
+        }
+
+        if (s.leases.size() >= s.sweep_at) {
+            for (auto l = s.leases.begin(); l != s.leases.end();) {
+                if (l->second->deadline <= now) {
+                    l->second->done = true;
+                    l->second->filled.notify_all();
+                    l = s.leases.erase(l);
+                } else {
+                    ++l;
+                }
+            }
+            s.sweep_at = std::max<size_t>(64, 2 * s.leases.size());
+        }
+
+        std::shared_ptr<lease> pl = std::make_shared<lease>();
+        pl->token = _next_token.fetch_add(1);
+        pl->deadline = now + _lease_ttl;
+        s.leases.emplace(key, pl);
+
+        token = pl->token;
+        return Lease::kFill;
+    }
+
+    if (s.stale.Get(key, value, header)) {
+        return Lease::kStale;
+    }
+
+    // Wait for the lease holder, lease object is shared, so it outlives erase from the lease table
+    std::shared_ptr<lease> pl = it->second;
+    auto until = std::min(now + _wait_timeout, pl->deadline);
+    pl->filled.wait_until(lock, until, [&pl] { return pl->done; });
+
+    if (s.storage.Get(key, value, header)) {
+        return Lease::kHit;
+    }
+    return Lease::kMiss;
+}
+
+// See StripedLeaseLRU.h
+void StripedLeaseLRU::Complete(stripe &s, const std::string &key) {
+    auto it = s.leases.find(key);
+    if (it == s.leases.end()) {
+        return;
+    }
+
+    it->second->done = true;
+    it->second->filled.notify_all();
+    s.leases.erase(it);
+}
+
+} // namespace Backend
+} // namespace Afina
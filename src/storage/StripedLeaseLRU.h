@@ -0,0 +1,179 @@
+#ifndef AFINA_STORAGE_STRIPED_LEASE_LRU_H
+#define AFINA_STORAGE_STRIPED_LEASE_LRU_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Striped LRU with miss coalescing
+ * Same sharding scheme as StripedLRU, but every miss hands out a lease (fill token) for the key. While
+ * lease is outstanding all other readers of the key either wait for a bounded time on the per-key waiter
+ * list or, if they asked for it, get a stale copy of the value. That way concurrent misses on a hot key
+ * result in one backend fill instead of the stampede.
+ *
+ * Stale copy is the last value of the item that has expired, got evicted or deleted. Copies live for
+ * stale_ttl at most, so that nobody is served data that is too old.
+ *
+ * GetOrLease and LeaseGet hand out leases and wait for them. Client of LeaseGet gets no token, any write
+ * of the key completes the lease, so memcached get followed by set works as is. Plain Storage::Get misses
+ * right away: its caller doesn't promise to fill the key, so waiting for it would only add latency to
+ * ordinary misses
+ */
+class StripedLeaseLRU : public Afina::Storage {
+public:
+    using duration = std::chrono::milliseconds;
+
+    /**
+     * Result of the lease-aware lookup
+     */
+    enum class Lease {
+        // Value found in the cache
+        kHit,
+
+        // Value not found, caller got lease and must fill the key or release lease
+        kFill,
+
+        // Someone else is filling the key, value is a stale copy of the data
+        kStale,
+
+        // Value not found and wasn't filled in time by lease holder
+        kMiss
+    };
+
+    static std::unique_ptr<StripedLeaseLRU> CreateStorage(const size_t max_size = 1024, const size_t stripe_count = 2,
+                                                          duration wait_timeout = duration(50),
+                                                          duration lease_ttl = duration(2000),
+                                                          duration stale_ttl = duration(60000));
+
+    /**
+     * Lease-aware lookup. On hit copies value and returns kHit. On the first miss returns kFill and fill token
+     * that must be passed to Fill later on. Concurrent misses return kStale along with the stale copy of the
+     * value if there is one, otherwise wait up to wait_timeout for lease holder and return kHit or kMiss
+     *
+     * @param key to retrive value for
+     * @param value output parameter to copy value to
+     * @param token output parameter, fill token in case of kFill result
+     */
+    Lease GetOrLease(const std::string &key, std::string &value, uint64_t &token);
+
+    /**
+     * Stores value obtained by the lease holder and wakes up all waiters. Method returns false and doesn't
+     * change anything if token isn't valid anymore, i.e lease has been expired or key got updated by someone
+     * else meanwhile
+     */
+    bool Fill(const std::string &key, const std::string &value, uint64_t token, uint32_t flags = 0,
+              int32_t expire = 0);
+
+    /**
+     * Gives up lease without filling key, so that next miss could take it
+     */
+    void Release(const std::string &key, uint64_t token);
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface, hit or stale copy are found, kFill and kMiss are not
+    bool LeaseGet(const std::string &key, std::string &value, ItemHeader &header) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    ~StripedLeaseLRU() {}
+
+private:
+    // Outstanding fill of the single key
+    struct lease {
+        uint64_t token;
+        std::chrono::steady_clock::time_point deadline;
+
+        // Set once lease got filled or released, protected by stripe mutex
+        bool done = false;
+        std::condition_variable filled;
+    };
+
+    // Single lock domain: live data, stale copies of deleted keys and leases. Stale copies take 1/8 of the
+    // stripe capacity
+    struct stripe {
+        explicit stripe(size_t capacity) : storage(capacity - capacity / 8), stale(capacity / 8) {}
+
+        std::mutex mutex;
+        SimpleLRU storage;
+        SimpleLRU stale;
+        std::unordered_map<std::string, std::shared_ptr<lease>> leases;
+
+        // Size of the lease table that triggers next sweep of expired leases
+        size_t sweep_at = 64;
+    };
+
+    StripedLeaseLRU(size_t max_size, size_t stripe_count, duration wait_timeout, duration lease_ttl,
+                    duration stale_ttl);
+
+    stripe &StripeFor(const std::string &key) { return *_shard[hash(key) % _stripe_count]; }
+
+    // Lookup of GetOrLease, expects stripe to be locked
+    Lease Lookup(stripe &s, std::unique_lock<std::mutex> &lock, const std::string &key, std::string &value,
+                 ItemHeader &header, uint64_t &token);
+
+    // Wakes up waiters of the key if any and forgets lease, expects stripe to be locked
+    void Complete(stripe &s, const std::string &key);
+
+    size_t _stripe_count = 0;
+    size_t _capacity = 0;
+    duration _wait_timeout;
+    duration _lease_ttl;
+
+    // Expiration of stale copies in seconds, as storage takes it
+    int32_t _stale_expire;
+    std::hash<std::string> hash;
+    std::vector<std::unique_ptr<stripe>> _shard;
+
+    // Source of fill tokens, 0 is never handed out
+    std::atomic<uint64_t> _next_token;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_STRIPED_LEASE_LRU_H
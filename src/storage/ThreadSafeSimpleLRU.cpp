@@ -0,0 +1,46 @@
+#include "ThreadSafeSimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+// See ThreadSafeSimpleLRU.h
+void ThreadSafeSimpleLRU::Start() {
+    if (_memory_limit == 0 || _mover.joinable()) {
+        return;
+    }
+
+    _stopping = false;
+    _mover = std::thread(&ThreadSafeSimpleLRU::Rebalance, this);
+}
+
+// See ThreadSafeSimpleLRU.h
+void ThreadSafeSimpleLRU::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mover_mutex);
+        _stopping = true;
+    }
+    _mover_stop.notify_all();
+
+    if (_mover.joinable()) {
+        _mover.join();
+    }
+}
+
+// See ThreadSafeSimpleLRU.h
+void ThreadSafeSimpleLRU::Rebalance() {
+    std::unique_lock<std::mutex> lock(_mover_mutex);
+    while (!_mover_stop.wait_for(lock, _rebalance_interval, [this] { return _stopping; })) {
+        bool more = true;
+        while (more && !_stopping) {
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> _lock(mutex);
+                more = SimpleLRU::MoveSlabStep(_move_step);
+            }
+            lock.lock();
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -1,9 +1,12 @@
 #ifndef AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 #define AFINA_STORAGE_THREAD_SAFE_SIMPLE_LRU_H
 
+#include <chrono>
+#include <condition_variable>
 #include <map>
 #include <mutex>
 #include <string>
+#include <thread>
 
 #include "SimpleLRU.h"
 
@@ -12,13 +15,24 @@ namespace Backend {
 
 /**
  * # SimpleLRU thread safe version
- *
- *
+ * With memory limit set, Start runs background slab mover: every rebalance_interval it moves one slab to
+ * the size class having evictions, see SimpleLRU::MoveSlab. Slab is moved in steps of move_step bytes,
+ * lock is released between them, so clients never wait for longer than a single step.
  */
 class ThreadSafeSimpleLRU : public SimpleLRU {
 public:
-    ThreadSafeSimpleLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
-    ~ThreadSafeSimpleLRU() {}
+    ThreadSafeSimpleLRU(size_t max_size = 1024, size_t compress_threshold = 0, size_t memory_limit = 0,
+                        std::chrono::milliseconds rebalance_interval = std::chrono::milliseconds(1000),
+                        size_t move_step = 64 * 1024)
+        : SimpleLRU(max_size, compress_threshold, nullptr, memory_limit), _memory_limit(memory_limit),
+          _rebalance_interval(rebalance_interval), _move_step(move_step), _stopping(false) {}
+    ~ThreadSafeSimpleLRU() { Stop(); }
+
+    // Starts slab mover if there is memory limit
+    void Start() override;
+
+    // Stops slab mover
+    void Stop() override;
 
     // see SimpleLRU.h
     bool Put(const std::string &key, const std::string &value) override {
@@ -50,8 +64,66 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::Put(key, value, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::PutIfAbsent(key, value, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, uint32_t flags, int32_t expire) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::Set(key, value, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value, ItemHeader &header) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::Get(key, value, header);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, uint32_t flags, int32_t expire,
+                             uint64_t cas) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::CompareAndSwap(key, value, flags, expire, cas);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        return SimpleLRU::Append(key, value);
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<std::mutex> _lock(mutex);
+        SimpleLRU::Stats(stats);
+    }
+
 private:
+    // Slab mover thread body
+    void Rebalance();
+
     std::mutex mutex;
+
+    const size_t _memory_limit;
+    const std::chrono::milliseconds _rebalance_interval;
+
+    // Budget of a single slab move step, see SimpleLRU::MoveSlabStep
+    const size_t _move_step;
+
+    // Wakes slab mover up on stop
+    std::mutex _mover_mutex;
+    std::condition_variable _mover_stop;
+    bool _stopping;
+    std::thread _mover;
 };
 
 } // namespace Backend
@@ -1,4 +1,6 @@
 #include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -103,6 +105,21 @@ TEST(SimpleTest, AllocNoMem) {
     }
 }
 
+TEST(SimpleTest, AllocHuge) {
+    Simple a(buf, sizeof(buf));
+    for (size_t size : {SIZE_MAX, SIZE_MAX - 1, SIZE_MAX - sizeof(void *), sizeof(buf) + 1}) {
+        EXPECT_THROW(a.alloc(size), AllocError);
+
+        // Failed realloc leaves block as it was
+        Pointer p = a.alloc(16);
+        std::memset(p.get(), 'x', 16);
+        EXPECT_THROW(a.realloc(p, size), AllocError);
+        EXPECT_EQ('x', static_cast<char *>(p.get())[15]);
+        a.free(p);
+    }
+    EXPECT_EQ(0, a.stats().used_blocks);
+}
+
 TEST(SimpleTest, AllocReuse) {
     Simple a(buf, sizeof(buf));
 
@@ -322,3 +339,218 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, ReallocGrowIntoNeighbour) {
+    Simple a(buf, sizeof(buf));
+
+    int size = 64;
+    Pointer p = a.alloc(size);
+    Pointer p2 = a.alloc(size * 2);
+    Pointer p3 = a.alloc(size);
+
+    writeTo(p, size);
+    writeTo(p3, size);
+    a.free(p2);
+
+    // Freed neighbour is absorbed, the rest of it stays free
+    void *ptr = p.get();
+    a.realloc(p, size * 2);
+    EXPECT_EQ(p.get(), ptr);
+    EXPECT_TRUE(isDataOk(p, size));
+    EXPECT_EQ(a.stats().free_blocks, 1);
+
+    writeTo(p, size * 2);
+    EXPECT_TRUE(isDataOk(p, size * 2));
+    EXPECT_TRUE(isDataOk(p3, size));
+
+    a.free(p);
+    a.free(p3);
+}
+
+TEST(SimpleTest, ReallocAppend) {
+    Simple a(buf, sizeof(buf));
+
+    // Two values appended in turns, so that neither of them is the last block for long
+    Pointer p = a.alloc(8);
+    Pointer p2 = a.alloc(8);
+    size_t moves = 0;
+    for (size_t size = 16; size <= 8000; size += 8) {
+        for (Pointer *v : {&p, &p2}) {
+            void *ptr = v->get();
+            a.realloc(*v, size);
+            memset(static_cast<char *>(v->get()) + size - 8, int(size / 8), 8);
+            moves += v->get() != ptr;
+        }
+    }
+
+    // Geometric growth: number of moves is logarithmic in the size
+    EXPECT_LT(moves, 60);
+    for (Pointer *v : {&p, &p2}) {
+        for (size_t i = 16; i <= 8000; i += 8) {
+            ASSERT_EQ(static_cast<char *>(v->get())[i - 1], char(i / 8));
+        }
+    }
+
+    a.free(p);
+    a.free(p2);
+}
+
+TEST(SimpleTest, InvalidFree) {
+    char other_buf[1024];
+    Simple a(buf, sizeof(buf));
+    Simple other(other_buf, sizeof(other_buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    // Freeing empty pointer is no-op, freeing the same block twice is an error
+    a.free(p);
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    Pointer foreign = other.alloc(100);
+    try {
+        a.free(foreign);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SimpleTest, DefragReclaimsEverything) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 100;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+
+    // Free every other block, none of the holes fits bigger block
+    vector<Pointer> alive;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 2 == 0) {
+            a.free(ptrs[i]);
+        } else {
+            alive.push_back(ptrs[i]);
+        }
+    }
+
+    a.defrag();
+    Pointer big = a.alloc(size * ptrs.size() / 3);
+    writeTo(big, size * ptrs.size() / 3);
+
+    for (Pointer &p : alive) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+    a.free(big);
+}
+
+TEST(SimpleTest, DefragStep) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 100;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+
+    vector<Pointer> alive;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 2 == 0) {
+            a.free(ptrs[i]);
+        } else {
+            alive.push_back(ptrs[i]);
+        }
+    }
+
+    // Allocator keeps working between the steps
+    size_t steps = 0;
+    while (!a.defrag_step(1024)) {
+        steps++;
+        alive.push_back(a.alloc(size));
+        writeTo(alive.back(), size);
+        if (steps % 3 == 0) {
+            a.free(alive[steps]);
+            alive.erase(alive.begin() + steps);
+        }
+        for (Pointer &p : alive) {
+            ASSERT_TRUE(isDataOk(p, size));
+        }
+    }
+    EXPECT_GT(steps, 10);
+
+    // Blocks freed during compaction are holes again, the rest of free memory is contiguous
+    a.defrag();
+    Pointer big = a.alloc(size * ptrs.size() / 4);
+    writeTo(big, size * ptrs.size() / 4);
+    for (Pointer &p : alive) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+    a.free(big);
+}
+
+TEST(SimpleTest, DefragStepFallback) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 100;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (size_t i = 0; i < ptrs.size(); i += 2) {
+        a.free(ptrs[i]);
+    }
+
+    // Free blocks ahead of the cursor are out of the free lists until compaction gets to them, allocation
+    // that doesn't fit anywhere else finishes it
+    EXPECT_FALSE(a.defrag_step(0));
+    Pointer big = a.alloc(size * ptrs.size() / 3);
+    writeTo(big, size * ptrs.size() / 3);
+    for (size_t i = 1; i < ptrs.size(); i += 2) {
+        EXPECT_TRUE(isDataOk(ptrs[i], size));
+    }
+    EXPECT_TRUE(isDataOk(big, size * ptrs.size() / 3));
+}
+
+TEST(SimpleTest, Stats) {
+    Simple a(buf, sizeof(buf));
+    Simple::usage u = a.stats();
+    EXPECT_EQ(0, u.used_blocks);
+    EXPECT_EQ(0, u.free_blocks);
+    EXPECT_EQ(0.0, u.fragmentation());
+
+    vector<Pointer> ptrs;
+    for (int i = 0; i < 100; i++) {
+        ptrs.push_back(a.alloc(100));
+    }
+    for (int i = 0; i < 100; i += 2) {
+        a.free(ptrs[i]);
+    }
+
+    u = a.stats();
+    EXPECT_EQ(50, u.used_blocks);
+    EXPECT_EQ(50 * 104, u.used_bytes);
+    EXPECT_EQ(50, u.free_blocks);
+    EXPECT_EQ(50 * 104, u.free_bytes);
+    EXPECT_EQ(50, u.free_lists[6]);
+    EXPECT_EQ(100, u.allocs[6]);
+    EXPECT_EQ(50, u.frees[6]);
+    EXPECT_EQ(u.tail_bytes, u.largest_free);
+    EXPECT_GT(u.fragmentation(), 0.05);
+    EXPECT_NE(string::npos, a.dump().find("used 50 blocks 5200 bytes, free 50 blocks 5200 bytes"));
+    EXPECT_NE(string::npos, a.dump().find("class 6: free 50, allocs 100, frees 50\n"));
+
+    // Holes are reused and accounted
+    Pointer p = a.alloc(90);
+    EXPECT_EQ(49, a.stats().free_blocks);
+
+    a.defrag();
+    u = a.stats();
+    EXPECT_EQ(51, u.used_blocks);
+    EXPECT_EQ(0, u.free_blocks);
+    EXPECT_EQ(0, u.free_bytes);
+    EXPECT_EQ(0.0, u.fragmentation());
+}
@@ -0,0 +1,206 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SharedSmall.h>
+#include <afina/allocator/SlabCache.h>
+#include <afina/allocator/Small.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+TEST(MempoolTest, ReuseAndRelease) {
+    SlabCache cache;
+    Mempool pool(cache, 100);
+    EXPECT_EQ(104, pool.ObjectSize());
+
+    // Enough objects for a few slabs
+    vector<void *> objects;
+    set<void *> unique;
+    for (int i = 0; i < 10000; i++) {
+        objects.push_back(pool.Alloc());
+        ASSERT_NE(nullptr, objects.back());
+        std::memset(objects.back(), i % 127, 100);
+        unique.insert(objects.back());
+        EXPECT_EQ(&pool, Mempool::Of(objects.back()));
+    }
+    EXPECT_EQ(objects.size(), unique.size());
+    EXPECT_EQ(10000, pool.Used());
+    size_t slabs = pool.Slabs();
+    EXPECT_GT(slabs, 1);
+    EXPECT_EQ(slabs, cache.Used());
+
+    // Freed object is reused first
+    void *freed = objects[5000];
+    pool.Free(freed);
+    EXPECT_EQ(freed, pool.Alloc());
+    EXPECT_EQ(10001, pool.Allocs());
+    EXPECT_EQ(1, pool.Frees());
+
+    // Empty slabs go back to the cache except for the spare one
+    for (void *p : objects) {
+        pool.Free(p);
+    }
+    EXPECT_EQ(0, pool.Used());
+    EXPECT_EQ(1, pool.Slabs());
+    EXPECT_EQ(1, cache.Used());
+}
+
+TEST(MempoolTest, SlabsMoveBetweenPools) {
+    SlabCache cache(2 * Arena::kSlabSize);
+    Mempool small(cache, 16);
+    Mempool big(cache, 4096);
+
+    vector<void *> objects;
+    for (void *p = small.Alloc(); p != nullptr; p = small.Alloc()) {
+        objects.push_back(p);
+    }
+    EXPECT_EQ(2, cache.Used());
+    EXPECT_EQ(nullptr, big.Alloc());
+
+    for (void *p : objects) {
+        small.Free(p);
+    }
+
+    // One slab stays as a spare, the other one could be used by the other pool
+    EXPECT_NE(nullptr, big.Alloc());
+}
+
+TEST(MempoolTest, Drain) {
+    SlabCache cache(2 * Arena::kSlabSize);
+    Mempool pool(cache, 4096);
+
+    // Second slab holds just a few objects
+    vector<void *> objects;
+    for (size_t i = 0; i < pool.Capacity() + 3; i++) {
+        objects.push_back(pool.Alloc());
+    }
+    EXPECT_EQ(2, pool.Slabs());
+
+    EXPECT_TRUE(pool.Drain());
+    EXPECT_FALSE(pool.Drain());
+    EXPECT_FALSE(pool.Draining(objects[0]));
+    for (size_t i = pool.Capacity(); i < objects.size(); i++) {
+        EXPECT_TRUE(pool.Draining(objects[i]));
+    }
+
+    // Draining slab is not used for allocation and goes to the cache once empty, not to the spare
+    void *p = pool.Alloc();
+    EXPECT_EQ(nullptr, p);
+    for (size_t i = pool.Capacity(); i < objects.size(); i++) {
+        pool.Free(objects[i]);
+    }
+    EXPECT_EQ(1, pool.Slabs());
+    EXPECT_EQ(1, cache.Used());
+    EXPECT_FALSE(pool.Draining(objects.back()));
+
+    // Undrain returns slab back to allocation
+    pool.Free(objects[0]);
+    EXPECT_TRUE(pool.Drain());
+    pool.Undrain();
+    EXPECT_EQ(objects[0], pool.Alloc());
+    EXPECT_FALSE(pool.ReleaseSpare());
+}
+
+TEST(SmallTest, SizeClasses) {
+    Small a;
+
+    size_t prev = 8;
+    for (size_t cls = 0; cls < a.Classes(); cls++) {
+        size_t size = a.Pool(cls).ObjectSize();
+        EXPECT_GT(size, prev);
+        EXPECT_LE(size, prev < 128 ? prev + 8 : prev * 5 / 4 + 8);
+        prev = size;
+    }
+    EXPECT_EQ(Small::kMaxObject, prev);
+
+    for (size_t size : {0, 1, 16, 17, 128, 129, 1000, 4097, 32768, 32769, 100000}) {
+        void *p = a.Alloc(size);
+        std::memset(p, 1, size);
+        Small::Free(p, size);
+    }
+    for (size_t cls = 0; cls < a.Classes(); cls++) {
+        EXPECT_EQ(0, a.Pool(cls).Used());
+    }
+}
+
+TEST(SmallTest, Quota) {
+    Small a(Arena::kSlabSize);
+
+    void *first = a.Alloc(1000);
+    try {
+        a.Alloc(100);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+    Small::Free(first, 1000);
+    EXPECT_EQ(Arena::kSlabSize, a.Mapped());
+}
+
+TEST(SharedSmallTest, CrossThreadFree) {
+    SharedSmall a;
+
+    // Producer allocates, consumer frees, so all the objects travel through the depot
+    const size_t count = 100000;
+    std::vector<void *> objects(count);
+    std::thread producer([&] {
+        for (size_t i = 0; i < count; i++) {
+            objects[i] = a.Alloc(24 + i % 200);
+            std::memset(objects[i], 1, 24 + i % 200);
+        }
+    });
+    producer.join();
+
+    // Includes leftovers of the producer magazines
+    EXPECT_LE(count, a.Used());
+
+    std::thread consumer([&] {
+        for (size_t i = 0; i < count; i++) {
+            a.Free(objects[i], 24 + i % 200);
+        }
+    });
+    consumer.join();
+
+    // Exited threads flushed their magazines
+    a.Trim();
+    EXPECT_EQ(0, a.Used());
+}
+
+TEST(SharedSmallTest, Concurrent) {
+    SharedSmall a;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&a, t] {
+            std::vector<std::pair<char *, size_t>> live;
+            for (size_t i = 0; i < 50000; i++) {
+                size_t size = 8 + (i * 7 + t) % 1000;
+                char *p = static_cast<char *>(a.Alloc(size));
+                std::memset(p, t, size);
+                live.emplace_back(p, size);
+                if (live.size() > 100) {
+                    auto &victim = live[i % live.size()];
+                    ASSERT_EQ(char(t), victim.first[0]);
+                    ASSERT_EQ(char(t), victim.first[victim.second - 1]);
+                    a.Free(victim.first, victim.second);
+                    victim = live.back();
+                    live.pop_back();
+                }
+            }
+            for (auto &p : live) {
+                a.Free(p.first, p.second);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    a.Trim();
+    EXPECT_EQ(0, a.Used());
+}
@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/SharedSmall.h>
+#include <afina/allocator/Small.h>
+#include <afina/allocator/StlAllocator.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static size_t UsedObjects(Small &small) {
+    size_t used = 0;
+    for (size_t cls = 0; cls < small.Classes(); cls++) {
+        used += small.Pool(cls).Used();
+    }
+    return used;
+}
+
+TEST(StlAllocatorTest, Vector) {
+    Small small;
+    {
+        vector<int, StlAllocator<int, Small>> v{StlAllocator<int, Small>(small)};
+        for (int i = 0; i < 20000; i++) {
+            v.push_back(i);
+        }
+        for (int i = 0; i < 20000; i++) {
+            ASSERT_EQ(i, v[i]);
+        }
+
+        // Only the last buffer is alive, the large one lives in malloc
+        EXPECT_GT(small.Mapped(), 0);
+        EXPECT_EQ(0, UsedObjects(small));
+
+        v.resize(100);
+        v.shrink_to_fit();
+        EXPECT_EQ(1, UsedObjects(small));
+    }
+    EXPECT_EQ(0, UsedObjects(small));
+}
+
+TEST(StlAllocatorTest, MapNodes) {
+    Small small;
+    using allocator = StlAllocator<pair<const int, string>, Small>;
+    {
+        map<int, string, less<int>, allocator> m{allocator(small)};
+        for (int i = 0; i < 1000; i++) {
+            m.emplace(i, to_string(i));
+        }
+        EXPECT_EQ(1000, UsedObjects(small));
+
+        m.erase(m.begin(), m.find(500));
+        EXPECT_EQ(500, UsedObjects(small));
+        EXPECT_EQ("700", m[700]);
+    }
+    EXPECT_EQ(0, UsedObjects(small));
+}
+
+TEST(StlAllocatorTest, Rebind) {
+    Small small, other;
+    StlAllocator<char, Small> a(small);
+    StlAllocator<double, Small> b(a);
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(&small, &b.arena());
+    StlAllocator<char, Small> c(other);
+    EXPECT_TRUE(a != c);
+
+    double *d = b.allocate(3);
+    d[2] = 1.5;
+    EXPECT_EQ(1, UsedObjects(small));
+    b.deallocate(d, 3);
+    EXPECT_EQ(0, UsedObjects(small));
+}
+
+TEST(StlAllocatorTest, Quota) {
+    Small small(256 * 1024);
+    vector<int, StlAllocator<int, Small>> v{StlAllocator<int, Small>(small)};
+    v.reserve(8);
+    EXPECT_THROW(v.reserve(4096), AllocError);
+    EXPECT_EQ(8, v.capacity());
+}
+
+TEST(StlAllocatorTest, Shared) {
+    SharedSmall shared;
+    using allocator = StlAllocator<long, SharedSmall>;
+    vector<vector<long, allocator>> built;
+    for (int i = 0; i < 4; i++) {
+        built.emplace_back(allocator(shared));
+    }
+
+    // Containers are filled by some threads and destroyed by the other
+    vector<thread> threads;
+    for (auto &v : built) {
+        threads.emplace_back([&v] {
+            for (long i = 0; i < 1000; i++) {
+                v.push_back(i);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (auto &v : built) {
+        EXPECT_EQ(999, v.back());
+    }
+    built.clear();
+}
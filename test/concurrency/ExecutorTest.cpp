@@ -0,0 +1,227 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+
+using namespace Afina::Concurrency;
+
+// Keeps tasks busy until opened
+class gate {
+public:
+    void Wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _opened.wait(lock, [this] { return _open; });
+    }
+
+    void Open() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _open = true;
+        _opened.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _opened;
+    bool _open = false;
+};
+
+TEST(ExecutorTest, RunsTasks) {
+    std::atomic<int> sum(0);
+    {
+        Executor executor("test", 2, 4, 100, std::chrono::milliseconds(100));
+        for (int i = 1; i <= 100; i++) {
+            ASSERT_TRUE(executor.Execute([&sum](int v) { sum += v; }, i));
+        }
+        executor.Stop(true);
+        EXPECT_EQ(Executor::State::kStopped, executor.GetState());
+        EXPECT_EQ(0, executor.Threads());
+    }
+    EXPECT_EQ(5050, sum.load());
+}
+
+TEST(ExecutorTest, GrowsUpToHighWatermark) {
+    Executor executor("test", 1, 3, 2, std::chrono::milliseconds(100));
+    EXPECT_EQ(1, executor.Threads());
+
+    gate g;
+    std::atomic<int> done(0);
+    auto task = [&g, &done] {
+        g.Wait();
+        done++;
+    };
+
+    // Three tasks get a thread each, two more wait in the queue, the rest is rejected
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(executor.Execute(task));
+    }
+    EXPECT_EQ(3, executor.Threads());
+    EXPECT_FALSE(executor.Execute(task));
+
+    g.Open();
+    executor.Stop(true);
+    EXPECT_EQ(5, done.load());
+}
+
+TEST(ExecutorTest, ShrinksWhenIdle) {
+    Executor executor("test", 1, 4, 0, std::chrono::milliseconds(20));
+
+    gate g;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(executor.Execute([&g] { g.Wait(); }));
+    }
+    EXPECT_EQ(4, executor.Threads());
+    g.Open();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (executor.Threads() > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(1, executor.Threads());
+
+    // The last one stays for the next task
+    std::atomic<bool> ran(false);
+    EXPECT_TRUE(executor.Execute([&ran] { ran = true; }));
+    executor.Stop(true);
+    EXPECT_TRUE(ran.load());
+}
+
+TEST(ExecutorTest, StopCompletesQueued) {
+    Executor executor("test", 1, 1, 10, std::chrono::milliseconds(100));
+
+    gate g;
+    std::atomic<int> done(0);
+    EXPECT_TRUE(executor.Execute([&g] { g.Wait(); }));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(executor.Execute([&done] { done++; }));
+    }
+
+    // No new tasks once stopping, queued ones are still run
+    executor.Stop();
+    EXPECT_FALSE(executor.Execute([&done] { done++; }));
+    EXPECT_EQ(Executor::State::kStopping, executor.GetState());
+
+    g.Open();
+    executor.Stop(true);
+    EXPECT_EQ(10, done.load());
+    EXPECT_EQ(Executor::State::kStopped, executor.GetState());
+}
+
+TEST(ExecutorTest, DestroyRightAfterStop) {
+    // Destructor must wait for the last thread to leave the pool, not just to mark it stopped
+    for (int i = 0; i < 200; i++) {
+        std::atomic<int> done(0);
+        {
+            Executor executor("test", 2, 4, 10, std::chrono::milliseconds(100));
+            for (int j = 0; j < 4; j++) {
+                executor.Execute([&done] { done++; });
+            }
+            executor.Stop();
+        }
+        EXPECT_EQ(4, done.load());
+    }
+}
+
+TEST(ExecutorTest, SurvivesThrowingTask) {
+    Executor executor("test", 1, 1, 10, std::chrono::milliseconds(100));
+
+    std::atomic<bool> ran(false);
+    EXPECT_TRUE(executor.Execute([] { throw std::runtime_error("task failed"); }));
+    EXPECT_TRUE(executor.Execute([&ran] { ran = true; }));
+    executor.Stop(true);
+    EXPECT_TRUE(ran.load());
+}
+
+TEST(ExecutorTest, LanesShareByWeight) {
+    Executor executor("test", 1, 1, 100, std::chrono::milliseconds(100), {Executor::Lane(1), Executor::Lane(3)});
+
+    gate g;
+    EXPECT_TRUE(executor.Execute([&g] { g.Wait(); }));
+
+    std::mutex mutex;
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < 40; i++) {
+        std::size_t lane = i % 2;
+        EXPECT_TRUE(executor.ExecuteIn(lane, [&mutex, &order, lane] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(lane);
+        }));
+    }
+    EXPECT_EQ(20, executor.Stats(1).queued);
+
+    g.Open();
+    executor.Stop(true);
+    ASSERT_EQ(40, order.size());
+
+    // While both lanes have tasks the heavier one gets three of every four
+    std::size_t heavy = 0;
+    for (std::size_t i = 0; i < 20; i++) {
+        heavy += order[i];
+    }
+    EXPECT_GE(heavy, 14);
+    EXPECT_LE(heavy, 16);
+}
+
+TEST(ExecutorTest, LaneRunningCap) {
+    Executor executor("test", 4, 4, 100, std::chrono::milliseconds(100), {Executor::Lane(), Executor::Lane(1, 1)});
+
+    gate g;
+    std::atomic<int> running(0), max_running(0), done(0);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(executor.ExecuteIn(1, [&] {
+            int now = ++running;
+            int seen = max_running.load();
+            while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+            }
+            g.Wait();
+            running--;
+            done++;
+        }));
+    }
+
+    // Capped lane holds one thread, the other lane still gets the rest
+    std::atomic<bool> ran(false);
+    EXPECT_TRUE(executor.Execute([&ran] { ran = true; }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!ran.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(ran.load());
+    EXPECT_EQ(1, executor.Stats(1).running);
+    EXPECT_EQ(3, executor.Stats(1).queued);
+
+    g.Open();
+    executor.Stop(true);
+    EXPECT_EQ(4, done.load());
+    EXPECT_EQ(1, max_running.load());
+}
+
+TEST(ExecutorTest, LaneQueueLimit) {
+    Executor executor("test", 1, 1, 100, std::chrono::milliseconds(100), {Executor::Lane(), Executor::Lane(1, 0, 2)});
+
+    gate g;
+    EXPECT_TRUE(executor.Execute([&g] { g.Wait(); }));
+    EXPECT_TRUE(executor.ExecuteIn(1, [] {}));
+    EXPECT_TRUE(executor.ExecuteIn(1, [] {}));
+    EXPECT_FALSE(executor.ExecuteIn(1, [] {}));
+
+    // Other lane has room of its own
+    EXPECT_TRUE(executor.ExecuteIn(0, [] {}));
+    EXPECT_THROW(executor.ExecuteIn(2, [] {}), std::out_of_range);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    g.Open();
+    executor.Stop(true);
+
+    Executor::LaneStats stats = executor.Stats(1);
+    EXPECT_EQ(0, stats.queued);
+    EXPECT_EQ(2, stats.executed);
+    EXPECT_EQ(1, stats.rejected);
+    EXPECT_GE(stats.max_wait, std::chrono::milliseconds(20));
+    EXPECT_GE(stats.total_wait, stats.max_wait);
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+using namespace Afina::Concurrency;
+
+// Adds delta to the counter, returns the value before
+struct add_op {
+    long delta;
+    long result;
+};
+
+TEST(FlatCombineTest, SingleThread) {
+    long counter = 0;
+    std::size_t batches = 0;
+    FlatCombine<add_op> fc([&](add_op *const *ops, std::size_t count) {
+        batches++;
+        for (std::size_t i = 0; i < count; i++) {
+            ops[i]->result = counter;
+            counter += ops[i]->delta;
+        }
+    });
+
+    for (long i = 1; i <= 10; i++) {
+        add_op op{i, -1};
+        fc.Execute(op);
+        EXPECT_EQ(i * (i - 1) / 2, op.result);
+    }
+    EXPECT_EQ(55, counter);
+    EXPECT_EQ(10, batches);
+    EXPECT_EQ(1, fc.Size());
+}
+
+TEST(FlatCombineTest, ManyThreads) {
+    long counter = 0;
+    std::atomic<bool> inside(false);
+    std::atomic<bool> overlapped(false);
+    FlatCombine<add_op> fc([&](add_op *const *ops, std::size_t count) {
+        if (inside.exchange(true)) {
+            overlapped = true;
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            ops[i]->result = counter;
+            counter += ops[i]->delta;
+        }
+        inside = false;
+    });
+
+    const int threads = 8;
+    const int per_thread = 20000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&fc] {
+            for (int i = 0; i < per_thread; i++) {
+                add_op op{1, -1};
+                fc.Execute(op);
+                ASSERT_GE(op.result, 0);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    EXPECT_FALSE(overlapped.load());
+    EXPECT_EQ(long(threads) * per_thread, counter);
+    EXPECT_LE(fc.Size(), std::size_t(threads));
+}
+
+TEST(FlatCombineTest, RecordsAreReused) {
+    long counter = 0;
+    FlatCombine<add_op> fc([&](add_op *const *ops, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            counter += ops[i]->delta;
+        }
+    });
+
+    // Threads run one after another, each takes over the record of the previous one
+    for (int i = 0; i < 10; i++) {
+        std::thread([&fc] {
+            add_op op{1, 0};
+            fc.Execute(op);
+        }).join();
+    }
+    EXPECT_EQ(10, counter);
+    EXPECT_EQ(1, fc.Size());
+}
+
+TEST(FlatCombineTest, ApplyThrows) {
+    FlatCombine<add_op> fc([](add_op *const *ops, std::size_t count) {
+        if (ops[0]->delta < 0) {
+            throw std::invalid_argument("negative");
+        }
+    });
+
+    add_op bad{-1, 0};
+    EXPECT_THROW(fc.Execute(bad), std::invalid_argument);
+
+    add_op good{1, 0};
+    EXPECT_NO_THROW(fc.Execute(good));
+}
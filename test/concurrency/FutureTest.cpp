@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/Future.h>
+#include <afina/concurrency/StealingExecutor.h>
+
+using namespace Afina::Concurrency;
+
+TEST(FutureTest, GetReturnsValue) {
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    ASSERT_FALSE(future.Ready());
+    promise.SetValue(42);
+    ASSERT_TRUE(future.Ready());
+    ASSERT_EQ(42, future.Get());
+    ASSERT_FALSE(future.Valid());
+}
+
+TEST(FutureTest, GetWaitsForOtherThread) {
+    Promise<std::string> promise;
+    Future<std::string> future = promise.GetFuture();
+    std::thread producer([&promise] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        promise.SetValue("done");
+    });
+    ASSERT_EQ("done", future.Get());
+    producer.join();
+}
+
+TEST(FutureTest, ThenRunsInlineIfReady) {
+    std::thread::id called;
+    Future<int> future = MakeReadyFuture(20).Then([&called](int v) {
+        called = std::this_thread::get_id();
+        return v + 1;
+    });
+    ASSERT_EQ(std::this_thread::get_id(), called);
+    ASSERT_TRUE(future.Ready());
+    ASSERT_EQ(21, future.Get());
+}
+
+TEST(FutureTest, ThenRunsWhereValueIsSet) {
+    Promise<int> promise;
+    std::thread::id called;
+    Future<std::string> future = promise.GetFuture()
+                                     .Then([](int v) { return v * 2; })
+                                     .Then([&called](int v) {
+                                         called = std::this_thread::get_id();
+                                         return std::to_string(v);
+                                     });
+    ASSERT_FALSE(future.Ready());
+
+    std::thread::id producer_id;
+    std::thread producer([&promise, &producer_id] {
+        producer_id = std::this_thread::get_id();
+        promise.SetValue(21);
+    });
+    producer.join();
+    ASSERT_EQ(producer_id, called);
+    ASSERT_EQ("42", future.Get());
+}
+
+TEST(FutureTest, ExceptionSkipsContinuations) {
+    Promise<int> promise;
+    bool called = false;
+    Future<int> future = promise.GetFuture().Then([&called](int v) {
+        called = true;
+        return v;
+    });
+    promise.SetException(std::make_exception_ptr(std::invalid_argument("bad")));
+    ASSERT_THROW(future.Get(), std::invalid_argument);
+    ASSERT_FALSE(called);
+}
+
+TEST(FutureTest, ContinuationThrows) {
+    Future<int> future = MakeReadyFuture(1).Then([](int) -> int { throw std::runtime_error("oops"); });
+    ASSERT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(FutureTest, BrokenPromise) {
+    Future<int> future;
+    {
+        Promise<int> promise;
+        future = promise.GetFuture();
+    }
+    ASSERT_TRUE(future.Ready());
+    ASSERT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(FutureTest, MoveOnlyValue) {
+    Future<std::unique_ptr<int>> future =
+        MakeReadyFuture(std::unique_ptr<int>(new int(7))).Then([](std::unique_ptr<int> p) {
+            *p += 1;
+            return p;
+        });
+    ASSERT_EQ(8, *future.Get());
+}
+
+TEST(FutureTest, AsyncOnExecutor) {
+    Executor executor("test", 1, 2, 16, std::chrono::milliseconds(100));
+    std::thread::id caller = std::this_thread::get_id();
+    Future<bool> future = Async(executor, [](int a, int b) { return a + b; }, 2, 3).Then(executor, [caller](int v) {
+        return v == 5 && std::this_thread::get_id() != caller;
+    });
+    ASSERT_TRUE(future.Get());
+}
+
+TEST(FutureTest, AsyncRejected) {
+    Executor executor("test", 1, 1, 1, std::chrono::milliseconds(100));
+    executor.Stop(true);
+    Future<int> future = Async(executor, [] { return 1; });
+    ASSERT_TRUE(future.Ready());
+    ASSERT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(FutureTest, WhenAll) {
+    StealingExecutor executor("test", 2);
+    std::vector<Future<int>> futures;
+    for (int i = 0; i < 100; i++) {
+        futures.push_back(Async(executor, [](int v) { return v * v; }, i));
+    }
+    std::vector<int> squares = WhenAll(std::move(futures)).Get();
+    ASSERT_EQ(100, squares.size());
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(i * i, squares[i]);
+    }
+}
+
+TEST(FutureTest, WhenAllFails) {
+    std::vector<Future<int>> futures;
+    futures.push_back(MakeReadyFuture(1));
+    Promise<int> failing;
+    futures.push_back(failing.GetFuture());
+    Promise<int> late;
+    futures.push_back(late.GetFuture());
+
+    Future<std::vector<int>> all = WhenAll(std::move(futures));
+    failing.SetException(std::make_exception_ptr(std::invalid_argument("bad")));
+    ASSERT_TRUE(all.Ready());
+    late.SetValue(3);
+    ASSERT_THROW(all.Get(), std::invalid_argument);
+}
+
+TEST(FutureTest, WhenAllEmpty) { ASSERT_TRUE(WhenAll(std::vector<Future<int>>()).Get().empty()); }
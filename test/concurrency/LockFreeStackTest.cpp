@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/LockFreeStack.h>
+
+using namespace Afina::Concurrency;
+
+TEST(LockFreeStackTest, PushPop) {
+    LockFreeStack<int> stack;
+
+    int value;
+    EXPECT_FALSE(stack.Pop(value));
+
+    for (int i = 0; i < 100; i++) {
+        stack.Push(i);
+    }
+    for (int i = 99; i >= 0; i--) {
+        ASSERT_TRUE(stack.Pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(stack.Pop(value));
+}
+
+TEST(LockFreeStackTest, Concurrent) {
+    const int threads_count = 4;
+    const int per_thread = 100000;
+    LockFreeStack<int> stack;
+
+    // Each thread pushes its own values and pops whatever is on top, every value must be seen exactly once
+    std::vector<std::vector<int>> popped(threads_count);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; t++) {
+        threads.emplace_back([&stack, &popped, t, per_thread] {
+            int value;
+            for (int i = 0; i < per_thread; i++) {
+                stack.Push(t * per_thread + i);
+                if (i % 2 == 1) {
+                    while (!stack.Pop(value)) {
+                    }
+                    popped[t].push_back(value);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::vector<int> seen(threads_count * per_thread, 0);
+    int value;
+    while (stack.Pop(value)) {
+        seen[value]++;
+    }
+    for (auto &p : popped) {
+        for (int v : p) {
+            seen[v]++;
+        }
+    }
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(1, seen[i]) << "value " << i;
+    }
+}
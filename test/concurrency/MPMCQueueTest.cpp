@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/MPMCQueue.h>
+
+using namespace Afina::Concurrency;
+
+TEST(MPMCQueueTest, Bounded) {
+    MPMCQueue<int> queue(3);
+    EXPECT_EQ(4, queue.Capacity());
+
+    for (int i = 0; i < 4; i++) {
+        int v = i;
+        EXPECT_TRUE(queue.TryPush(std::move(v)));
+    }
+    int extra = 4;
+    EXPECT_FALSE(queue.TryPush(std::move(extra)));
+    EXPECT_EQ(4, queue.Size());
+
+    // FIFO, and room is reused lap after lap
+    int v;
+    for (int lap = 0; lap < 3; lap++) {
+        EXPECT_TRUE(queue.TryPop(v));
+        EXPECT_EQ(lap, v);
+        int next = lap + 4;
+        EXPECT_TRUE(queue.TryPush(std::move(next)));
+    }
+    for (int i = 3; i < 7; i++) {
+        EXPECT_TRUE(queue.TryPop(v));
+        EXPECT_EQ(i, v);
+    }
+    EXPECT_FALSE(queue.TryPop(v));
+}
+
+TEST(MPMCQueueTest, DestroysLeftovers) {
+    auto value = std::make_shared<int>(1);
+    {
+        MPMCQueue<std::shared_ptr<int>> queue(8);
+        std::shared_ptr<int> copy = value;
+        EXPECT_TRUE(queue.TryPush(std::move(copy)));
+        EXPECT_EQ(2, value.use_count());
+    }
+    EXPECT_EQ(1, value.use_count());
+}
+
+TEST(MPMCQueueTest, ManyProducersManyConsumers) {
+    const int producers = 3, consumers = 3, per_producer = 100000;
+    MPMCQueue<int> queue(64);
+    std::vector<std::atomic<int>> seen(producers * per_producer);
+    for (auto &s : seen) {
+        s.store(0);
+    }
+
+    std::atomic<int> popped(0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < per_producer; i++) {
+                int v = p * per_producer + i;
+                while (!queue.TryPush(std::move(v))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&] {
+            int v;
+            while (popped.load() < producers * per_producer) {
+                if (queue.TryPop(v)) {
+                    seen[v]++;
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(1, seen[i].load()) << "value " << i;
+    }
+}
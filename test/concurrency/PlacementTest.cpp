@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/concurrency/Placement.h>
+
+using namespace Afina::Concurrency;
+
+// Two nodes of two cores with two SMT threads each, siblings are numbered the way Linux does: n and n + 4
+static Topology TwoNodes() {
+    std::vector<CpuInfo> cpus;
+    for (int id = 0; id < 8; id++) {
+        int core = id % 4;
+        cpus.push_back(CpuInfo{id, core / 2, core / 2, core});
+    }
+    return Topology(cpus);
+}
+
+static std::vector<int> Order(const Placement &p, size_t count) {
+    std::vector<int> cpus;
+    for (size_t i = 0; i < count; i++) {
+        cpus.push_back(p.CpuFor(i));
+    }
+    return cpus;
+}
+
+TEST(PlacementTest, None) {
+    Placement p;
+    EXPECT_EQ(-1, p.CpuFor(0));
+    EXPECT_EQ(-1, p.NodeFor(0));
+    std::thread t([] {});
+    EXPECT_TRUE(p.Apply(t, 0));
+    t.join();
+}
+
+TEST(PlacementTest, Pin) {
+    Placement p(Placement::Mode::kPin, TwoNodes());
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 0}), Order(p, 9));
+}
+
+TEST(PlacementTest, Compact) {
+    Placement p(Placement::Mode::kCompact, TwoNodes());
+    EXPECT_EQ(std::vector<int>({0, 4, 1, 5, 2, 6, 3, 7}), Order(p, 8));
+    EXPECT_EQ(0, p.NodeFor(3));
+    EXPECT_EQ(1, p.NodeFor(4));
+}
+
+TEST(PlacementTest, Spread) {
+    Placement p(Placement::Mode::kSpread, TwoNodes());
+    EXPECT_EQ(std::vector<int>({0, 2, 1, 3, 4, 6, 5, 7}), Order(p, 8));
+    EXPECT_EQ(0, p.NodeFor(0));
+    EXPECT_EQ(1, p.NodeFor(1));
+}
+
+TEST(PlacementTest, ParseMode) {
+    EXPECT_EQ(Placement::Mode::kSpread, Placement::ParseMode("spread"));
+    EXPECT_EQ(Placement::Mode::kNone, Placement::ParseMode("none"));
+    EXPECT_THROW(Placement::ParseMode("everywhere"), std::invalid_argument);
+}
+
+static void Write(const std::string &path, const std::string &content) { std::ofstream(path) << content; }
+
+TEST(PlacementTest, DetectFromSysfs) {
+    char dir[] = "/tmp/afina_cpuXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    std::string root = dir;
+
+    Write(root + "/online", "0-1,3\n");
+    for (int id : {0, 1, 3}) {
+        std::string cpu = root + "/cpu" + std::to_string(id);
+        mkdir(cpu.c_str(), 0755);
+        mkdir((cpu + "/topology").c_str(), 0755);
+        mkdir((cpu + "/node" + std::to_string(id == 3 ? 1 : 0)).c_str(), 0755);
+        Write(cpu + "/topology/core_id", std::to_string(id / 2) + "\n");
+    }
+
+    // CPU 3 has no package, it is on package 0
+    Write(root + "/cpu0/topology/physical_package_id", "0\n");
+    Write(root + "/cpu1/topology/physical_package_id", "0\n");
+
+    Topology t = Topology::Detect(root, false);
+    ASSERT_EQ(3, t.Cpus().size());
+    EXPECT_EQ(3, t.Cpus()[2].id);
+    EXPECT_EQ(1, t.Cpus()[2].node);
+    EXPECT_EQ(1, t.Cpus()[2].core);
+    EXPECT_EQ(0, t.Cpus()[1].core);
+    EXPECT_EQ(2, t.Nodes());
+
+    std::system(("rm -rf " + root).c_str());
+}
+
+TEST(PlacementTest, DetectWithoutSysfs) {
+    // Every CPU the process may run on, each a core of its own
+    Topology t = Topology::Detect("/nonexistent");
+    ASSERT_FALSE(t.Cpus().empty());
+    EXPECT_EQ(1, t.Nodes());
+
+    Placement p(Placement::Mode::kSpread, t);
+    std::thread thread([] {});
+    EXPECT_TRUE(p.Apply(thread, 0));
+    thread.join();
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <afina/concurrency/Scheduler.h>
+
+using namespace Afina::Concurrency;
+
+using ms = std::chrono::milliseconds;
+
+static bool WaitFor(std::atomic<int> &value, int expected, ms timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (value.load() < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(ms(1));
+    }
+    return true;
+}
+
+TEST(SchedulerTest, ScheduleAfter) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point at;
+    ASSERT_NE(Scheduler::kNoTimer, scheduler.ScheduleAfter(ms(30), [&] {
+        at = std::chrono::steady_clock::now();
+        fired++;
+    }));
+    ASSERT_TRUE(WaitFor(fired, 1, ms(2000)));
+    ASSERT_GE(at - start, ms(30));
+    ASSERT_EQ(0, scheduler.Size());
+}
+
+TEST(SchedulerTest, FiresInOrder) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    std::atomic<bool> ordered(true);
+    // Delays cross the level 0 rotation, so some timers come down by the cascade
+    for (int i = 0; i < 20; i++) {
+        scheduler.ScheduleAfter(ms(10 * (20 - i)), [&fired, &ordered, i] {
+            if (fired.load() != 19 - i) {
+                ordered = false;
+            }
+            fired++;
+        });
+    }
+    ASSERT_EQ(20, scheduler.Size());
+    ASSERT_TRUE(WaitFor(fired, 20, ms(5000)));
+    ASSERT_TRUE(ordered.load());
+}
+
+TEST(SchedulerTest, Cancel) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    auto id = scheduler.ScheduleAfter(ms(50), [&fired] { fired += 100; });
+    scheduler.ScheduleAfter(ms(80), [&fired] { fired++; });
+    ASSERT_TRUE(scheduler.Cancel(id));
+    ASSERT_FALSE(scheduler.Cancel(id));
+    ASSERT_TRUE(WaitFor(fired, 1, ms(2000)));
+    ASSERT_EQ(1, fired.load());
+    ASSERT_FALSE(scheduler.Cancel(id));
+}
+
+TEST(SchedulerTest, StaleIdMisses) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    auto first = scheduler.ScheduleAfter(ms(1), [&fired] { fired++; });
+    ASSERT_TRUE(WaitFor(fired, 1, ms(2000)));
+
+    // Node is reused, but with other generation
+    auto second = scheduler.ScheduleAfter(ms(1000), [&fired] { fired++; });
+    ASSERT_NE(first, second);
+    ASSERT_FALSE(scheduler.Cancel(first));
+    ASSERT_TRUE(scheduler.Cancel(second));
+}
+
+TEST(SchedulerTest, ScheduleEvery) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    auto id = scheduler.ScheduleEvery(ms(5), [&fired] { fired++; });
+    ASSERT_TRUE(WaitFor(fired, 5, ms(2000)));
+    ASSERT_TRUE(scheduler.Cancel(id));
+    int after = fired.load();
+    std::this_thread::sleep_for(ms(30));
+    ASSERT_LE(fired.load(), after + 1);
+    ASSERT_EQ(0, scheduler.Size());
+    ASSERT_THROW(scheduler.ScheduleEvery(ms(0), [] {}), std::invalid_argument);
+}
+
+TEST(SchedulerTest, CancelFromOwnTask) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    std::atomic<Scheduler::TimerId> id(Scheduler::kNoTimer);
+    id = scheduler.ScheduleEvery(ms(2), [&] {
+        if (++fired == 3) {
+            scheduler.Cancel(id.load());
+        }
+    });
+    ASSERT_TRUE(WaitFor(fired, 3, ms(2000)));
+    std::this_thread::sleep_for(ms(20));
+    ASSERT_EQ(3, fired.load());
+}
+
+TEST(SchedulerTest, SurvivesThrowingTask) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    scheduler.ScheduleAfter(ms(1), [] { throw std::runtime_error("oops"); });
+    scheduler.ScheduleAfter(ms(5), [&fired] { fired++; });
+    ASSERT_TRUE(WaitFor(fired, 1, ms(2000)));
+}
+
+TEST(SchedulerTest, Stop) {
+    Scheduler scheduler("test");
+    std::atomic<int> fired(0);
+    scheduler.ScheduleAfter(ms(10000), [&fired] { fired++; });
+    scheduler.Stop();
+    ASSERT_EQ(Scheduler::kNoTimer, scheduler.ScheduleAfter(ms(1), [&fired] { fired++; }));
+    ASSERT_EQ(0, fired.load());
+}
+
+TEST(SchedulerTest, FarTimers) {
+    // 100 seconds of 1ms ticks are on level 2 of the wheel
+    Scheduler scheduler("test", ms(1));
+    std::atomic<int> fired(0);
+    for (int i = 0; i < 1000; i++) {
+        scheduler.ScheduleAfter(ms(100000 + i), [&fired] { fired++; });
+    }
+    scheduler.ScheduleAfter(ms(70), [&fired] { fired += 1000; });
+    ASSERT_EQ(1001, scheduler.Size());
+    ASSERT_TRUE(WaitFor(fired, 1000, ms(2000)));
+    ASSERT_EQ(1000, fired.load());
+    ASSERT_EQ(1000, scheduler.Size());
+}
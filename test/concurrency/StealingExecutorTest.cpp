@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/StealingExecutor.h>
+
+using namespace Afina::Concurrency;
+
+TEST(StealingExecutorTest, RunsTasks) {
+    std::atomic<int> sum(0);
+    StealingExecutor executor("test", 4);
+    for (int i = 1; i <= 1000; i++) {
+        ASSERT_TRUE(executor.Execute([&sum](int v) { sum += v; }, i));
+    }
+    executor.Stop(true);
+    EXPECT_EQ(StealingExecutor::State::kStopped, executor.GetState());
+    EXPECT_EQ(500500, sum.load());
+}
+
+// Each task spawns two smaller ones until depth runs out, so all of the work starts on a single worker
+static void Spawn(StealingExecutor &executor, std::atomic<int> &leaves, std::atomic<int> &threads_seen,
+                  std::vector<std::atomic<bool>> &seen, int depth) {
+    if (depth == 0) {
+        leaves++;
+        return;
+    }
+    size_t id = std::hash<std::thread::id>()(std::this_thread::get_id()) % seen.size();
+    if (!seen[id].exchange(true)) {
+        threads_seen++;
+    }
+    for (int i = 0; i < 2; i++) {
+        executor.Execute([&executor, &leaves, &threads_seen, &seen, depth] {
+            Spawn(executor, leaves, threads_seen, seen, depth - 1);
+        });
+    }
+}
+
+TEST(StealingExecutorTest, NestedTasks) {
+    StealingExecutor executor("test", 4);
+    std::atomic<int> leaves(0), threads_seen(0);
+    std::vector<std::atomic<bool>> seen(1024);
+    for (auto &s : seen) {
+        s.store(false);
+    }
+
+    EXPECT_TRUE(executor.Execute([&] { Spawn(executor, leaves, threads_seen, seen, 14); }));
+
+    // Tasks spawned after Stop would be rejected, so the whole tree is awaited first
+    while (leaves.load() != (1 << 14)) {
+        std::this_thread::yield();
+    }
+    executor.Stop(true);
+    EXPECT_EQ(1 << 14, leaves.load());
+    EXPECT_LE(1, threads_seen.load());
+}
+
+TEST(StealingExecutorTest, StopCompletesQueued) {
+    StealingExecutor executor("test", 2);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    auto wait = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return open; });
+    };
+
+    std::atomic<int> done(0);
+    EXPECT_TRUE(executor.Execute(wait));
+    EXPECT_TRUE(executor.Execute(wait));
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(executor.Execute([&done] { done++; }));
+    }
+
+    // No new tasks once stopping, queued ones are still run
+    executor.Stop();
+    EXPECT_FALSE(executor.Execute([&done] { done++; }));
+    EXPECT_EQ(StealingExecutor::State::kStopping, executor.GetState());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cv.notify_all();
+    }
+    executor.Stop(true);
+    EXPECT_EQ(100, done.load());
+    EXPECT_EQ(StealingExecutor::State::kStopped, executor.GetState());
+}
+
+TEST(StealingExecutorTest, SurvivesThrowingTask) {
+    StealingExecutor executor("test", 1);
+
+    std::atomic<bool> ran(false);
+    EXPECT_TRUE(executor.Execute([] { throw std::runtime_error("task failed"); }));
+    EXPECT_TRUE(executor.Execute([&ran] { ran = true; }));
+    executor.Stop(true);
+    EXPECT_TRUE(ran.load());
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include <array>
+#include <memory>
+#include <utility>
+
+#include <afina/concurrency/Task.h>
+
+using namespace Afina::Concurrency;
+
+TEST(TaskTest, InlineCallable) {
+    int calls = 0;
+    std::array<char, 32> payload;
+    payload.fill('x');
+    auto func = [&calls, payload] { calls += payload[0] == 'x'; };
+    static_assert(Task::fits_inline<decltype(func)>::value, "Small lambda is stored inline");
+
+    Task task(func);
+    EXPECT_TRUE(bool(task));
+    task();
+    EXPECT_EQ(1, calls);
+
+    // Moved from task is empty
+    Task moved(std::move(task));
+    EXPECT_FALSE(bool(task));
+    moved();
+    EXPECT_EQ(2, calls);
+}
+
+TEST(TaskTest, HeapCallable) {
+    int calls = 0;
+    std::array<char, 256> payload;
+    payload.fill('y');
+    auto func = [&calls, payload] { calls += payload[255] == 'y'; };
+    static_assert(!Task::fits_inline<decltype(func)>::value, "Big lambda goes to the heap");
+
+    Task task(func);
+    Task other;
+    other = std::move(task);
+    other();
+    EXPECT_EQ(1, calls);
+}
+
+TEST(TaskTest, MoveOnlyCaptureIsDestroyed) {
+    auto counter = std::make_shared<int>(0);
+    std::weak_ptr<int> watch = counter;
+    {
+        std::unique_ptr<std::shared_ptr<int>> owned(new std::shared_ptr<int>(std::move(counter)));
+        struct holder {
+            std::unique_ptr<std::shared_ptr<int>> owned;
+            void operator()() { (**owned)++; }
+        };
+        Task task(holder{std::move(owned)});
+        task();
+        EXPECT_EQ(1, *watch.lock());
+
+        Task moved(std::move(task));
+        moved = nullptr;
+        EXPECT_TRUE(watch.expired());
+    }
+}
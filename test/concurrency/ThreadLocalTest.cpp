@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using namespace Afina::Concurrency;
+
+// Counts live instances
+struct counted {
+    counted(std::atomic<int> &live) : live(live), value(0) { live++; }
+    ~counted() { live--; }
+
+    std::atomic<int> &live;
+    int value;
+};
+
+TEST(ThreadLocalTest, InstancePerThread) {
+    std::atomic<int> live(0);
+    ThreadLocal<counted> tl([&live] { return new counted(live); });
+
+    tl.Get().value = 1;
+    EXPECT_EQ(1, live.load());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&tl, i] {
+            EXPECT_EQ(0, tl.Get().value);
+            tl.Get().value = i + 10;
+            EXPECT_EQ(i + 10, tl.Get().value);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // Instances of exited threads are gone
+    EXPECT_EQ(1, live.load());
+    EXPECT_EQ(1u, tl.Size());
+    EXPECT_EQ(1, tl.Get().value);
+}
+
+TEST(ThreadLocalTest, DestroysRemainingInstances) {
+    std::atomic<int> live(0);
+    {
+        ThreadLocal<counted> a([&live] { return new counted(live); });
+        ThreadLocal<counted> b([&live] { return new counted(live); });
+        a.Get().value = 1;
+        b.Get().value = 2;
+        EXPECT_EQ(1, a.Get().value);
+        EXPECT_EQ(2, b.Get().value);
+        EXPECT_EQ(2, live.load());
+    }
+    EXPECT_EQ(0, live.load());
+}
@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/WorkStealingDeque.h>
+
+using namespace Afina::Concurrency;
+
+TEST(WorkStealingDequeTest, OwnerLifoThiefFifo) {
+    WorkStealingDeque<int> deque(2);
+    int items[5] = {0, 1, 2, 3, 4};
+    for (int &i : items) {
+        deque.Push(&i);
+    }
+    EXPECT_EQ(5, deque.Size());
+
+    EXPECT_EQ(&items[4], deque.Pop());
+    EXPECT_EQ(&items[0], deque.Steal());
+    EXPECT_EQ(&items[3], deque.Pop());
+    EXPECT_EQ(&items[1], deque.Steal());
+    EXPECT_EQ(&items[2], deque.Pop());
+    EXPECT_EQ(nullptr, deque.Pop());
+    EXPECT_EQ(nullptr, deque.Steal());
+    EXPECT_EQ(0, deque.Size());
+}
+
+TEST(WorkStealingDequeTest, EachItemTakenOnce) {
+    const int count = 200000;
+    std::vector<int> items(count);
+    std::vector<std::atomic<int>> taken(count);
+    for (auto &t : taken) {
+        t.store(0);
+    }
+
+    WorkStealingDeque<int> deque;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; i++) {
+        thieves.emplace_back([&] {
+            while (!done.load() || deque.Size() != 0) {
+                int *item = deque.Steal();
+                if (item != nullptr) {
+                    taken[item - items.data()]++;
+                }
+            }
+        });
+    }
+
+    // Owner pushes and pops in turns, so that it races with thieves for the last items too
+    for (int i = 0; i < count; i++) {
+        deque.Push(&items[i]);
+        if (i % 3 == 0) {
+            int *item = deque.Pop();
+            if (item != nullptr) {
+                taken[item - items.data()]++;
+            }
+        }
+    }
+    int *item;
+    while ((item = deque.Pop()) != nullptr) {
+        taken[item - items.data()]++;
+    }
+    done.store(true);
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(1, taken[i].load()) << "item " << i;
+    }
+}
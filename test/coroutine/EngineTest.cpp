@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -62,3 +64,205 @@ TEST(CoroutineTest, Printer) {
     engine.start(_printer, engine, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+void _counter(Afina::Coroutine::Engine &pe, std::stringstream &out, char name) {
+    for (int i = 0; i < 3; i++) {
+        out << name;
+        pe.yield();
+    }
+}
+
+// Routines share only what is off their stacks: the stack of suspended one is not where it was
+void _yielder(Afina::Coroutine::Engine &pe, std::stringstream &out) {
+    pe.run(_counter, pe, out, 'a');
+    pe.run(_counter, pe, out, 'b');
+
+    // Main routine yields as well until the others are done
+    for (int i = 0; i < 4; i++) {
+        pe.yield();
+    }
+    out << "END";
+}
+
+TEST(CoroutineTest, Yield) {
+    Afina::Coroutine::Engine engine;
+
+    std::stringstream out;
+    engine.start(_yielder, engine, out);
+    std::string result = out.str();
+    ASSERT_EQ("END", result.substr(6));
+    ASSERT_EQ(3, std::count(result.begin(), result.end(), 'a'));
+    ASSERT_EQ(3, std::count(result.begin(), result.end(), 'b'));
+}
+
+void _sleeper(Afina::Coroutine::Engine &pe, std::stringstream &out) {
+    out << "S1 ";
+    pe.block();
+    out << "S2 ";
+}
+
+void _waker(Afina::Coroutine::Engine &pe, std::stringstream &out, void *&sleeper) {
+    out << "W1 ";
+    pe.yield();
+    out << "W2 ";
+    pe.unblock(sleeper);
+}
+
+void _blocker(Afina::Coroutine::Engine &pe, std::stringstream &out, void *&sleeper) {
+    sleeper = pe.run(_sleeper, pe, out);
+    pe.run(_waker, pe, out, sleeper);
+
+    pe.sched(sleeper);
+    for (int i = 0; i < 4; i++) {
+        pe.yield();
+    }
+}
+
+TEST(CoroutineTest, BlockUnblock) {
+    Afina::Coroutine::Engine engine;
+
+    std::stringstream out;
+    void *sleeper = nullptr;
+    engine.start(_blocker, engine, out, sleeper);
+    ASSERT_EQ("S1 W1 W2 S2 ", out.str());
+}
+
+// Goes depth frames of 4K deep and switches from the bottom, so each switch copies the whole stack
+int _deep(Afina::Coroutine::Engine &pe, void *&other, int depth) {
+    char frame[4096];
+    memset(frame, depth, sizeof(frame));
+    if (depth > 0) {
+        return _deep(pe, other, depth - 1) + frame[depth];
+    }
+    pe.sched(other);
+    return frame[0];
+}
+
+void _diver(Afina::Coroutine::Engine &pe, void *&other, int depth, int &result) { result = _deep(pe, other, depth); }
+
+void _divers(Afina::Coroutine::Engine &pe, void *&pa, void *&pb, int &a, int &b) {
+    pa = pe.run(_diver, pe, pb, 32, a);
+    pb = pe.run(_diver, pe, pa, 8, b);
+    pe.sched(pa);
+    pe.yield();
+    pe.yield();
+}
+
+TEST(CoroutineTest, DeepStacks) {
+    Afina::Coroutine::Engine engine;
+
+    void *pa = nullptr, *pb = nullptr;
+    int a = 0, b = 0;
+    engine.start(_divers, engine, pa, pb, a, b);
+    ASSERT_EQ(32 * 33 / 2, a);
+    ASSERT_EQ(8 * 9 / 2, b);
+}
+
+void _noop(int &done) { done++; }
+
+void _spawner(Afina::Coroutine::Engine &pe, int &done) {
+    // Finished routines give their contexts and stack buffers to the next ones
+    for (int i = 0; i < 1000; i++) {
+        void *routine = pe.run(_noop, done);
+        pe.sched(routine);
+    }
+}
+
+TEST(CoroutineTest, ManyRoutines) {
+    Afina::Coroutine::Engine engine;
+
+    int done = 0;
+    engine.start(_spawner, engine, done);
+    ASSERT_EQ(1000, done);
+}
+
+TEST(CoroutineTest, SeparateSimpleStart) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    int result;
+    engine.start(_calculator_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+TEST(CoroutineTest, SeparateBlockUnblock) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    std::stringstream out;
+    void *sleeper = nullptr;
+    engine.start(_blocker, engine, out, sleeper);
+    ASSERT_EQ("S1 W1 W2 S2 ", out.str());
+}
+
+TEST(CoroutineTest, SeparateDeepStacks) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    void *pa = nullptr, *pb = nullptr;
+    int a = 0, b = 0;
+    engine.start(_divers, engine, pa, pb, a, b);
+    ASSERT_EQ(32 * 33 / 2, a);
+    ASSERT_EQ(8 * 9 / 2, b);
+}
+
+TEST(CoroutineTest, SeparateManyRoutines) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    int done = 0;
+    engine.start(_spawner, engine, done);
+    ASSERT_EQ(1000, done);
+}
+
+void _reader(Afina::Coroutine::Engine &pe, int *&shared, int &sum) {
+    while (shared != nullptr) {
+        sum += *shared;
+        pe.yield();
+    }
+}
+
+// With stacks of their own routines may point to each other's locals
+void _writer(Afina::Coroutine::Engine &pe, int *&shared, int &sum) {
+    int value = 0;
+    shared = &value;
+    pe.run(_reader, pe, shared, sum);
+    for (value = 1; value <= 10; value++) {
+        pe.yield();
+    }
+    shared = nullptr;
+    pe.yield();
+}
+
+TEST(CoroutineTest, SeparateSharedLocals) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    int *shared = nullptr;
+    int sum = 0;
+    engine.start(_writer, engine, shared, sum);
+    ASSERT_EQ(10 * 11 / 2, sum);
+}
+
+void _ticker(Afina::Coroutine::Engine &pe, int &ticks) {
+    for (int i = 0; i < 10; i++) {
+        ticks++;
+        pe.yield();
+    }
+}
+
+void _crowd(Afina::Coroutine::Engine &pe, int &ticks) {
+    for (int i = 0; i < 1000; i++) {
+        pe.run(_ticker, pe, ticks);
+    }
+}
+
+TEST(CoroutineTest, SeparateManyAlive) {
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::Mode::kSeparateStack);
+
+    int ticks = 0;
+    engine.start(_crowd, engine, ticks);
+    ASSERT_EQ(10 * 1000, ticks);
+}
+
+TEST(CoroutineTest, ParseMode) {
+    ASSERT_EQ(Afina::Coroutine::Engine::Mode::kCopyStack, Afina::Coroutine::Engine::ParseMode("copy"));
+    ASSERT_EQ(Afina::Coroutine::Engine::Mode::kSeparateStack, Afina::Coroutine::Engine::ParseMode("separate"));
+    ASSERT_THROW(Afina::Coroutine::Engine::ParseMode("bogus"), std::invalid_argument);
+}
@@ -0,0 +1,242 @@
+#include "gtest/gtest.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Poller.h>
+
+using Afina::Coroutine::Engine;
+using Afina::Coroutine::Poller;
+
+namespace {
+
+const Engine::Mode kModes[] = {Engine::Mode::kCopyStack, Engine::Mode::kSeparateStack};
+
+// Pair of connected non-blocking sockets
+struct SocketPair {
+    SocketPair() { EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds)); }
+    ~SocketPair() {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    int fds[2];
+};
+
+} // namespace
+
+void _receiver(Poller &poller, int fd, std::string &received) {
+    char buf[16];
+    ssize_t n = poller.Read(fd, buf, sizeof(buf));
+    if (n > 0) {
+        received.assign(buf, n);
+    }
+}
+
+void _sender(Engine &engine, Poller &poller, int fd, std::string &log) {
+    // Receiver gets control first and has to wait for the data
+    engine.yield();
+    log += "send ";
+    poller.Write(fd, "ping", 4);
+}
+
+void _pinger(Engine &engine, Poller &poller, SocketPair &pair, std::string &received, std::string &log) {
+    engine.run(_receiver, poller, int(pair.fds[0]), received);
+    engine.run(_sender, engine, poller, int(pair.fds[1]), log);
+}
+
+TEST(PollerTest, ReadWaitsForData) {
+    for (Engine::Mode mode : kModes) {
+        Engine engine(mode);
+        Poller poller(engine);
+        SocketPair pair;
+
+        std::string received, log;
+        engine.start(_pinger, engine, poller, pair, received, log);
+        ASSERT_EQ("ping", received);
+        ASSERT_EQ("send ", log);
+        ASSERT_EQ(0u, poller.Waiting());
+    }
+}
+
+void _drain(Poller &poller, int fd, std::size_t &total) {
+    char buf[4096];
+    ssize_t n;
+    while ((n = poller.Read(fd, buf, sizeof(buf))) > 0) {
+        total += n;
+    }
+}
+
+void _flood(Poller &poller, int fd, std::size_t size) {
+    std::vector<char> data(size, 'x');
+    std::size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = poller.Write(fd, data.data() + sent, size - sent);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    shutdown(fd, SHUT_WR);
+}
+
+void _streamer(Engine &engine, Poller &poller, SocketPair &pair, std::size_t &total) {
+    // Way more than socket buffers: writer waits for the reader again and again
+    engine.run(_flood, poller, int(pair.fds[1]), std::size_t(8 * 1024 * 1024));
+    engine.run(_drain, poller, int(pair.fds[0]), total);
+}
+
+TEST(PollerTest, WriteWaitsForSpace) {
+    for (Engine::Mode mode : kModes) {
+        Engine engine(mode);
+        Poller poller(engine);
+        SocketPair pair;
+
+        std::size_t total = 0;
+        engine.start(_streamer, engine, poller, pair, total);
+        ASSERT_EQ(std::size_t(8 * 1024 * 1024), total);
+    }
+}
+
+void _acceptor(Poller &poller, int fd, int &accepted) {
+    accepted = poller.Accept(fd, nullptr, nullptr);
+    if (accepted >= 0) {
+        ASSERT_NE(0, fcntl(accepted, F_GETFL) & O_NONBLOCK);
+    }
+}
+
+TEST(PollerTest, AcceptWaitsForClient) {
+    for (Engine::Mode mode : kModes) {
+        int server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        ASSERT_NE(-1, server);
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(0, bind(server, (struct sockaddr *)&addr, sizeof(addr)));
+        ASSERT_EQ(0, listen(server, 1));
+        ASSERT_EQ(0, getsockname(server, (struct sockaddr *)&addr, &len));
+
+        // Client comes when the engine sleeps in epoll already
+        std::thread client([&addr] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+            close(fd);
+        });
+
+        Engine engine(mode);
+        Poller poller(engine);
+        int accepted = -1;
+        engine.start(_acceptor, poller, int(server), accepted);
+        client.join();
+
+        ASSERT_NE(-1, accepted);
+        close(accepted);
+        close(server);
+    }
+}
+
+void _stuck(Poller &poller, int fd, int &error) {
+    char buf[16];
+    if (poller.Read(fd, buf, sizeof(buf)) == -1) {
+        error = errno;
+    }
+}
+
+void _stopper(Engine &engine, Poller &poller) {
+    engine.yield();
+    poller.Shutdown();
+}
+
+void _canceller(Engine &engine, Poller &poller, SocketPair &pair, int &first, int &second) {
+    engine.run(_stuck, poller, int(pair.fds[0]), first);
+    engine.run(_stuck, poller, int(pair.fds[1]), second);
+    engine.run(_stopper, engine, poller);
+}
+
+TEST(PollerTest, ShutdownCancelsWaits) {
+    for (Engine::Mode mode : kModes) {
+        Engine engine(mode);
+        Poller poller(engine);
+        SocketPair pair;
+
+        int first = 0, second = 0;
+        engine.start(_canceller, engine, poller, pair, first, second);
+        ASSERT_EQ(ECANCELED, first);
+        ASSERT_EQ(ECANCELED, second);
+
+        // Waits after the shutdown fail right away
+        ASSERT_FALSE(poller.Wait(pair.fds[0], 0));
+        ASSERT_EQ(ECANCELED, errno);
+    }
+}
+
+TEST(PollerTest, WaitOutsideOfRoutine) {
+    Engine engine;
+    Poller poller(engine);
+    SocketPair pair;
+
+    ASSERT_FALSE(poller.Wait(pair.fds[0], 0));
+    ASSERT_EQ(EINVAL, errno);
+}
+
+void _sleeper(Poller &poller, int ms, std::string &log) {
+    poller.Sleep(std::chrono::milliseconds(ms));
+    log += std::to_string(ms) + " ";
+}
+
+void _sleepers(Engine &engine, Poller &poller, std::string &log) {
+    engine.run(_sleeper, poller, 40, log);
+    engine.run(_sleeper, poller, 10, log);
+}
+
+TEST(PollerTest, SleepWakesInOrder) {
+    for (Engine::Mode mode : kModes) {
+        Engine engine(mode);
+        Poller poller(engine);
+
+        std::string log;
+        auto start = std::chrono::steady_clock::now();
+        engine.start(_sleepers, engine, poller, log);
+        ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+        ASSERT_EQ("10 40 ", log);
+        ASSERT_EQ(0u, poller.Waiting());
+    }
+}
+
+void _dozer(Poller &poller, int &error) {
+    if (!poller.Sleep(std::chrono::milliseconds(60000))) {
+        error = errno;
+    }
+}
+
+void _waker(Engine &engine, Poller &poller, int &error) {
+    engine.run(_dozer, poller, error);
+    engine.run(_stopper, engine, poller);
+}
+
+TEST(PollerTest, ShutdownCancelsSleep) {
+    for (Engine::Mode mode : kModes) {
+        Engine engine(mode);
+        Poller poller(engine);
+
+        int error = 0;
+        auto start = std::chrono::steady_clock::now();
+        engine.start(_waker, engine, poller, error);
+        ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10000));
+        ASSERT_EQ(ECANCELED, error);
+    }
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+namespace {
+
+// Port nobody listens on right now
+uint16_t FreePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr *)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// Blocking client socket with a receive timeout, connected to the port
+int Connect(int fd, uint16_t port) {
+    struct timeval tv;
+    tv.tv_sec = 2;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+std::string Request(int fd, const std::string &request) {
+    if (send(fd, request.data(), request.size(), 0) != ssize_t(request.size())) {
+        return "";
+    }
+    char buf[256];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    return n > 0 ? std::string(buf, n) : "";
+}
+
+std::shared_ptr<Logging::Service> MakeLogging() {
+    std::shared_ptr<Logging::Config> config(new Logging::Config);
+    Logging::Appender &console = config->appenders["console"];
+    console.type = Logging::Appender::Type::STDERR;
+    console.color = false;
+
+    Logging::Logger &logger = config->loggers["root"];
+    logger.level = Logging::Logger::Level::WARNING;
+    logger.appenders.push_back("console");
+    logger.format = "[%n] [%l] %v";
+    return std::make_shared<Logging::ServiceImpl>(config);
+}
+
+} // namespace
+
+// Accept keeps failing with EMFILE: acceptor must back off instead of spinning, so that connections being
+// served and the stop still get their turn
+TEST(STcoroutineTest, AcceptBacksOffWhenOutOfDescriptors) {
+    auto logging = MakeLogging();
+    logging->Start();
+    for (auto mode : {Coroutine::Engine::Mode::kCopyStack, Coroutine::Engine::Mode::kSeparateStack}) {
+        auto storage = std::make_shared<Backend::SimpleLRU>();
+        auto server = std::make_shared<Network::STcoroutine::ServerImpl>(storage, logging, mode);
+
+        uint16_t port = FreePort();
+        server->Start(port, 1, 1);
+
+        int served = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_EQ(0, Connect(served, port));
+        ASSERT_EQ("STORED\r\n", Request(served, "set foo 0 0 3\r\nbar\r\n"));
+
+        // No descriptors left for the server: the next connection fails to be accepted
+        int rejected = socket(AF_INET, SOCK_STREAM, 0);
+        int lowest = dup(0);
+        close(lowest);
+        struct rlimit saved;
+        ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &saved));
+        struct rlimit limited = saved;
+        limited.rlim_cur = rlim_t(lowest);
+        ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limited));
+
+        ASSERT_EQ(0, Connect(rejected, port));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::string response = Request(served, "get foo\r\n");
+
+        server->Stop();
+        auto joined = std::async(std::launch::async, [&server] { server->Join(); });
+        bool stopped = joined.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+
+        // Let the server have its descriptors back before checking, whatever happened it finishes then
+        ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &saved));
+        joined.wait();
+        close(rejected);
+        close(served);
+
+        EXPECT_EQ("VALUE foo 0 3\r\nbar\r\nEND\r\n", response);
+        EXPECT_TRUE(stopped);
+    }
+    logging->Stop();
+}
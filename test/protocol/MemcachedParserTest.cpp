@@ -4,6 +4,7 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
@@ -98,3 +99,49 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+TEST(MemcachedParserTest, Gets) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("gets foo bar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(14, consumed);
+    ASSERT_EQ("gets", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(2, tmp->keys().size());
+    ASSERT_TRUE(tmp->with_cas());
+}
+
+TEST(MemcachedParserTest, Cas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("cas foo 5 3600 6 18446744073709551615\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(39, consumed);
+    ASSERT_EQ("cas", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+
+    Execute::Cas *tmp = reinterpret_cast<Execute::Cas *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(5, tmp->flags());
+    ASSERT_EQ(3600, tmp->expire());
+    ASSERT_EQ(18446744073709551615ULL, tmp->cas());
+}
+
+TEST(MemcachedParserTest, ExpireTimeOverflow) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_THROW(parser.Parse("set foo 0 99999999999 6\r\n", consumed), std::runtime_error);
+}
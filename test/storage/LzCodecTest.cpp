@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "storage/LzCodec.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+static void RoundTrip(const std::string &data) {
+    std::string packed, unpacked;
+    if (LzCodec::Compress(data, packed)) {
+        EXPECT_LT(packed.size(), data.size());
+        LzCodec::Decompress(packed, unpacked);
+        EXPECT_EQ(data, unpacked);
+    }
+}
+
+TEST(LzCodecTest, RepetitiveData) {
+    std::string data;
+    for (int i = 0; i < 1000; i++) {
+        data += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\",\"active\":true}";
+    }
+
+    std::string packed, unpacked;
+    ASSERT_TRUE(LzCodec::Compress(data, packed));
+    EXPECT_LT(packed.size() * 4, data.size());
+    LzCodec::Decompress(packed, unpacked);
+    EXPECT_EQ(data, unpacked);
+
+    // Long runs hit overlapping matches and long length encoding
+    RoundTrip(std::string(100000, 'a'));
+    RoundTrip(std::string(15, 'a') + std::string(300, 'b') + std::string(19, 'c'));
+}
+
+TEST(LzCodecTest, RandomData) {
+    std::mt19937 rnd(1);
+    for (size_t size : {0, 3, 4, 17, 255, 4096, 70000}) {
+        std::string data;
+        for (size_t i = 0; i < size; i++) {
+            data.push_back(char(rnd()));
+        }
+        RoundTrip(data);
+
+        // Small alphabet compresses a bit, matches are short and scattered
+        for (auto &c : data) {
+            c = 'a' + c % 4;
+        }
+        RoundTrip(data);
+    }
+
+    std::string packed;
+    EXPECT_FALSE(LzCodec::Compress("abc", packed));
+}
+
+TEST(LzCodecTest, CorruptedInput) {
+    std::string packed, unpacked;
+    ASSERT_TRUE(LzCodec::Compress(std::string(1000, 'x'), packed));
+
+    EXPECT_THROW(LzCodec::Decompress(packed.substr(0, packed.size() - 1), unpacked), std::runtime_error);
+    EXPECT_THROW(LzCodec::Decompress("ab", unpacked), std::runtime_error);
+
+    // Match pointing before the start of the output: 8 bytes of raw data, one literal, then match at offset 5
+    std::string bad("\x08\x00\x00\x00\x10" "a" "\x05\x00" "\x00", 9);
+    EXPECT_THROW(LzCodec::Decompress(bad, unpacked), std::runtime_error);
+
+    // Same block with offset 1 is valid run of five bytes
+    bad[0] = '\x05';
+    bad[6] = '\x01';
+    LzCodec::Decompress(bad, unpacked);
+    EXPECT_EQ("aaaaa", unpacked);
+}
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/NamespacedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+static std::string Key(const std::string &ns, int i) {
+    std::string key = ns + ":key" + std::to_string(i);
+    key.resize(10, ' ');
+    return key;
+}
+
+TEST(NamespacedLRUTest, RoutesByPrefix) {
+    NamespacedLRU storage(1000, {{"a", 300}, {"b", 300}});
+
+    EXPECT_TRUE(storage.Put("a:1", "val"));
+    EXPECT_TRUE(storage.Put("b:1", "val"));
+    EXPECT_TRUE(storage.Put("c:1", "val"));
+    EXPECT_TRUE(storage.Put("plain", "val"));
+
+    EXPECT_EQ(6, storage.Usage("a"));
+    EXPECT_EQ(6, storage.Usage("b"));
+    EXPECT_EQ(14, storage.Usage(""));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("a:1", value));
+    EXPECT_TRUE(storage.Delete("a:1"));
+    EXPECT_FALSE(storage.Get("a:1", value));
+    EXPECT_EQ(0, storage.Usage("a"));
+}
+
+TEST(NamespacedLRUTest, BulkWritesDontEvictOthers) {
+    // Items are 20 bytes each
+    NamespacedLRU storage(1000, {{"a", 400}, {"b", 400}});
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put(Key("a", i), std::string(10, 'a')));
+    }
+
+    // Bulk load into b uses all the free space, but must stop at a's quota
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put(Key("b", i), std::string(10, 'b')));
+    }
+
+    std::string value;
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Get(Key("a", i), value));
+    }
+    EXPECT_EQ(200, storage.Usage("a"));
+    EXPECT_EQ(800, storage.Usage("b"));
+}
+
+TEST(NamespacedLRUTest, FairEviction) {
+    NamespacedLRU storage(1000, {{"a", 400}, {"b", 400}});
+
+    // b borrows the whole free space
+    for (int i = 0; i < 50; i++) {
+        EXPECT_TRUE(storage.Put(Key("b", i), std::string(10, 'b')));
+    }
+    EXPECT_EQ(1000, storage.Usage("b"));
+
+    // a gets its quota back from b
+    for (int i = 0; i < 20; i++) {
+        EXPECT_TRUE(storage.Put(Key("a", i), std::string(10, 'a')));
+    }
+    EXPECT_EQ(400, storage.Usage("a"));
+    EXPECT_EQ(600, storage.Usage("b"));
+
+    // Once both are over their quotas the one with the largest overdraft pays
+    for (int i = 20; i < 25; i++) {
+        EXPECT_TRUE(storage.Put(Key("a", i), std::string(10, 'a')));
+    }
+    EXPECT_EQ(500, storage.Usage("a"));
+    EXPECT_EQ(500, storage.Usage("b"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get(Key("b", 0), value));
+    EXPECT_TRUE(storage.Get(Key("b", 49), value));
+    EXPECT_TRUE(storage.Get(Key("a", 0), value));
+}
+
+TEST(NamespacedLRUTest, QuotasOverflow) {
+    EXPECT_THROW(NamespacedLRU(100, {{"a", 60}, {"b", 60}}), std::runtime_error);
+    EXPECT_THROW(NamespacedLRU(100, {{"a:b", 10}}), std::runtime_error);
+}
+
+TEST(NamespacedLRUTest, Stats) {
+    NamespacedLRU storage(1000, {{"a", 300}, {"b", 300}});
+    EXPECT_TRUE(storage.Put(Key("a", 1), "value"));
+    EXPECT_TRUE(storage.Put(Key("a", 2), "value"));
+    EXPECT_TRUE(storage.Put(Key("c", 1), "value"));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> map(stats.begin(), stats.end());
+    EXPECT_EQ("3", map["curr_items"]);
+    EXPECT_EQ(std::to_string(3 * 15), map["bytes"]);
+    EXPECT_EQ("1000", map["limit_maxbytes"]);
+    EXPECT_EQ(std::to_string(storage.Usage("a")), map["namespace:a:bytes"]);
+    EXPECT_EQ("300", map["namespace:b:quota"]);
+    EXPECT_EQ("0", map["namespace:b:bytes"]);
+}
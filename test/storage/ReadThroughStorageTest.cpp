@@ -0,0 +1,202 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "storage/Loader.h"
+#include "storage/ReadThroughStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+// Stand-in loader process: knows every key starting with "db_" and answers with "<key>@<request number>", flags
+// are the length of the key
+static std::unique_ptr<Loader> StartFakeLoader() {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+        return nullptr;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        std::string input;
+        char buf[4096];
+        int requests = 0;
+        ssize_t n;
+        while ((n = read(sv[1], buf, sizeof(buf))) > 0) {
+            input.append(buf, n);
+
+            size_t eol;
+            while ((eol = input.find("\r\n")) != std::string::npos) {
+                std::istringstream line(input.substr(0, eol));
+                input.erase(0, eol + 2);
+                requests++;
+
+                std::string cmd, key, out;
+                line >> cmd;
+                while (line >> key) {
+                    if (key.compare(0, 3, "db_") == 0) {
+                        std::string value = key + "@" + std::to_string(requests);
+                        out += "VALUE " + key + " " + std::to_string(key.size()) + " " +
+                               std::to_string(value.size()) + "\r\n" + value + "\r\n";
+                    }
+                }
+                out += "END\r\n";
+                if (write(sv[1], out.data(), out.size()) != (ssize_t)out.size()) {
+                    _exit(1);
+                }
+            }
+        }
+        _exit(0);
+    }
+
+    close(sv[1]);
+    return std::unique_ptr<Loader>(new Loader(sv[0], pid));
+}
+
+TEST(ReadThroughStorageTest, BackfillOnMiss) {
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(1024);
+    ReadThroughStorage storage(backend, StartFakeLoader());
+    storage.Start();
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("db_1", value));
+    EXPECT_EQ("db_1@1", value);
+
+    // Loaded value lives in the backend now
+    EXPECT_TRUE(backend->Get("db_1", value));
+    EXPECT_TRUE(storage.Get("db_1", value));
+    EXPECT_EQ("db_1@1", value);
+
+    EXPECT_FALSE(storage.Get("unknown", value));
+
+    EXPECT_TRUE(storage.Put("db_2", "local"));
+    EXPECT_TRUE(storage.Get("db_2", value));
+    EXPECT_EQ("local", value);
+
+    storage.Stop();
+}
+
+TEST(ReadThroughStorageTest, KeepsLoadedFlags) {
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(1024);
+    ReadThroughStorage storage(backend, StartFakeLoader());
+    storage.Start();
+
+    std::string value;
+    Afina::ItemHeader header;
+    EXPECT_TRUE(storage.Get("db_1", value, header));
+    EXPECT_EQ(4, header.flags);
+    EXPECT_TRUE(backend->Get("db_1", value, header));
+    EXPECT_EQ(4, header.flags);
+    storage.Stop();
+}
+
+TEST(ReadThroughStorageTest, KeepsFlagsOfItemBackendCannotHold) {
+    // Loaded item doesn't fit, reader is served right from the load
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(8);
+    ReadThroughStorage storage(backend, StartFakeLoader());
+    storage.Start();
+
+    std::string value;
+    Afina::ItemHeader header;
+    EXPECT_TRUE(storage.Get("db_123", value, header));
+    EXPECT_EQ("db_123@1", value);
+    EXPECT_EQ(6, header.flags);
+    EXPECT_FALSE(backend->Get("db_123", value));
+    storage.Stop();
+}
+
+TEST(ReadThroughStorageTest, BatchesConcurrentMisses) {
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(4096);
+    ReadThroughStorage storage(backend, StartFakeLoader(), 64, ReadThroughStorage::duration(50),
+                               ReadThroughStorage::duration(2000));
+    storage.Start();
+
+    std::mutex mutex;
+    std::set<std::string> requests;
+    std::vector<std::string> values(16);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 16; i++) {
+        readers.emplace_back([i, &storage, &values, &mutex, &requests] {
+            // Half of readers ask for the same key
+            std::string key = "db_" + std::to_string(i % 2 == 0 ? 0 : i);
+            if (storage.Get(key, values[i])) {
+                std::lock_guard<std::mutex> lock(mutex);
+                requests.insert(values[i].substr(values[i].find('@')));
+            }
+        });
+    }
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    for (int i = 0; i < 16; i++) {
+        std::string key = "db_" + std::to_string(i % 2 == 0 ? 0 : i);
+        EXPECT_EQ(0, values[i].find(key + "@"));
+    }
+    EXPECT_GE(requests.size(), 1);
+    EXPECT_LT(requests.size(), 16);
+    storage.Stop();
+}
+
+TEST(ReadThroughStorageTest, SpawnedLoader) {
+    auto loader = Loader::Spawn("while read -r cmd key; do "
+                                "key=$(printf '%s' \"$key\" | tr -d '\\r'); "
+                                "printf 'VALUE %s 0 2\\r\\nok\\r\\nEND\\r\\n' \"$key\"; "
+                                "done");
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(1024);
+    ReadThroughStorage storage(backend, std::move(loader), 64, ReadThroughStorage::duration(1),
+                               ReadThroughStorage::duration(2000));
+    storage.Start();
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("some", value));
+    EXPECT_EQ("ok", value);
+    storage.Stop();
+}
+
+TEST(ReadThroughStorageTest, LoaderRestartsAfterCrash) {
+    // First process dies right away, the next ones serve requests
+    char marker[] = "/tmp/afina_loader_XXXXXX";
+    int fd = mkstemp(marker);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    unlink(marker);
+
+    auto loader = Loader::Spawn(std::string("if [ ! -e ") + marker + " ]; then touch " + marker + "; exit 1; fi; " +
+                                "while read -r cmd key; do "
+                                "key=$(printf '%s' \"$key\" | tr -d '\\r'); "
+                                "printf 'VALUE %s 0 2\\r\\nok\\r\\nEND\\r\\n' \"$key\"; "
+                                "done");
+
+    std::vector<Loader::Item> out;
+    EXPECT_THROW(loader->Load({"some"}, out), std::runtime_error);
+
+    // No reconnects until the back-off is over
+    EXPECT_THROW(loader->Load({"some"}, out), std::runtime_error);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    ASSERT_NO_THROW(loader->Load({"some"}, out));
+    ASSERT_EQ(1, out.size());
+    EXPECT_EQ("some", out[0].key);
+    EXPECT_EQ("ok", out[0].value);
+    unlink(marker);
+}
+
+TEST(ReadThroughStorageTest, NotStarted) {
+    auto backend = std::make_shared<ThreadSafeSimpleLRU>(1024);
+    ReadThroughStorage storage(backend, StartFakeLoader());
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("db_1", value));
+}
@@ -1,16 +1,24 @@
 #include "gtest/gtest.h"
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <afina/allocator/Arena.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
 
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -201,3 +209,479 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, ItemMetadata) {
+    SimpleLRU storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 42, 0));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    std::string value;
+    Afina::ItemHeader first, second;
+    EXPECT_TRUE(storage.Get("KEY1", value, first));
+    EXPECT_EQ(42, first.flags);
+    EXPECT_EQ(0, first.expire);
+    EXPECT_TRUE(storage.Get("KEY2", value, second));
+    EXPECT_EQ(0, second.flags);
+    EXPECT_NE(first.cas, second.cas);
+
+    // Every update gives item a new cas unique
+    EXPECT_TRUE(storage.Set("KEY1", "val3", 7, 0));
+    Afina::ItemHeader updated;
+    EXPECT_TRUE(storage.Get("KEY1", value, updated));
+    EXPECT_EQ("val3", value);
+    EXPECT_EQ(7, updated.flags);
+    EXPECT_NE(first.cas, updated.cas);
+}
+
+TEST(StorageTest, Expiration) {
+    SimpleLRU storage(100);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, -1));
+    EXPECT_TRUE(storage.Put("KEY2", "val2", 0, 60 * 60 * 24 * 31));
+    EXPECT_TRUE(storage.Put("KEY3", "val3", 0, 1000));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+
+    // Values above 30 days are absolute unix time, that one is long ago
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    // Expired items free their space
+    EXPECT_EQ(8, storage.CurrentSize());
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val4"));
+}
+
+TEST(StorageTest, CompareAndSwap) {
+    SimpleLRU storage;
+
+    EXPECT_EQ(Afina::CasResult::kNotFound, storage.CompareAndSwap("KEY1", "val1", 0, 0, 1));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    std::string value;
+    Afina::ItemHeader header;
+    EXPECT_TRUE(storage.Get("KEY1", value, header));
+    EXPECT_EQ(Afina::CasResult::kStored, storage.CompareAndSwap("KEY1", "val2", 3, 0, header.cas));
+
+    // Old cas unique is not valid anymore
+    EXPECT_EQ(Afina::CasResult::kExists, storage.CompareAndSwap("KEY1", "val3", 0, 0, header.cas));
+    EXPECT_TRUE(storage.Get("KEY1", value, header));
+    EXPECT_EQ("val2", value);
+    EXPECT_EQ(3, header.flags);
+}
+
+TEST(StorageTest, GetsCommand) {
+    SimpleLRU storage;
+
+    std::string out;
+    Set("KEY1", 12, 0).Execute(storage, "val1", out);
+    EXPECT_EQ("STORED", out);
+
+    Afina::ItemHeader header;
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value, header));
+
+    Get({"KEY1"}).Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 12 4\r\nval1\r\nEND", out);
+
+    Get({"KEY1"}, true).Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 12 4 " + std::to_string(header.cas) + "\r\nval1\r\nEND", out);
+
+    Cas("KEY1", 0, 0, header.cas + 1).Execute(storage, "val2", out);
+    EXPECT_EQ("EXISTS", out);
+    Cas("KEY1", 0, 0, header.cas).Execute(storage, "val2", out);
+    EXPECT_EQ("STORED", out);
+    Cas("KEY2", 0, 0, header.cas).Execute(storage, "val2", out);
+    EXPECT_EQ("NOT_FOUND", out);
+}
+
+TEST(StorageTest, CompressedValues) {
+    std::string doc;
+    for (int i = 0; i < 100; i++) {
+        doc += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\"}";
+    }
+
+    SimpleLRU plain(10 * doc.size());
+    SimpleLRU compressed(10 * doc.size(), 64);
+    for (int i = 0; i < 40; i++) {
+        EXPECT_TRUE(plain.Put("KEY" + std::to_string(i), doc));
+        EXPECT_TRUE(compressed.Put("KEY" + std::to_string(i), doc, 5, 0));
+    }
+
+    // Compression multiplies capacity
+    std::string value;
+    EXPECT_FALSE(plain.Get("KEY0", value));
+    Afina::ItemHeader header;
+    EXPECT_TRUE(compressed.Get("KEY0", value, header));
+    EXPECT_EQ(doc, value);
+    EXPECT_EQ(5, header.flags);
+
+    // Small values are stored as is
+    EXPECT_TRUE(compressed.Put("small", "aaaaaaaaaaaaaaaa"));
+    size_t size = compressed.CurrentSize();
+    EXPECT_TRUE(compressed.Delete("small"));
+    EXPECT_EQ(size - 21, compressed.CurrentSize());
+
+    // Values that don't compress are stored as is too, replacing compressed value keeps sizes right
+    std::string noise;
+    for (int i = 0; i < 200; i++) {
+        noise.push_back(char(i * 7919 % 251));
+    }
+    EXPECT_TRUE(compressed.Set("KEY0", noise));
+    EXPECT_TRUE(compressed.Get("KEY0", value));
+    EXPECT_EQ(noise, value);
+    EXPECT_TRUE(compressed.Delete("KEY0"));
+
+    for (int i = 1; i < 40; i++) {
+        EXPECT_TRUE(compressed.Delete("KEY" + std::to_string(i)));
+    }
+    EXPECT_EQ(0, compressed.CurrentSize());
+}
+
+TEST(StorageTest, StatsCommand) {
+    SimpleLRU storage;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    std::string out;
+    Afina::Execute::Stats().Execute(storage, "", out);
+    EXPECT_EQ(0, out.find("STAT curr_items 1\r\nSTAT bytes 8\r\nSTAT limit_maxbytes 1024\r\n"));
+    EXPECT_EQ(out.size() - 3, out.rfind("END"));
+}
+
+TEST(StorageTest, StripedStats) {
+    auto storage = StripedLRU::CreateStorage(4 * 1024 * 1024, 2);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), "val"));
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage->Stats(stats);
+    std::map<std::string, std::string> map(stats.begin(), stats.end());
+    EXPECT_EQ("100", map["curr_items"]);
+    EXPECT_EQ(std::to_string(4 * 1024 * 1024), map["limit_maxbytes"]);
+    EXPECT_EQ("2", map["stripes"]);
+    EXPECT_LT(0, std::stoul(map["total_malloced"]));
+    EXPECT_LE(100, std::stoul(map["slab_used_chunks"]));
+}
+
+TEST(StorageTest, StripedTrimsAllocator) {
+    auto storage = StripedLRU::CreateStorage(4 * 1024 * 1024, 2, 0, std::chrono::milliseconds(10));
+    std::string value(100, 'x');
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), value));
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage->Delete("KEY" + std::to_string(i)));
+    }
+
+    // Freed objects stay in the allocator caches until trimmer gives them back to slabs
+    auto used = [&storage] {
+        std::vector<std::pair<std::string, std::string>> stats;
+        storage->Stats(stats);
+        std::map<std::string, std::string> map(stats.begin(), stats.end());
+        return std::stoul(map["slab_used_chunks"]);
+    };
+    size_t cached = used();
+    EXPECT_LT(1000, cached);
+
+    storage->Start();
+    for (int i = 0; i < 100 && used() == cached; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    storage->Stop();
+    EXPECT_GT(cached / 2, used());
+}
+
+TEST(StorageTest, IndexAllocator) {
+    SimpleLRU storage(1024 * 1024, 0, nullptr, 1024 * 1024);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY500", value));
+    EXPECT_EQ("val", value);
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    std::map<std::string, std::string> map(stats.begin(), stats.end());
+    EXPECT_EQ("1000", map["curr_items"]);
+    EXPECT_LT(0, std::stoul(map["index_malloced"]));
+}
+
+static std::map<std::string, std::string> StatsOf(Afina::Storage &storage) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    return std::map<std::string, std::string>(stats.begin(), stats.end());
+}
+
+// Per class stat of the smallest class holding blocks of the given size
+static size_t ClassStat(Afina::Storage &storage, size_t size, const std::string &name) {
+    auto stats = StatsOf(storage);
+    size_t chunk = 0;
+    std::string prefix;
+    for (auto &stat : stats) {
+        size_t pos = stat.first.find(":chunk_size");
+        size_t value = std::stoul(stat.second);
+        if (pos != std::string::npos && value >= size && (chunk == 0 || value < chunk)) {
+            chunk = value;
+            prefix = stat.first.substr(0, pos + 1);
+        }
+    }
+    auto it = stats.find(prefix + name);
+    return it == stats.end() ? 0 : std::stoul(it->second);
+}
+
+static std::string SmallValue(size_t i) { return std::string(1000, char('a' + i % 26)); }
+
+// Fills the page of 16K values, then makes small values the most recent ones, so that the next big
+// value evicts the oldest big one. Returns number of big values per page
+static size_t PressBigClass(SimpleLRU &storage, const std::vector<size_t> &small) {
+    EXPECT_TRUE(storage.Put("big0", std::string(16000, 'b')));
+    size_t per_page = ClassStat(storage, 16000, "chunks_per_page");
+    for (size_t i = 1; i < per_page; i++) {
+        EXPECT_TRUE(storage.Put("big" + std::to_string(i), std::string(16000, 'b')));
+    }
+    EXPECT_EQ(small.size() + per_page, std::stoul(StatsOf(storage)["curr_items"]));
+
+    std::string value;
+    for (size_t i : small) {
+        EXPECT_TRUE(storage.Get("small" + std::to_string(i), value));
+    }
+    EXPECT_TRUE(storage.Put("big" + std::to_string(per_page), std::string(16000, 'b')));
+    EXPECT_FALSE(storage.Get("big0", value));
+    EXPECT_EQ(1, ClassStat(storage, 16000, "evictions"));
+    return per_page;
+}
+
+// Three pages of small values, only each fourth one stays, so that pages are sparse but none is empty
+static std::vector<size_t> SparseSmallValues(SimpleLRU &storage) {
+    EXPECT_TRUE(storage.Put("small0", SmallValue(0)));
+    size_t count = 3 * ClassStat(storage, 1000, "chunks_per_page");
+    for (size_t i = 1; i < count; i++) {
+        EXPECT_TRUE(storage.Put("small" + std::to_string(i), SmallValue(i)));
+    }
+    EXPECT_EQ(3, ClassStat(storage, 1000, "total_pages"));
+
+    std::vector<size_t> left;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 4 == 0) {
+            left.push_back(i);
+        } else {
+            EXPECT_TRUE(storage.Delete("small" + std::to_string(i)));
+        }
+    }
+    return left;
+}
+
+TEST(StorageTest, SlabStats) {
+    SimpleLRU storage(64 * 1024 * 1024, 0, nullptr, 5 * Afina::Allocator::Arena::kSlabSize);
+    SparseSmallValues(storage);
+
+    // Three quarters of three pages of small values are free
+    auto stats = StatsOf(storage);
+    size_t per_page = ClassStat(storage, 1000, "chunks_per_page");
+    size_t count = 3 * per_page;
+    EXPECT_EQ(count, ClassStat(storage, 1000, "allocs"));
+    EXPECT_EQ(count - (count + 3) / 4, ClassStat(storage, 1000, "frees"));
+    EXPECT_EQ(count - (count + 3) / 4, ClassStat(storage, 1000, "free_chunks"));
+    EXPECT_LT(0.5, std::stod(stats["slab_fragmentation"]));
+    EXPECT_GT(std::stoul(stats["slab_free_bytes"]), std::stoul(stats["slab_used_bytes"]));
+}
+
+TEST(StorageTest, AppendInPlace) {
+    SimpleLRU storage(1024 * 1024);
+
+    std::string out;
+    Append("log", 0, 0).Execute(storage, "line", out);
+    EXPECT_EQ("NOT_STORED", out);
+
+    Set("log", 7, 0).Execute(storage, "", out);
+    Afina::ItemHeader before;
+    std::string value;
+    EXPECT_TRUE(storage.Get("log", value, before));
+
+    std::string expected;
+    for (int i = 0; i < 2000; i++) {
+        std::string line = "line" + std::to_string(i) + "\n";
+        Append("log", 0, 0).Execute(storage, line, out);
+        EXPECT_EQ("STORED", out);
+        expected += line;
+    }
+
+    // Item keeps its flags, gets new cas unique, sizes are accounted
+    Afina::ItemHeader after;
+    EXPECT_TRUE(storage.Get("log", value, after));
+    EXPECT_EQ(expected, value);
+    EXPECT_EQ(7, after.flags);
+    EXPECT_NE(before.cas, after.cas);
+    EXPECT_EQ(3 + expected.size(), storage.CurrentSize());
+
+    // Value moves only when it outgrows its block, each time to the block half as big again
+    size_t allocs = 0;
+    for (auto &stat : StatsOf(storage)) {
+        if (stat.first.find(":allocs") != std::string::npos) {
+            allocs += std::stoul(stat.second);
+        }
+    }
+    EXPECT_LT(allocs, 30);
+}
+
+TEST(StorageTest, AppendCompressed) {
+    SimpleLRU storage(1024 * 1024, 64);
+
+    std::string doc(200, 'a');
+    EXPECT_FALSE(storage.Append("doc", "b"));
+    EXPECT_TRUE(storage.Put("doc", doc, 3, 0));
+    EXPECT_TRUE(storage.Append("doc", "bbbb"));
+
+    std::string value;
+    Afina::ItemHeader header;
+    EXPECT_TRUE(storage.Get("doc", value, header));
+    EXPECT_EQ(doc + "bbbb", value);
+    EXPECT_EQ(3, header.flags);
+
+    // Result must fit into the cache
+    SimpleLRU small(16);
+    EXPECT_TRUE(small.Put("k", "0123456789"));
+    EXPECT_FALSE(small.Append("k", "0123456789"));
+    EXPECT_TRUE(small.Get("k", value));
+    EXPECT_EQ("0123456789", value);
+}
+
+TEST(StorageTest, SlabMoveRelocates) {
+    // Small values, nodes and big values take a page each, one more for the small ones
+    SimpleLRU storage(64 * 1024 * 1024, 0, nullptr, 5 * Afina::Allocator::Arena::kSlabSize);
+    std::vector<size_t> small = SparseSmallValues(storage);
+    size_t per_page = PressBigClass(storage, small);
+
+    EXPECT_TRUE(storage.MoveSlab());
+    EXPECT_EQ("1", StatsOf(storage)["slabs_moved"]);
+    EXPECT_EQ(2, ClassStat(storage, 1000, "total_pages"));
+
+    // Items of the moved page are in the other pages now
+    std::string value;
+    for (size_t i : small) {
+        EXPECT_TRUE(storage.Get("small" + std::to_string(i), value));
+        EXPECT_EQ(SmallValue(i), value);
+    }
+
+    // Page is used by big values, without evictions
+    size_t items = std::stoul(StatsOf(storage)["curr_items"]);
+    for (size_t i = 0; i < per_page; i++) {
+        EXPECT_TRUE(storage.Put("more" + std::to_string(i), std::string(16000, 'm')));
+    }
+    EXPECT_EQ(items + per_page, std::stoul(StatsOf(storage)["curr_items"]));
+    EXPECT_EQ(2, ClassStat(storage, 16000, "total_pages"));
+    EXPECT_EQ(1, ClassStat(storage, 16000, "evictions"));
+
+    // No pressure since the last move
+    EXPECT_FALSE(storage.MoveSlab());
+}
+
+TEST(StorageTest, SlabMoveSteps) {
+    SimpleLRU storage(64 * 1024 * 1024, 0, nullptr, 5 * Afina::Allocator::Arena::kSlabSize);
+    std::vector<size_t> small = SparseSmallValues(storage);
+    PressBigClass(storage, small);
+
+    // Cache is in use between the steps: items are read, replaced and deleted
+    size_t steps = 0;
+    std::string value;
+    std::vector<size_t> left;
+    while (storage.MoveSlabStep(4096)) {
+        size_t i = small[steps % small.size()];
+        EXPECT_TRUE(storage.Get("small" + std::to_string(i), value));
+        EXPECT_TRUE(storage.Set("small" + std::to_string(i), SmallValue(i + 1)));
+        steps++;
+    }
+    EXPECT_GT(steps, 1);
+    EXPECT_EQ("1", StatsOf(storage)["slabs_moved"]);
+    EXPECT_EQ(2, ClassStat(storage, 1000, "total_pages"));
+
+    for (size_t n = 0; n < small.size(); n++) {
+        size_t i = small[n];
+        EXPECT_TRUE(storage.Get("small" + std::to_string(i), value));
+        EXPECT_EQ(n < steps ? SmallValue(i + 1) : SmallValue(i), value);
+    }
+}
+
+TEST(StorageTest, SlabMoveEvicts) {
+    SimpleLRU storage(64 * 1024 * 1024, 0, nullptr, 4 * Afina::Allocator::Arena::kSlabSize);
+
+    // Page and a half of small values, there is no room to move them
+    EXPECT_TRUE(storage.Put("small0", SmallValue(0)));
+    size_t per_page = ClassStat(storage, 1000, "chunks_per_page");
+    std::vector<size_t> small = {0};
+    for (size_t i = 1; i < per_page + per_page / 2; i++) {
+        EXPECT_TRUE(storage.Put("small" + std::to_string(i), SmallValue(i)));
+        small.push_back(i);
+    }
+    size_t big_per_page = PressBigClass(storage, small);
+
+    // Sparsest page is the second one, its items are gone
+    EXPECT_TRUE(storage.MoveSlab());
+    EXPECT_EQ(1, ClassStat(storage, 1000, "total_pages"));
+    EXPECT_EQ(per_page + big_per_page, std::stoul(StatsOf(storage)["curr_items"]));
+
+    std::string value;
+    for (size_t i : small) {
+        EXPECT_EQ(i < per_page, storage.Get("small" + std::to_string(i), value));
+    }
+}
+
+TEST(StorageTest, SlabMoverThread) {
+    ThreadSafeSimpleLRU storage(64 * 1024 * 1024, 0, 5 * Afina::Allocator::Arena::kSlabSize,
+                                std::chrono::milliseconds(10));
+    std::vector<size_t> small = SparseSmallValues(storage);
+    PressBigClass(storage, small);
+
+    storage.Start();
+    for (int i = 0; i < 500 && StatsOf(storage)["slabs_moved"] != "1"; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    storage.Stop();
+
+    EXPECT_EQ("1", StatsOf(storage)["slabs_moved"]);
+    EXPECT_EQ(2, ClassStat(storage, 1000, "total_pages"));
+}
+
+TEST(StorageTest, SlabMoveRelocatesNodes) {
+    SimpleLRU storage(64 * 1024 * 1024, 0, nullptr, 5 * Afina::Allocator::Arena::kSlabSize);
+
+    // Values are tiny, so it is nodes taking the pages: one page of values and three of nodes
+    size_t count = 0;
+    while (std::stoul(StatsOf(storage)["total_malloced"]) < 4 * Afina::Allocator::Arena::kSlabSize) {
+        EXPECT_TRUE(storage.Put("small" + std::to_string(count), std::to_string(count)));
+        count++;
+    }
+    std::vector<size_t> small;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 4 == 0) {
+            small.push_back(i);
+        } else {
+            EXPECT_TRUE(storage.Delete("small" + std::to_string(i)));
+        }
+    }
+    PressBigClass(storage, small);
+    size_t size = storage.CurrentSize();
+
+    EXPECT_TRUE(storage.MoveSlab());
+    EXPECT_EQ(size, storage.CurrentSize());
+
+    // Moved nodes keep their place in the list: old big items, small ones and the last big one
+    std::string value;
+    size_t big = std::stoul(StatsOf(storage)["curr_items"]) - small.size();
+    for (size_t i = 1; i < big; i++) {
+        EXPECT_TRUE(storage.EvictOne());
+    }
+    for (size_t i : small) {
+        EXPECT_TRUE(storage.Get("small" + std::to_string(i), value));
+        EXPECT_EQ(std::to_string(i), value);
+    }
+    for (size_t i = 0; i <= small.size(); i++) {
+        EXPECT_TRUE(storage.EvictOne());
+    }
+    EXPECT_FALSE(storage.EvictOne());
+    EXPECT_EQ(0, storage.CurrentSize());
+}
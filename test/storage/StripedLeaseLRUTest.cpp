@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+
+#include "storage/StripedLeaseLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+using Lease = StripedLeaseLRU::Lease;
+
+static const size_t kCapacity = 4 * 1024 * 1024;
+
+TEST(StripedLeaseLRUTest, HitDoesNotLease) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2);
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+
+    std::string value;
+    uint64_t token = 0;
+    EXPECT_EQ(Lease::kHit, storage->GetOrLease("KEY1", value, token));
+    EXPECT_EQ("val1", value);
+    EXPECT_EQ(0, token);
+}
+
+TEST(StripedLeaseLRUTest, SingleFillPerKey) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2, StripedLeaseLRU::duration(5000));
+
+    std::string value;
+    uint64_t token = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    ASSERT_NE(0, token);
+
+    std::atomic<int> fills(0), hits(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 8; i++) {
+        readers.emplace_back([&storage, &fills, &hits] {
+            std::string v;
+            uint64_t t = 0;
+            Lease r = storage->GetOrLease("KEY1", v, t);
+            if (r == Lease::kFill) {
+                fills++;
+            } else if (r == Lease::kHit && v == "filled") {
+                hits++;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(storage->Fill("KEY1", "filled", token));
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(0, fills.load());
+    EXPECT_EQ(8, hits.load());
+}
+
+TEST(StripedLeaseLRUTest, StaleCopyAfterDelete) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2);
+    EXPECT_TRUE(storage->Put("KEY1", "old"));
+    EXPECT_TRUE(storage->Delete("KEY1"));
+
+    std::string value;
+    EXPECT_FALSE(storage->Get("KEY1", value));
+
+    uint64_t token = 0, other = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    EXPECT_EQ(Lease::kStale, storage->GetOrLease("KEY1", value, other));
+    EXPECT_EQ("old", value);
+
+    EXPECT_TRUE(storage->Put("KEY1", "new"));
+    EXPECT_EQ(Lease::kHit, storage->GetOrLease("KEY1", value, token));
+    EXPECT_EQ("new", value);
+}
+
+TEST(StripedLeaseLRUTest, StaleCopyAfterExpire) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2);
+    EXPECT_TRUE(storage->Put("KEY1", "old", 7, -1));
+
+    std::string value;
+    EXPECT_FALSE(storage->Get("KEY1", value));
+
+    uint64_t token = 0, other = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    EXPECT_EQ(Lease::kStale, storage->GetOrLease("KEY1", value, other));
+    EXPECT_EQ("old", value);
+}
+
+TEST(StripedLeaseLRUTest, StaleCopyAfterEvict) {
+    // Single stripe, live part holds 7/8 of it, so the 14th value evicts just the first one
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 1);
+    std::string big(kCapacity / 16, 'x');
+    for (int i = 0; i < 14; i++) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), big));
+    }
+
+    std::string value;
+    EXPECT_FALSE(storage->Get("KEY0", value));
+    uint64_t token = 0, other = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY0", value, token));
+    EXPECT_EQ(Lease::kStale, storage->GetOrLease("KEY0", value, other));
+    EXPECT_TRUE(value == big);
+}
+
+TEST(StripedLeaseLRUTest, FillRejectsInvalidToken) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2);
+
+    std::string value;
+    uint64_t token = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    EXPECT_FALSE(storage->Fill("KEY1", "val", token + 1));
+
+    // Direct write supersedes lease
+    EXPECT_TRUE(storage->Put("KEY1", "direct"));
+    EXPECT_FALSE(storage->Fill("KEY1", "val", token));
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("direct", value);
+}
+
+TEST(StripedLeaseLRUTest, ReleaseAndExpire) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2, StripedLeaseLRU::duration(10),
+                                                  StripedLeaseLRU::duration(30));
+
+    std::string value;
+    uint64_t token = 0, other = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    EXPECT_EQ(Lease::kMiss, storage->GetOrLease("KEY1", value, other));
+
+    storage->Release("KEY1", token);
+    EXPECT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, other));
+    EXPECT_NE(token, other);
+
+    // Holder never returns, next miss must take over
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+    EXPECT_FALSE(storage->Fill("KEY1", "late", other));
+    EXPECT_TRUE(storage->Fill("KEY1", "value", token));
+}
+
+TEST(StripedLeaseLRUTest, PlainGetIgnoresLeases) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2, StripedLeaseLRU::duration(500));
+
+    // Miss of the plain Get doesn't take lease
+    std::string value;
+    EXPECT_FALSE(storage->Get("KEY1", value));
+    uint64_t token = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY1", value, token));
+
+    // And doesn't wait for the lease holder either
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(storage->Get("KEY1", value));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(250));
+}
+
+TEST(StripedLeaseLRUTest, Stats) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2);
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
+    EXPECT_TRUE(storage->Delete("KEY2"));
+    std::string value;
+    uint64_t token = 0;
+    ASSERT_EQ(Lease::kFill, storage->GetOrLease("KEY3", value, token));
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage->Stats(stats);
+    std::map<std::string, std::string> map(stats.begin(), stats.end());
+    EXPECT_EQ("1", map["curr_items"]);
+    EXPECT_EQ("8", map["bytes"]);
+    EXPECT_EQ("1", map["stale_curr_items"]);
+    EXPECT_EQ("1", map["leases"]);
+    EXPECT_EQ("2", map["stripes"]);
+}
+
+TEST(StripedLeaseLRUTest, GetCommandTakesLease) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2, StripedLeaseLRU::duration(5000));
+    EXPECT_TRUE(storage->Put("KEY1", "old", 3, 0));
+    EXPECT_TRUE(storage->Delete("KEY1"));
+
+    // First client misses and is expected to set the key, the next one is served the stale copy meanwhile
+    std::string out;
+    Afina::Execute::Get({"KEY1"}).Execute(*storage, "", out);
+    EXPECT_EQ("END", out);
+    Afina::Execute::Get({"KEY1"}).Execute(*storage, "", out);
+    EXPECT_EQ("VALUE KEY1 3 3\r\nold\r\nEND", out);
+
+    // Set of the first client completes the lease
+    Afina::Execute::Set("KEY1", 3, 0).Execute(*storage, "new", out);
+    Afina::Execute::Get({"KEY1"}).Execute(*storage, "", out);
+    EXPECT_EQ("VALUE KEY1 3 3\r\nnew\r\nEND", out);
+}
+
+TEST(StripedLeaseLRUTest, GetCommandWaitsForFill) {
+    auto storage = StripedLeaseLRU::CreateStorage(kCapacity, 2, StripedLeaseLRU::duration(5000));
+
+    std::string first;
+    Afina::Execute::Get({"KEY1"}).Execute(*storage, "", first);
+    EXPECT_EQ("END", first);
+
+    // No stale copy: the second client waits for the first one to set the key
+    std::string second;
+    std::thread waiter([&storage, &second] { Afina::Execute::Get({"KEY1"}).Execute(*storage, "", second); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(storage->Put("KEY1", "value"));
+    waiter.join();
+    EXPECT_EQ("VALUE KEY1 0 5\r\nvalue\r\nEND", second);
+}